@@ -45,7 +45,10 @@ namespace tango_augmented_reality {
 
     }
 
-    PointCloudRenderer::PointCloudRenderer() : debug_colors_(true) {
+    PointCloudRenderer::PointCloudRenderer() : debug_colors_(true),
+                                               vertex_buffer_size_(0),
+                                               uploaded_timestamp_(-1.0),
+                                               uploaded_vertices_(0) {
         opengl_world_T_start_service_ =
                 tango_gl::conversions::opengl_world_T_tango_world();
 
@@ -62,7 +65,7 @@ namespace tango_augmented_reality {
 
     PointCloudRenderer::~PointCloudRenderer() {
         glDeleteProgram(shader_program_);
-        glDeleteBuffers(0, &vertex_buffer_);
+        glDeleteBuffers(1, &vertex_buffer_);
     }
 
     void PointCloudRenderer::Render(const glm::mat4 &projection_T_depth,
@@ -75,11 +78,20 @@ namespace tango_augmented_reality {
 
         glUseProgram(shader_program_);
 
-        const size_t number_of_vertices = point_cloud->xyz_count;
-
         glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 3 * number_of_vertices,
-                     point_cloud->xyz[0], GL_STATIC_DRAW);
+        if (point_cloud->timestamp != uploaded_timestamp_) {
+            // stream the new depth frame, orphaning the old storage avoids a stall on
+            // draws which still read the last frame
+            const GLsizeiptr size = sizeof(GLfloat) * 3 * point_cloud->xyz_count;
+            if (size > vertex_buffer_size_) {
+                vertex_buffer_size_ = size;
+            }
+            glBufferData(GL_ARRAY_BUFFER, vertex_buffer_size_, nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, size, point_cloud->xyz[0]);
+            uploaded_timestamp_ = point_cloud->timestamp;
+            uploaded_vertices_ = point_cloud->xyz_count;
+        }
+        const size_t number_of_vertices = uploaded_vertices_;
 
         const glm::mat4 depth_T_opengl =
                 glm::inverse(opengl_world_T_start_service_ * start_service_T_depth);
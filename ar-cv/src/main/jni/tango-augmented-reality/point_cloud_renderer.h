@@ -52,6 +52,14 @@ class PointCloudRenderer {
   GLuint shader_program_;
   GLuint vertex_buffer_;
   GLuint mvp_handle_;
+
+  // Size of the vertex buffer storage in bytes.
+  GLsizeiptr vertex_buffer_size_;
+
+  // Timestamp and size of the point cloud currently held by vertex_buffer_,
+  // the buffer is only streamed again if a new depth frame arrives.
+  double uploaded_timestamp_;
+  size_t uploaded_vertices_;
   GLuint vertices_handle_;
 
   // Controls coloring of point data.
@@ -30,4 +30,41 @@ public class JNIInterface {
 
     public static native float[] reconstructPiecewisePlanes(float[] vertices);
 
+    // clusters, RANSAC planes, k-means regions and hull polygons like the construct
+    // app's ReconstructionBuilder, without PCL
+    public static native float[] reconstructPlanar(float[] vertices);
+
+    // cluster index of every point, k-means with k clusters, seeded with seed and
+    // stopped after maxIterations, the same seed gives the same clusters
+    public static native int[] clusterKMeans(float[] vertices, int k, int maxIterations, int seed);
+
+    // cluster index of every point, clusters with centroids closer than
+    // maxDistance are merged
+    public static native int[] clusterAgglomerative(float[] vertices, float maxDistance);
+
+    // marching cubes over the voxels of size voxelSize which contain a point, the
+    // native version of the MarchingCubeTree
+    public static native float[] reconstructMarchingCubes(float[] vertices, float voxelSize);
+
+    // constrained Delaunay triangulation of x, y polygons, each polygon has
+    // ringsPerPolygon rings of ringSizes points, the first ring is the outline and
+    // the others are holes. Returns three indices into points per triangle.
+    public static native int[] triangulatePolygons(float[] points, int[] ringSizes, int[] ringsPerPolygon);
+
+    // merges a frame of world space points into the native voxel grid
+    public static native void accumulatePoints(float[] vertices);
+
+    public static native void clearAccumulatedPoints();
+
+    // reconstruct from the native voxel grid instead of a full point array
+    public static native float[] reconstructAccumulatedWithGreedy();
+
+    public static native float[] reconstructAccumulatedPiecewisePlanes();
+
+    // re-mesh only the regions of the voxel grid which changed, on by default
+    public static native void setIncrementalTriangulation(boolean incremental);
+
+    // 1 estimates normals sequentially, 0 uses all cores which is the default
+    public static native void setNormalEstimationThreads(int threads);
+
 }
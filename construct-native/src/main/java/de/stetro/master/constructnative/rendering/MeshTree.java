@@ -2,11 +2,6 @@ package de.stetro.master.constructnative.rendering;
 
 import android.util.Log;
 
-import org.poly2tri.Poly2Tri;
-import org.poly2tri.triangulation.TriangulationPoint;
-import org.poly2tri.triangulation.delaunay.DelaunayTriangle;
-import org.poly2tri.triangulation.point.TPoint;
-import org.poly2tri.triangulation.sets.PointSet;
 import org.rajawali3d.math.vector.Vector3;
 
 import java.util.ArrayList;
@@ -35,6 +30,11 @@ public class MeshTree extends OctTree {
     private List<Vector3> newPoints;
     private int generatorDepth;
     private List<Vector3> patches;
+    // true if the leaf got points since its boundaries were last accumulated
+    private boolean changed;
+    // patches are meshed from the native voxel grid, which only gets the
+    // boundaries of changed leaves, instead of all boundaries of the tree
+    private boolean accumulatePatches = true;
 
     public MeshTree(Vector3 position, double range, int depth, int generatorDepth) {
         super(position, range, depth);
@@ -63,6 +63,7 @@ public class MeshTree extends OctTree {
         if (depth == generatorDepth) {
             for (Vector3 point : points) {
                 if (inside(point)) {
+                    changed = true;
                     Plane plane = getSupportedPlane(point);
                     if (plane == null) {
                         this.newPoints.add(point);
@@ -128,18 +129,24 @@ public class MeshTree extends OctTree {
     }
 
     public void updateMesh() {
+        HullBatch batch = new HullBatch();
+        collectHulls(batch);
+        batch.triangulate();
+    }
+
+    private void collectHulls(HullBatch batch) {
         if (depth == generatorDepth) {
-            calculatePolygons();
+            calculatePolygons(batch);
         } else {
             for (OctTree child : children) {
                 if (child != null) {
-                    ((MeshTree) child).updateMesh();
+                    ((MeshTree) child).collectHulls(batch);
                 }
             }
         }
     }
 
-    private void calculatePolygons() {
+    private void calculatePolygons(HullBatch batch) {
 
         polygons.clear();
         for (int i = 0; i < DETECTED_PLANES; i++) {
@@ -173,26 +180,15 @@ public class MeshTree extends OctTree {
                 innerHullPoints[j] = planes[i].transferTo2D(relevantPoints.get(j));
             }
             GrahamScan scan = new GrahamScan(innerHullPoints);
-            // create DelaunayTriangle from convex hull
-            List<TriangulationPoint> hullPoints = new ArrayList<>();
+            // the convex hull is triangulated natively with all hulls of the frame
             Stack<Point2D> hull = scan.hull();
             planes[i].getPoints().clear();
             for (Point2D point2D : hull) {
                 Vector3 vector3 = planes[i].transferTo3D(point2D);
                 planes[i].addPoint(vector3);
-                hullPoints.add(new TPoint(vector3.x, vector3.y, vector3.z));
-            }
-            PointSet ps = new PointSet(hullPoints);
-            try {
-                Poly2Tri.triangulate(ps);
-                for (DelaunayTriangle delaunayTriangle : ps.getTriangles()) {
-                    polygons.add(new Vector3(delaunayTriangle.points[0].getX(), delaunayTriangle.points[0].getY(), delaunayTriangle.points[0].getZ()));
-                    polygons.add(new Vector3(delaunayTriangle.points[1].getX(), delaunayTriangle.points[1].getY(), delaunayTriangle.points[1].getZ()));
-                    polygons.add(new Vector3(delaunayTriangle.points[2].getX(), delaunayTriangle.points[2].getY(), delaunayTriangle.points[2].getZ()));
-                }
-            } catch (NullPointerException ignored) {
-                Log.e(tag, "failed with triangulate with " + hull.size() + " hull points");
+                batch.addPoint(point2D, vector3);
             }
+            batch.endHull(this);
         }
         newPoints.clear();
     }
@@ -202,6 +198,7 @@ public class MeshTree extends OctTree {
             polygons.clear();
             newPoints.clear();
             planes = new Plane[DETECTED_PLANES];
+            changed = false;
         } else {
             for (OctTree child : children) {
                 if (child != null) {
@@ -211,6 +208,9 @@ public class MeshTree extends OctTree {
         }
         if (patches != null) {
             patches = null;
+            if (accumulatePatches) {
+                JNIInterface.clearAccumulatedPoints();
+            }
         }
     }
 
@@ -224,6 +224,7 @@ public class MeshTree extends OctTree {
         if (depth == generatorDepth) {
             Vector3 scaled = scale(point, centroid, SCALE_FACTOR);
             this.newPoints.add(scaled);
+            changed = true;
         } else {
             if (point.x < position.x + halfRange) {
                 if (point.y < position.y + halfRange) {
@@ -278,10 +279,12 @@ public class MeshTree extends OctTree {
         }
     }
 
+    // meshes patches between the plane boundaries, must be called on the root
     public void reconstructPatches() {
         List<Vector3> boundaries = new ArrayList<>();
-        collectPlaneBoundaries(boundaries);
-        if (boundaries.size() < 3) {
+        collectPlaneBoundaries(boundaries, accumulatePatches);
+        // without changed leaves the accumulated patches stay the same
+        if (accumulatePatches ? boundaries.isEmpty() : boundaries.size() < 3) {
             return;
         }
         float[] points = new float[boundaries.size() * 3];
@@ -291,7 +294,15 @@ public class MeshTree extends OctTree {
             points[i * 3 + 1] = (float) vector3.y;
             points[i * 3 + 2] = (float) vector3.z;
         }
-        float[] floats = JNIInterface.reconstructWithGreedy(points);
+        float[] floats;
+        if (accumulatePatches) {
+            // the grid keeps the boundaries of earlier rounds, the native side
+            // re-meshes only the voxels they changed
+            JNIInterface.accumulatePoints(points);
+            floats = JNIInterface.reconstructAccumulatedWithGreedy();
+        } else {
+            floats = JNIInterface.reconstructWithGreedy(points);
+        }
         if (patches == null) {
             patches = new ArrayList<>();
         } else {
@@ -302,8 +313,12 @@ public class MeshTree extends OctTree {
         }
     }
 
-    private void collectPlaneBoundaries(List<Vector3> boundaries) {
+    private void collectPlaneBoundaries(List<Vector3> boundaries, boolean onlyChanged) {
         if (depth == generatorDepth) {
+            if (onlyChanged && !changed) {
+                return;
+            }
+            changed = false;
             for (Plane plane : planes) {
                 if (plane != null) {
                     boundaries.addAll(plane.getPoints());
@@ -312,7 +327,30 @@ public class MeshTree extends OctTree {
         } else {
             for (OctTree child : children) {
                 if (child != null) {
-                    ((MeshTree) child).collectPlaneBoundaries(boundaries);
+                    ((MeshTree) child).collectPlaneBoundaries(boundaries, onlyChanged);
+                }
+            }
+        }
+    }
+
+    // switches between meshing the patches from the native voxel grid and from
+    // all boundaries of the tree, must be called on the root
+    public void setAccumulatePatches(boolean accumulatePatches) {
+        if (this.accumulatePatches != accumulatePatches) {
+            JNIInterface.clearAccumulatedPoints();
+            markChanged();
+        }
+        this.accumulatePatches = accumulatePatches;
+    }
+
+    // lets the next accumulation take the boundaries of every leaf again
+    private void markChanged() {
+        if (depth == generatorDepth) {
+            changed = true;
+        } else {
+            for (OctTree child : children) {
+                if (child != null) {
+                    ((MeshTree) child).markChanged();
                 }
             }
         }
@@ -321,4 +359,57 @@ public class MeshTree extends OctTree {
     public List<Vector3> getPatches() {
         return patches;
     }
+
+    // convex hulls of the planes of all leaves in plane coordinates, one native
+    // call triangulates them all instead of one call per plane
+    private static class HullBatch {
+        private final List<Point2D> points = new ArrayList<>();
+        private final List<Vector3> vertices = new ArrayList<>();
+        private final List<Integer> ringSizes = new ArrayList<>();
+        private final List<MeshTree> leaves = new ArrayList<>();
+        private int hullStart;
+
+        void addPoint(Point2D point, Vector3 vertex) {
+            points.add(point);
+            vertices.add(vertex);
+        }
+
+        // the points since the last hull form a hull of leaf
+        void endHull(MeshTree leaf) {
+            ringSizes.add(points.size() - hullStart);
+            leaves.add(leaf);
+            hullStart = points.size();
+        }
+
+        // adds the triangles of every hull to the polygons of its leaf
+        void triangulate() {
+            if (leaves.isEmpty()) {
+                return;
+            }
+            float[] coordinates = new float[points.size() * 2];
+            int[] hullOfPoint = new int[points.size()];
+            int[] sizes = new int[ringSizes.size()];
+            int[] ringsPerPolygon = new int[ringSizes.size()];
+            for (int hull = 0, point = 0; hull < sizes.length; hull++) {
+                sizes[hull] = ringSizes.get(hull);
+                ringsPerPolygon[hull] = 1;
+                for (int j = 0; j < sizes[hull]; j++, point++) {
+                    coordinates[point * 2] = (float) points.get(point).x();
+                    coordinates[point * 2 + 1] = (float) points.get(point).y();
+                    hullOfPoint[point] = hull;
+                }
+            }
+            int[] triangles = JNIInterface.triangulatePolygons(coordinates, sizes, ringsPerPolygon);
+            boolean[] triangulated = new boolean[sizes.length];
+            for (int index : triangles) {
+                triangulated[hullOfPoint[index]] = true;
+                leaves.get(hullOfPoint[index]).polygons.add(new Vector3(vertices.get(index)));
+            }
+            for (int hull = 0; hull < sizes.length; hull++) {
+                if (!triangulated[hull]) {
+                    Log.e(tag, "failed with triangulate with " + sizes[hull] + " hull points");
+                }
+            }
+        }
+    }
 }
@@ -74,7 +74,13 @@ LOCAL_SHARED_LIBRARIES   += boost_date_time boost_iostreams boost_regex boost_sy
 LOCAL_SHARED_LIBRARIES   += flann flann_cpp
 
 LOCAL_SRC_FILES := jni_interface.cc \
-                   constructnative.cc
+                   constructnative.cc \
+                   voxelaccumulator.cc \
+                   incrementaltriangulation.cc \
+                   planarreconstruction.cc \
+                   clustering.cc \
+                   marchingcubes.cc \
+                   polygontriangulation.cc
 
 
 LOCAL_LDLIBS := -lstdc++ -lc -lm -llog -landroid -ldl -lGLESv2 -lEGL \
@@ -84,7 +90,8 @@ LOCAL_LDLIBS := -lstdc++ -lc -lm -llog -landroid -ldl -lGLESv2 -lEGL \
                 -lflann -lflann_cpp
 
 
-LOCAL_CFLAGS += -mfloat-abi=softfp -mfpu=neon -march=armv7 -mthumb -O3
+LOCAL_CFLAGS += -mfloat-abi=softfp -mfpu=neon -march=armv7 -mthumb -O3 -fopenmp
+LOCAL_LDFLAGS += -fopenmp
 
 include $(BUILD_SHARED_LIBRARY)
 
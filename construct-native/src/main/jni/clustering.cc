@@ -0,0 +1,392 @@
+//
+// k-means and agglomerative clustering of flat x, y, z float buffers.
+//
+#include "clustering.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <random>
+#include <unordered_map>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "voxelaccumulator.h"
+
+namespace {
+    using constructnative::VoxelKey;
+    using constructnative::VoxelKeyHasher;
+
+    // position of the padding centroids, no point is ever closer to them
+    const float kFarAway = 1e18f;
+    // below this many points the threads cost more than they save
+    const int kMinParallelPoints = 4096;
+
+    float squaredDistance(const float *a, const float *b) {
+        float dx = a[0] - b[0];
+        float dy = a[1] - b[1];
+        float dz = a[2] - b[2];
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    // centroids as structure of arrays, padded to a multiple of four
+    struct CentroidLanes {
+        int padded;
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+
+        explicit CentroidLanes(int count) :
+                padded((count + 3) & ~3),
+                x(padded, kFarAway),
+                y(padded, kFarAway),
+                z(padded, kFarAway) {
+        }
+
+        void set(int index, const float *centroid) {
+            x[index] = centroid[0];
+            y[index] = centroid[1];
+            z[index] = centroid[2];
+        }
+    };
+
+    // squared distances of a point to all centroids including the padding
+    void squaredDistances(const float *point, const CentroidLanes &lanes, float *distances) {
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+        float32x4_t px = vdupq_n_f32(point[0]);
+        float32x4_t py = vdupq_n_f32(point[1]);
+        float32x4_t pz = vdupq_n_f32(point[2]);
+        for (int j = 0; j < lanes.padded; j += 4) {
+            float32x4_t dx = vsubq_f32(vld1q_f32(&lanes.x[j]), px);
+            float32x4_t dy = vsubq_f32(vld1q_f32(&lanes.y[j]), py);
+            float32x4_t dz = vsubq_f32(vld1q_f32(&lanes.z[j]), pz);
+            float32x4_t distance = vmulq_f32(dx, dx);
+            distance = vmlaq_f32(distance, dy, dy);
+            distance = vmlaq_f32(distance, dz, dz);
+            vst1q_f32(distances + j, distance);
+        }
+#else
+        for (int j = 0; j < lanes.padded; ++j) {
+            float dx = lanes.x[j] - point[0];
+            float dy = lanes.y[j] - point[1];
+            float dz = lanes.z[j] - point[2];
+            distances[j] = dx * dx + dy * dy + dz * dz;
+        }
+#endif
+    }
+
+    // k-means++, every further centroid is drawn with a probability proportional
+    // to the squared distance to the closest centroid so far
+    void seedCentroids(const float *points, int count, int k, std::minstd_rand &random,
+                       std::vector<float> &centroids) {
+        centroids.resize(k * 3);
+        int index = std::uniform_int_distribution<int>(0, count - 1)(random);
+        std::copy(points + index * 3, points + index * 3 + 3, centroids.begin());
+
+        std::vector<float> closest(count);
+        double total = 0;
+        for (int i = 0; i < count; ++i) {
+            closest[i] = squaredDistance(points + i * 3, &centroids[0]);
+            total += closest[i];
+        }
+        for (int j = 1; j < k; ++j) {
+            double target = std::uniform_real_distribution<double>(0, total)(random);
+            index = count - 1;
+            for (int i = 0; i < count; ++i) {
+                target -= closest[i];
+                if (target <= 0) {
+                    index = i;
+                    break;
+                }
+            }
+            std::copy(points + index * 3, points + index * 3 + 3, centroids.begin() + j * 3);
+            total = 0;
+            for (int i = 0; i < count; ++i) {
+                closest[i] = std::min(closest[i], squaredDistance(points + i * 3, &centroids[j * 3]));
+                total += closest[i];
+            }
+        }
+    }
+
+    // pair of clusters which may be merged, the versions detect outdated pairs
+    struct MergeCandidate {
+        float distance;
+        int a;
+        int b;
+        int versionA;
+        int versionB;
+
+        bool operator>(const MergeCandidate &other) const {
+            return distance > other.distance;
+        }
+    };
+
+    struct Cluster {
+        float centroid[3];
+        int size;
+        int version;
+        VoxelKey cell;
+    };
+}
+
+namespace constructnative {
+
+    int kMeansClustering(const float *points, int count, int k, int maxIterations,
+                         unsigned int seed, std::vector<int> &labels,
+                         std::vector<float> &centroids) {
+        labels.assign(count, 0);
+        centroids.clear();
+        k = std::min(k, count);
+        if (k <= 0) {
+            return 0;
+        }
+        std::minstd_rand random(seed);
+        seedCentroids(points, count, k, random, centroids);
+        CentroidLanes lanes(k);
+        for (int j = 0; j < k; ++j) {
+            lanes.set(j, &centroids[j * 3]);
+        }
+
+        // upper bound of the distance to the own centroid, lower bound of the
+        // distance to every other centroid
+        std::vector<float> upper(count), lower(count);
+        // half the distance of a centroid to its closest other centroid
+        std::vector<float> halfGap(k);
+        std::vector<double> sums(k * 3);
+        std::vector<int> sizes(k);
+        std::vector<float> moved(k);
+
+        int iteration = 0;
+        for (; iteration < maxIterations; ++iteration) {
+            for (int j = 0; j < k; ++j) {
+                float gap = kFarAway;
+                for (int other = 0; other < k; ++other) {
+                    if (other != j) {
+                        gap = std::min(gap, squaredDistance(&centroids[j * 3], &centroids[other * 3]));
+                    }
+                }
+                halfGap[j] = 0.5f * std::sqrt(gap);
+            }
+
+            int changed = 0;
+#pragma omp parallel if (count >= kMinParallelPoints)
+            {
+                std::vector<float> distances(lanes.padded);
+#pragma omp for reduction(+:changed) schedule(static)
+                for (int i = 0; i < count; ++i) {
+                    const float *point = points + i * 3;
+                    int label = labels[i];
+                    if (iteration > 0) {
+                        // no other centroid can be closer than the own one
+                        float bound = std::max(halfGap[label], lower[i]);
+                        if (upper[i] <= bound) {
+                            continue;
+                        }
+                        upper[i] = std::sqrt(squaredDistance(point, &centroids[label * 3]));
+                        if (upper[i] <= bound) {
+                            continue;
+                        }
+                    }
+                    squaredDistances(point, lanes, distances.data());
+                    int best = 0;
+                    float bestDistance = distances[0];
+                    float secondDistance = kFarAway;
+                    for (int j = 1; j < k; ++j) {
+                        if (distances[j] < bestDistance) {
+                            secondDistance = bestDistance;
+                            bestDistance = distances[j];
+                            best = j;
+                        } else if (distances[j] < secondDistance) {
+                            secondDistance = distances[j];
+                        }
+                    }
+                    upper[i] = std::sqrt(bestDistance);
+                    lower[i] = std::sqrt(secondDistance);
+                    if (best != label) {
+                        labels[i] = best;
+                        changed++;
+                    }
+                }
+            }
+            if (changed == 0 && iteration > 0) {
+                break;
+            }
+
+            // move the centroids to the mean of their points
+            std::fill(sums.begin(), sums.end(), 0.0);
+            std::fill(sizes.begin(), sizes.end(), 0);
+            for (int i = 0; i < count; ++i) {
+                double *sum = &sums[labels[i] * 3];
+                sum[0] += points[i * 3];
+                sum[1] += points[i * 3 + 1];
+                sum[2] += points[i * 3 + 2];
+                sizes[labels[i]]++;
+            }
+            int mostMoved = 0;
+            float maxMove = 0.0f, secondMove = 0.0f;
+            for (int j = 0; j < k; ++j) {
+                moved[j] = 0.0f;
+                if (sizes[j] > 0) {
+                    float mean[3];
+                    for (int axis = 0; axis < 3; ++axis) {
+                        mean[axis] = static_cast<float>(sums[j * 3 + axis] / sizes[j]);
+                    }
+                    moved[j] = std::sqrt(squaredDistance(mean, &centroids[j * 3]));
+                    std::copy(mean, mean + 3, centroids.begin() + j * 3);
+                    lanes.set(j, mean);
+                }
+                if (moved[j] > maxMove) {
+                    secondMove = maxMove;
+                    maxMove = moved[j];
+                    mostMoved = j;
+                } else if (moved[j] > secondMove) {
+                    secondMove = moved[j];
+                }
+            }
+
+            // the bounds stay valid when widened by the movement of the centroids
+#pragma omp parallel for if (count >= kMinParallelPoints) schedule(static)
+            for (int i = 0; i < count; ++i) {
+                upper[i] += moved[labels[i]];
+                lower[i] -= labels[i] == mostMoved ? secondMove : maxMove;
+            }
+        }
+        return iteration;
+    }
+
+    int agglomerativeClustering(const float *points, int count, float maxDistance,
+                                std::vector<int> &labels, std::vector<float> &centroids) {
+        labels.resize(count);
+        centroids.clear();
+        float inverseCellSize = maxDistance > 0.0f ? 1.0f / maxDistance : 0.0f;
+        float maxSquaredDistance = maxDistance * maxDistance;
+
+        // every point starts as its own cluster
+        std::vector<Cluster> clusters(count);
+        std::vector<int> mergedInto(count, -1);
+        std::unordered_map<VoxelKey, std::vector<int>, VoxelKeyHasher> cells;
+        for (int i = 0; i < count; ++i) {
+            Cluster &cluster = clusters[i];
+            std::copy(points + i * 3, points + i * 3 + 3, cluster.centroid);
+            cluster.size = 1;
+            cluster.version = 0;
+            cluster.cell.x = static_cast<int>(std::floor(cluster.centroid[0] * inverseCellSize));
+            cluster.cell.y = static_cast<int>(std::floor(cluster.centroid[1] * inverseCellSize));
+            cluster.cell.z = static_cast<int>(std::floor(cluster.centroid[2] * inverseCellSize));
+            cells[cluster.cell].push_back(i);
+        }
+
+        // every cluster keeps only the candidate of its nearest neighbour, so the
+        // queue stays linear in the number of points even in dense cells. The
+        // closest pair is always the nearest neighbour of the later changed one
+        // of both, so it is found like with all pairs in the queue.
+        std::priority_queue<MergeCandidate, std::vector<MergeCandidate>,
+                std::greater<MergeCandidate> > candidates;
+        // centroids closer than maxDistance are at most one cell apart
+        auto addNearest = [&](int a) {
+            const Cluster &cluster = clusters[a];
+            MergeCandidate nearest = {maxSquaredDistance, a, -1, cluster.version, 0};
+            VoxelKey neighbour;
+            for (int dx = -1; dx <= 1; ++dx) {
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dz = -1; dz <= 1; ++dz) {
+                        neighbour.x = cluster.cell.x + dx;
+                        neighbour.y = cluster.cell.y + dy;
+                        neighbour.z = cluster.cell.z + dz;
+                        std::unordered_map<VoxelKey, std::vector<int>, VoxelKeyHasher>::const_iterator cell =
+                                cells.find(neighbour);
+                        if (cell == cells.end()) {
+                            continue;
+                        }
+                        for (size_t n = 0; n < cell->second.size(); ++n) {
+                            int b = cell->second[n];
+                            if (b == a) {
+                                continue;
+                            }
+                            float distance = squaredDistance(cluster.centroid, clusters[b].centroid);
+                            if (distance < nearest.distance) {
+                                nearest.distance = distance;
+                                nearest.b = b;
+                                nearest.versionB = clusters[b].version;
+                            }
+                        }
+                    }
+                }
+            }
+            if (nearest.b >= 0) {
+                candidates.push(nearest);
+            }
+        };
+        if (maxDistance > 0.0f) {
+            for (int i = 0; i < count; ++i) {
+                addNearest(i);
+            }
+        }
+
+        int clusterCount = count;
+        while (!candidates.empty()) {
+            MergeCandidate candidate = candidates.top();
+            candidates.pop();
+            Cluster &a = clusters[candidate.a];
+            Cluster &b = clusters[candidate.b];
+            // a changed cluster already queued its new nearest neighbour
+            if (mergedInto[candidate.a] >= 0 || a.version != candidate.versionA) {
+                continue;
+            }
+            // the neighbour changed, a looks for its nearest neighbour again
+            if (mergedInto[candidate.b] >= 0 || b.version != candidate.versionB) {
+                addNearest(candidate.a);
+                continue;
+            }
+
+            // b is merged into a, a moves to the weighted centroid of both
+            std::vector<int> &cellOfB = cells[b.cell];
+            cellOfB.erase(std::find(cellOfB.begin(), cellOfB.end(), candidate.b));
+            float size = static_cast<float>(a.size + b.size);
+            for (int axis = 0; axis < 3; ++axis) {
+                a.centroid[axis] = (a.centroid[axis] * a.size + b.centroid[axis] * b.size) / size;
+            }
+            a.size += b.size;
+            a.version++;
+            mergedInto[candidate.b] = candidate.a;
+            clusterCount--;
+
+            VoxelKey cell;
+            cell.x = static_cast<int>(std::floor(a.centroid[0] * inverseCellSize));
+            cell.y = static_cast<int>(std::floor(a.centroid[1] * inverseCellSize));
+            cell.z = static_cast<int>(std::floor(a.centroid[2] * inverseCellSize));
+            if (!(cell == a.cell)) {
+                std::vector<int> &cellOfA = cells[a.cell];
+                cellOfA.erase(std::find(cellOfA.begin(), cellOfA.end(), candidate.a));
+                a.cell = cell;
+                cells[cell].push_back(candidate.a);
+            }
+            addNearest(candidate.a);
+        }
+
+        // number the remaining clusters and label the points with them
+        std::vector<int> numbers(count, -1);
+        for (int i = 0; i < count; ++i) {
+            if (mergedInto[i] < 0) {
+                numbers[i] = static_cast<int>(centroids.size() / 3);
+                centroids.insert(centroids.end(), clusters[i].centroid, clusters[i].centroid + 3);
+            }
+        }
+        for (int i = 0; i < count; ++i) {
+            int root = i;
+            while (mergedInto[root] >= 0) {
+                root = mergedInto[root];
+            }
+            // shorten the chain for the following points
+            for (int node = i; mergedInto[node] >= 0;) {
+                int next = mergedInto[node];
+                mergedInto[node] = root;
+                node = next;
+            }
+            labels[i] = numbers[root];
+        }
+        return clusterCount;
+    }
+}
@@ -0,0 +1,37 @@
+//
+// k-means and agglomerative clustering of flat x, y, z float buffers.
+//
+
+#ifndef MASTERPROTOTYPE_CLUSTERING_H
+#define MASTERPROTOTYPE_CLUSTERING_H
+
+#include <vector>
+
+namespace constructnative {
+
+    // Partitions count points into k clusters. The centroids are seeded with
+    // k-means++, Hamerly's bounds skip points which cannot change their cluster
+    // and the remaining points are assigned on all cores, comparing against four
+    // centroids at once.
+    //
+    // @param labels: gets the cluster of every point
+    // @param centroids: gets k centroids as x, y, z floats
+    // @return: iterations until no point changed its cluster
+    int kMeansClustering(const float *points, int count, int k, int maxIterations,
+                         unsigned int seed, std::vector<int> &labels,
+                         std::vector<float> &centroids);
+
+    // Centroid linkage clustering, the two clusters with the closest centroids
+    // are merged until no centroids are closer than maxDistance. Centroids are
+    // kept in a hashed grid with cells of maxDistance, so only neighbouring
+    // cells are searched for merge candidates. Only the nearest neighbour of
+    // every cluster is queued as candidate.
+    //
+    // @param labels: gets the cluster of every point, clusters are numbered from 0
+    // @param centroids: gets one centroid per cluster as x, y, z floats
+    // @return: number of clusters
+    int agglomerativeClustering(const float *points, int count, float maxDistance,
+                                std::vector<int> &labels, std::vector<float> &centroids);
+}
+
+#endif //MASTERPROTOTYPE_CLUSTERING_H
@@ -9,6 +9,8 @@
 #include <pcl/search/search.h>
 #include <pcl/search/kdtree.h>
 #include <pcl/features/normal_3d.h>
+#include <pcl/features/normal_3d_omp.h>
+#include <pcl/features/impl/normal_3d_omp.hpp>
 #include <pcl/surface/gp3.h>
 #include <pcl/filters/voxel_grid.h>
 #include <pcl/filters/filter.h>
@@ -19,10 +21,33 @@
 #include <pcl/sample_consensus/model_types.h>
 #include <pcl/segmentation/sac_segmentation.h>
 #include <pcl/filters/extract_indices.h>
+#include <pcl/common/io.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <thread>
+#include <vector>
 
 
 namespace constructnative {
 
+    static int hardwareThreads() {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // threads of the normal estimation, 1 uses the sequential pcl::NormalEstimation
+    static std::atomic<int> normalEstimationThreads(hardwareThreads());
+
+    void setNormalEstimationThreads(int threads) {
+        if (threads <= 0) {
+            threads = hardwareThreads();
+        }
+        normalEstimationThreads = threads;
+        LOGI("Normal estimation uses %d threads", threads);
+    }
+
     void voxelGridDownSampling(const pcl::PointCloud<pcl::PointXYZ>::Ptr source,
                                const pcl::PointCloud<pcl::PointXYZ>::Ptr target,
                                float leafSize) {
@@ -32,18 +57,61 @@ namespace constructnative {
         sor.filter(*target);
     }
 
-    void estimateNormals(const pcl::PointCloud<pcl::PointXYZ>::Ptr source,
-                         const pcl::PointCloud<pcl::PointNormal>::Ptr target,
+    // GreedyProjectionTriangulation which searches the index it is given instead of
+    // rebuilding it from its input cloud.
+    template<typename PointNT>
+    class SharedIndexGreedyProjectionTriangulation
+            : public pcl::GreedyProjectionTriangulation<PointNT> {
+    public:
+        SharedIndexGreedyProjectionTriangulation() {
+            this->check_tree_ = false;
+        }
+    };
+
+    long long currentTimeInMicroseconds() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Builds the one spatial index of a reconstruction. It only covers x, y and z,
+    // so it stays valid when the normals of the cloud are filled in later.
+    pcl::search::KdTree<pcl::PointNormal>::Ptr buildSearchIndex(
+            const pcl::PointCloud<pcl::PointNormal>::Ptr cloud) {
+        long long before = currentTimeInMicroseconds();
+        pcl::search::KdTree<pcl::PointNormal>::Ptr tree(new pcl::search::KdTree <pcl::PointNormal>);
+        tree->setInputCloud(cloud);
+        LOGE("Built search index over %d points in %lld us", cloud->points.size(),
+             currentTimeInMicroseconds() - before);
+        return tree;
+    }
+
+    // fills the normals of cloud, searching the neighbours in the shared index
+    void estimateNormals(const pcl::PointCloud<pcl::PointNormal>::Ptr cloud,
+                         const pcl::search::KdTree<pcl::PointNormal>::Ptr tree,
                          int kSearch) {
-        pcl::NormalEstimation <pcl::PointXYZ, pcl::Normal> n;
-        pcl::PointCloud<pcl::Normal>::Ptr normals(new pcl::PointCloud <pcl::Normal>);
-        pcl::search::KdTree<pcl::PointXYZ>::Ptr tree(new pcl::search::KdTree <pcl::PointXYZ>);
-        tree->setInputCloud(source);
-        n.setInputCloud(source);
-        n.setSearchMethod(tree);
-        n.setKSearch(kSearch);
-        n.compute(*normals);
-        pcl::concatenateFields(*source, *normals, *target);
+        pcl::PointCloud<pcl::Normal> normals;
+        int threads = normalEstimationThreads;
+        if (threads > 1) {
+            // every point is estimated on its own, the OpenMP version splits the points
+            pcl::NormalEstimationOMP <pcl::PointNormal, pcl::Normal> n(threads);
+            n.setInputCloud(cloud);
+            n.setSearchMethod(tree);
+            n.setKSearch(kSearch);
+            n.compute(normals);
+        } else {
+            pcl::NormalEstimation <pcl::PointNormal, pcl::Normal> n;
+            n.setInputCloud(cloud);
+            n.setSearchMethod(tree);
+            n.setKSearch(kSearch);
+            n.compute(normals);
+        }
+        for (size_t i = 0; i < normals.points.size(); ++i) {
+            pcl::PointNormal &point = cloud->points[i];
+            point.normal_x = normals.points[i].normal_x;
+            point.normal_y = normals.points[i].normal_y;
+            point.normal_z = normals.points[i].normal_z;
+            point.curvature = normals.points[i].curvature;
+        }
     }
 
     void estimateNormals(const pcl::PointCloud<pcl::PointXYZ>::Ptr source,
@@ -59,11 +127,10 @@ namespace constructnative {
     }
 
     pcl::PolygonMesh greedyTriangulationReconstruction(
-            const pcl::PointCloud<pcl::PointNormal>::Ptr source) {
+            const pcl::PointCloud<pcl::PointNormal>::Ptr source,
+            const pcl::search::KdTree<pcl::PointNormal>::Ptr tree) {
         pcl::PolygonMesh triangles;
-        pcl::search::KdTree<pcl::PointNormal>::Ptr tree(new pcl::search::KdTree <pcl::PointNormal>);
-        tree->setInputCloud(source);
-        pcl::GreedyProjectionTriangulation <pcl::PointNormal> gp3;
+        SharedIndexGreedyProjectionTriangulation <pcl::PointNormal> gp3;
         gp3.setSearchRadius(0.1);
         gp3.setMu(3.0);
         gp3.setMaximumNearestNeighbors(100);
@@ -81,40 +148,305 @@ namespace constructnative {
     int verticesToPointCloud(jfloatArray vertices,
                              const pcl::PointCloud<pcl::PointXYZ>::Ptr cloud, JNIEnv *env) {
         int vertexCount = env->GetArrayLength(vertices) / 3;
-        jfloat *verticesData = env->GetFloatArrayElements(vertices, NULL);
         cloud->points.resize(vertexCount);
+        cloud->width = vertexCount;
+        cloud->height = 1;
+        // no JNI calls are allowed until the array is released
+        jfloat *verticesData = static_cast<jfloat *>(
+                env->GetPrimitiveArrayCritical(vertices, NULL));
+        if (verticesData == NULL) {
+            LOGE("Could not access the vertex array");
+            cloud->points.clear();
+            cloud->width = 0;
+            return 0;
+        }
         for (int i = 0; i < vertexCount; ++i) {
-            pcl::PointXYZ point;
+            pcl::PointXYZ &point = cloud->points[i];
             point.x = verticesData[i * 3];
             point.y = verticesData[i * 3 + 1];
             point.z = verticesData[i * 3 + 2];
-            cloud->points[i] = point;
         }
+        // the array was only read, nothing has to be copied back
+        env->ReleasePrimitiveArrayCritical(vertices, verticesData, JNI_ABORT);
         return vertexCount;
     }
 
-    jfloatArray polygonMeshToVertices(pcl::PolygonMesh triangles,
-                                      const pcl::PointCloud<pcl::PointXYZ>::Ptr filtered_cloud,
-                                      JNIEnv *env) {
+    // flattens the triangles of a mesh into x, y, z floats
+    template<typename PointT>
+    void polygonMeshToVertices(const pcl::PolygonMesh &triangles,
+                               const typename pcl::PointCloud<PointT>::Ptr filtered_cloud,
+                               std::vector<float> &vertices) {
         int polygonCount = triangles.polygons.size();
-        jfloatArray array = env->NewFloatArray(polygonCount * 9);
+        vertices.resize(polygonCount * 9);
+        float *vertex = vertices.data();
         for (int i = 0; i < polygonCount; i++) {
-            float vertex[9] = {
-                    filtered_cloud->points[triangles.polygons[i].vertices[0]].x,
-                    filtered_cloud->points[triangles.polygons[i].vertices[0]].y,
-                    filtered_cloud->points[triangles.polygons[i].vertices[0]].z,
-                    filtered_cloud->points[triangles.polygons[i].vertices[1]].x,
-                    filtered_cloud->points[triangles.polygons[i].vertices[1]].y,
-                    filtered_cloud->points[triangles.polygons[i].vertices[1]].z,
-                    filtered_cloud->points[triangles.polygons[i].vertices[2]].x,
-                    filtered_cloud->points[triangles.polygons[i].vertices[2]].y,
-                    filtered_cloud->points[triangles.polygons[i].vertices[2]].z
-            };
-            env->SetFloatArrayRegion(array, i * 9, 9, vertex);
+            const std::vector<uint32_t> &indices = triangles.polygons[i].vertices;
+            for (int j = 0; j < 3; ++j) {
+                const PointT &point = filtered_cloud->points[indices[j]];
+                *vertex++ = point.x;
+                *vertex++ = point.y;
+                *vertex++ = point.z;
+            }
+        }
+    }
+
+    // copies staged vertices to java with one JNI call
+    jfloatArray verticesToArray(const std::vector<float> &vertices, JNIEnv *env) {
+        jfloatArray array = env->NewFloatArray(vertices.size());
+        if (array == NULL) {
+            LOGE("Could not allocate %d vertices", vertices.size() / 3);
+            return NULL;
         }
+        env->SetFloatArrayRegion(array, 0, vertices.size(), vertices.data());
         return array;
     }
 
+    void triangulateWithNormals(const pcl::PointCloud<pcl::PointXYZ>::Ptr cloud,
+                                pcl::PolygonMesh &triangles) {
+        if (cloud->points.size() < 3) {
+            triangles.polygons.clear();
+            return;
+        }
+        // one search index for normal estimation and triangulation
+        pcl::PointCloud<pcl::PointNormal>::Ptr cloud_with_normals(
+                new pcl::PointCloud <pcl::PointNormal>);
+        pcl::copyPointCloud(*cloud, *cloud_with_normals);
+        pcl::search::KdTree<pcl::PointNormal>::Ptr tree = buildSearchIndex(cloud_with_normals);
+
+        // Normal estimation
+        long long before = currentTimeInMicroseconds();
+        estimateNormals(cloud_with_normals, tree, 10);
+        LOGE("Estimated normals with %d threads in %lld us", normalEstimationThreads.load(),
+             currentTimeInMicroseconds() - before);
+
+        // Triangulate with Greedy Triangulation
+        before = currentTimeInMicroseconds();
+        triangles = greedyTriangulationReconstruction(cloud_with_normals, tree);
+        LOGE("Reconstructed %d polygons in %lld us", triangles.polygons.size(),
+             currentTimeInMicroseconds() - before);
+    }
+
+    void arrayToVertices(jfloatArray vertices, std::vector<float> &points, JNIEnv *env) {
+        points.resize(env->GetArrayLength(vertices));
+        env->GetFloatArrayRegion(vertices, 0, points.size(), points.data());
+    }
+
+    jintArray labelsToArray(const std::vector<int> &labels, JNIEnv *env) {
+        jintArray array = env->NewIntArray(labels.size());
+        if (array == NULL) {
+            LOGE("Could not allocate %d labels", labels.size());
+            return NULL;
+        }
+        env->SetIntArrayRegion(array, 0, labels.size(), labels.data());
+        return array;
+    }
+
+    jintArray kMeansLabels(JNIEnv *env, jfloatArray vertices, int k, int maxIterations,
+                           unsigned int seed) {
+        std::vector<float> points;
+        arrayToVertices(vertices, points, env);
+        std::vector<int> labels;
+        std::vector<float> centroids;
+        long long before = currentTimeInMicroseconds();
+        int iterations = kMeansClustering(points.data(), points.size() / 3, k, maxIterations,
+                                          seed, labels, centroids);
+        LOGE("Clustered %d points with k-means in %d iterations and %lld us",
+             labels.size(), iterations, currentTimeInMicroseconds() - before);
+        return labelsToArray(labels, env);
+    }
+
+    jintArray agglomerativeLabels(JNIEnv *env, jfloatArray vertices, float maxDistance) {
+        std::vector<float> points;
+        arrayToVertices(vertices, points, env);
+        std::vector<int> labels;
+        std::vector<float> centroids;
+        long long before = currentTimeInMicroseconds();
+        int clusters = agglomerativeClustering(points.data(), points.size() / 3, maxDistance,
+                                               labels, centroids);
+        LOGE("Clustered %d points into %d clusters in %lld us", labels.size(), clusters,
+             currentTimeInMicroseconds() - before);
+        return labelsToArray(labels, env);
+    }
+
+    jfloatArray marchingCubesMesh(JNIEnv *env, jfloatArray vertices, float voxelSize) {
+        std::vector<float> points;
+        arrayToVertices(vertices, points, env);
+        std::vector<float> sharedVertices;
+        std::vector<int> indices;
+        MarchingCubes(voxelSize).reconstruct(points.data(), points.size() / 3, sharedVertices,
+                                             indices);
+        // the renderer draws plain triangle lists
+        std::vector<float> mesh(indices.size() * 3);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            std::copy(&sharedVertices[indices[i] * 3], &sharedVertices[indices[i] * 3] + 3,
+                      &mesh[i * 3]);
+        }
+        return verticesToArray(mesh, env);
+    }
+
+    jintArray polygonTriangles(JNIEnv *env, jfloatArray points, jintArray ringSizes,
+                               jintArray ringsPerPolygon) {
+        std::vector<float> coordinates;
+        arrayToVertices(points, coordinates, env);
+        std::vector<int> sizes(env->GetArrayLength(ringSizes));
+        env->GetIntArrayRegion(ringSizes, 0, sizes.size(), sizes.data());
+        std::vector<int> rings(env->GetArrayLength(ringsPerPolygon));
+        env->GetIntArrayRegion(ringsPerPolygon, 0, rings.size(), rings.data());
+
+        // split the flat arrays into polygons, remembering their first vertex
+        std::vector<Polygon2D> polygons(rings.size());
+        std::vector<int> firstVertices(rings.size());
+        size_t ring = 0;
+        int vertex = 0;
+        std::vector<int> triangles;
+        for (size_t i = 0; i < rings.size(); ++i) {
+            firstVertices[i] = vertex;
+            for (int j = 0; j < rings[i] && ring < sizes.size(); ++j) {
+                polygons[i].ringSizes.push_back(sizes[ring]);
+                vertex += sizes[ring++];
+            }
+            if (vertex * 2 > static_cast<int>(coordinates.size())) {
+                LOGE("Polygons need %d vertices but got %d", vertex, coordinates.size() / 2);
+                return labelsToArray(triangles, env);
+            }
+            polygons[i].points.assign(coordinates.begin() + firstVertices[i] * 2,
+                                      coordinates.begin() + vertex * 2);
+        }
+
+        long long before = currentTimeInMicroseconds();
+        std::vector<std::vector<int> > triangulations;
+        int triangulated = triangulatePolygons(polygons, triangulations);
+        for (size_t i = 0; i < triangulations.size(); ++i) {
+            for (size_t j = 0; j < triangulations[i].size(); ++j) {
+                triangles.push_back(firstVertices[i] + triangulations[i][j]);
+            }
+        }
+        LOGE("Triangulated %d of %d polygons into %d triangles in %lld us", triangulated,
+             polygons.size(), triangles.size() / 3, currentTimeInMicroseconds() - before);
+        return labelsToArray(triangles, env);
+    }
+
+    // estimates normals and triangulates a downsampled cloud
+    void greedyTriangulation(const pcl::PointCloud<pcl::PointXYZ>::Ptr filtered_cloud,
+                             std::vector<float> &vertices) {
+        pcl::PolygonMesh triangles;
+        triangulateWithNormals(filtered_cloud, triangles);
+        polygonMeshToVertices<pcl::PointXYZ>(triangles, filtered_cloud, vertices);
+    }
+
+    // most planes extracted from one cloud
+    const int kMaxPlanes = 8;
+    // planes need at least this many inliers
+    const int kMinPlaneInliers = 30;
+    // extraction stops when less than this fraction of the points is left
+    const float kResidualFraction = 0.1f;
+
+    // Delaunay triangulation of the convex hull of the inliers in the coordinates
+    // of their plane. A plane is known, so no normals or neighbour searches are
+    // needed.
+    void meshPlaneHull(const pcl::PointCloud<pcl::PointXYZ>::Ptr plane_cloud,
+                       const pcl::ModelCoefficients &coefficients,
+                       std::vector<float> &vertices) {
+        Eigen::Vector3f normal(coefficients.values[0], coefficients.values[1],
+                               coefficients.values[2]);
+        float length = normal.norm();
+        normal /= length;
+        float distance = coefficients.values[3] / length;
+
+        // orthonormal basis of the plane
+        Eigen::Vector3f helper = std::fabs(normal.x()) < 0.9f ? Eigen::Vector3f::UnitX()
+                                                              : Eigen::Vector3f::UnitY();
+        Eigen::Vector3f u = normal.cross(helper).normalized();
+        Eigen::Vector3f v = normal.cross(u);
+        Eigen::Vector3f origin = -distance * normal;
+
+        std::vector<Point2D> projection(plane_cloud->points.size());
+        for (size_t i = 0; i < plane_cloud->points.size(); ++i) {
+            const pcl::PointXYZ &point = plane_cloud->points[i];
+            Eigen::Vector3f p = Eigen::Vector3f(point.x, point.y, point.z) - origin;
+            projection[i].x = p.dot(u);
+            projection[i].y = p.dot(v);
+        }
+        std::vector<Point2D> hull = convexHull(projection);
+        Polygon2D polygon;
+        polygon.ringSizes.push_back(static_cast<int>(hull.size()));
+        for (size_t i = 0; i < hull.size(); ++i) {
+            polygon.points.push_back(hull[i].x);
+            polygon.points.push_back(hull[i].y);
+        }
+        std::vector<int> triangles;
+        triangulatePolygon(polygon, triangles);
+        vertices.clear();
+        for (size_t i = 0; i < triangles.size(); ++i) {
+            const Point2D &corner = hull[triangles[i]];
+            Eigen::Vector3f p = origin + corner.x * u + corner.y * v;
+            vertices.push_back(p.x());
+            vertices.push_back(p.y());
+            vertices.push_back(p.z());
+        }
+    }
+
+    // Extracts up to kMaxPlanes planes with RANSAC, removing the inliers of each
+    // plane before searching the next one. The planes are meshed on worker
+    // threads while the extraction goes on.
+    void planeSegmentation(const pcl::PointCloud<pcl::PointXYZ>::Ptr cloud,
+                           std::vector<float> &vertices) {
+        vertices.clear();
+        long long before = currentTimeInMicroseconds();
+
+        pcl::PointCloud<pcl::PointXYZ>::Ptr remaining(new pcl::PointCloud <pcl::PointXYZ>(*cloud));
+        size_t residual = static_cast<size_t>(cloud->points.size() * kResidualFraction);
+        std::vector<std::future<std::vector<float> > > planeMeshes;
+
+        // RANSAC Segmentation
+        pcl::SACSegmentation<pcl::PointXYZ> seg;
+        seg.setOptimizeCoefficients (true);
+        seg.setModelType(pcl::SACMODEL_PLANE);
+        seg.setMethodType(pcl::SAC_RANSAC);
+        seg.setDistanceThreshold (0.02);
+        pcl::ExtractIndices<pcl::PointXYZ> extract;
+
+        while (static_cast<int>(planeMeshes.size()) < kMaxPlanes &&
+               remaining->points.size() >= static_cast<size_t>(kMinPlaneInliers) &&
+               remaining->points.size() > residual) {
+            pcl::ModelCoefficients::Ptr coefficients (new pcl::ModelCoefficients);
+            pcl::PointIndices::Ptr inliers (new pcl::PointIndices);
+            seg.setInputCloud(remaining);
+            seg.segment(*inliers, *coefficients);
+            if (inliers->indices.size() < static_cast<size_t>(kMinPlaneInliers)) {
+                break;
+            }
+            LOGE("Found %d that supports the plane %lf %lf %lf %lf", inliers->indices.size(),
+                 coefficients->values[0], coefficients->values[1], coefficients->values[2],
+                 coefficients->values[3]);
+
+            // Get Plane related points in Pointcloud
+            pcl::PointCloud<pcl::PointXYZ>::Ptr plane_cloud(new pcl::PointCloud <pcl::PointXYZ>);
+            extract.setInputCloud(remaining);
+            extract.setIndices(inliers);
+            extract.setNegative(false);
+            extract.filter(*plane_cloud);
+            planeMeshes.push_back(std::async(std::launch::async, [plane_cloud, coefficients]() {
+                std::vector<float> mesh;
+                meshPlaneHull(plane_cloud, *coefficients, mesh);
+                return mesh;
+            }));
+
+            // continue with the points of no plane so far
+            pcl::PointCloud<pcl::PointXYZ>::Ptr rest(new pcl::PointCloud <pcl::PointXYZ>);
+            extract.setNegative(true);
+            extract.filter(*rest);
+            remaining = rest;
+        }
+
+        for (size_t i = 0; i < planeMeshes.size(); ++i) {
+            std::vector<float> mesh = planeMeshes[i].get();
+            vertices.insert(vertices.end(), mesh.begin(), mesh.end());
+        }
+        LOGE("Reconstructed %d planes with %d polygons in %lld us", planeMeshes.size(),
+             vertices.size() / 9, currentTimeInMicroseconds() - before);
+    }
+
     jfloatArray GreedyApplication::reconstruct(JNIEnv *env, jfloatArray vertices) {
 
         // transform jfloatArray vertices to pcl::PointCloud
@@ -127,22 +459,36 @@ namespace constructnative {
         voxelGridDownSampling(cloud, filtered_cloud, 0.03f);
         LOGE("filtered PointCloud has %d points", filtered_cloud->points.size());
 
-        // Normal estimation
-        pcl::PointCloud<pcl::PointNormal>::Ptr filtered_cloud_with_normals(
-                new pcl::PointCloud <pcl::PointNormal>);
-        estimateNormals(filtered_cloud, filtered_cloud_with_normals, 10);
-
-        // Triangulate with Greedy Triangulation
-        pcl::PolygonMesh triangles = greedyTriangulationReconstruction(filtered_cloud_with_normals);
-        LOGE("Reconstructed %d polygons", triangles.polygons.size());
+        // transform the triangles to jfloatArray vertices
+        std::vector<float> mesh;
+        greedyTriangulation(filtered_cloud, mesh);
+        return verticesToArray(mesh, env);
+    }
 
-        // transform pcl::PolygonMesh to jfloatArray vertices
-        jfloatArray array = polygonMeshToVertices(triangles, filtered_cloud, env);
+    jfloatArray GreedyApplication::reconstruct(JNIEnv *env, VoxelAccumulator &accumulator) {
+        if (accumulator.getRevision() != accumulatedRevision) {
+            accumulatedRevision = accumulator.getRevision();
+            LOGE("accumulated PointCloud has %d points", accumulator.getCloud()->points.size());
+            if (incrementalMode) {
+                incremental.update(accumulator, accumulatedMesh);
+            } else {
+                greedyTriangulation(accumulator.getCloud(), accumulatedMesh);
+            }
+        }
+        return verticesToArray(accumulatedMesh, env);
+    }
 
-        return array;
+    void GreedyApplication::setIncremental(bool incremental) {
+        if (incremental != incrementalMode) {
+            incrementalMode = incremental;
+            // the kept triangulation is outdated, the next call starts over
+            this->incremental.clear();
+            accumulatedRevision = -1;
+        }
     }
 
-    GreedyApplication::GreedyApplication() {
+    // patches of 8 voxels, larger than the GP3 search radius
+    GreedyApplication::GreedyApplication() : incremental(8) {
     }
 
     GreedyApplication::~GreedyApplication() {
@@ -156,47 +502,48 @@ namespace constructnative {
         verticesToPointCloud(vertices, cloud, env);
         LOGE("PointCloud has %d points", cloud->points.size());
 
-        // RANSAC Segmentation
-        pcl::ModelCoefficients::Ptr coefficients (new pcl::ModelCoefficients);
-        pcl::PointIndices::Ptr inliers (new pcl::PointIndices);
-        // Create the segmentation object
-        pcl::SACSegmentation<pcl::PointXYZ> seg;
-        // Optional
-        seg.setOptimizeCoefficients (true);
-        // Mandatory
-        seg.setModelType(pcl::SACMODEL_PLANE);
-        seg.setMethodType(pcl::SAC_RANSAC);
-        seg.setDistanceThreshold (0.02);
-        seg.setInputCloud(cloud);
-        seg.segment(*inliers, *coefficients);
+        // transform the triangles to jfloatArray vertices
+        std::vector<float> mesh;
+        planeSegmentation(cloud, mesh);
+        return verticesToArray(mesh, env);
+    }
 
-        LOGE("Found %d that supports the plane %lf %lf %lf %lf", inliers->indices.size(), coefficients->values[0], coefficients->values[1], coefficients->values[2], coefficients->values[3]);
+    jfloatArray PlaneApplication::reconstruct(JNIEnv *env, VoxelAccumulator &accumulator) {
+        if (accumulator.getRevision() != accumulatedRevision) {
+            accumulatedRevision = accumulator.getRevision();
+            LOGE("accumulated PointCloud has %d points", accumulator.getCloud()->points.size());
+            planeSegmentation(accumulator.getCloud(), accumulatedMesh);
+        }
+        return verticesToArray(accumulatedMesh, env);
+    }
 
-        // Get Plane related points in Pointcloud
-        pcl::PointCloud<pcl::PointXYZ>::Ptr plane_cloud(new pcl::PointCloud <pcl::PointXYZ>);
-        pcl::ExtractIndices<pcl::PointXYZ> extract;
-        extract.setInputCloud(cloud);
-        extract.setIndices(inliers);
-        extract.setNegative(false);
-        extract.filter(*plane_cloud);
+    PlaneApplication::PlaneApplication() {
+    }
 
-        // Normal estimation
-        pcl::PointCloud<pcl::PointNormal>::Ptr plane_cloud_with_normals(new pcl::PointCloud <pcl::PointNormal>);
-        estimateNormals(plane_cloud, plane_cloud_with_normals, 10);
+    PlaneApplication::~PlaneApplication() {
+    }
 
-        // Triangulate with Greedy Triangulation
-        pcl::PolygonMesh triangles = greedyTriangulationReconstruction(plane_cloud_with_normals);
-        LOGE("Reconstructed %d polygons", triangles.polygons.size());
 
-        // transform pcl::PolygonMesh to jfloatArray vertices
-        jfloatArray array = polygonMeshToVertices(triangles, plane_cloud, env);
+    jfloatArray PlanarApplication::reconstruct(JNIEnv *env, jfloatArray vertices) {
+        int count = env->GetArrayLength(vertices) / 3;
+        std::vector<float> mesh;
+        jfloat *points = static_cast<jfloat *>(env->GetPrimitiveArrayCritical(vertices, NULL));
+        if (points == NULL) {
+            return verticesToArray(mesh, env);
+        }
+        // copied instead of reconstructing in the critical section, which would
+        // block the garbage collector for the whole reconstruction
+        std::vector<float> copy(points, points + count * 3);
+        env->ReleasePrimitiveArrayCritical(vertices, points, JNI_ABORT);
+        LOGE("PointCloud has %d points", count);
 
-        return array;
+        engine.reconstruct(copy.data(), count, mesh);
+        return verticesToArray(mesh, env);
     }
 
-    PlaneApplication::PlaneApplication() {
+    PlanarApplication::PlanarApplication() {
     }
 
-    PlaneApplication::~PlaneApplication() {
+    PlanarApplication::~PlanarApplication() {
     }
-}
\ No newline at end of file
+}
@@ -7,9 +7,19 @@
 
 #include <jni.h>
 #include <cstdlib>
+#include <vector>
 #include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+#include <pcl/PolygonMesh.h>
 #include <android/log.h>
 
+#include "voxelaccumulator.h"
+#include "incrementaltriangulation.h"
+#include "planarreconstruction.h"
+#include "clustering.h"
+#include "marchingcubes.h"
+#include "polygontriangulation.h"
+
 #define LOGV(...) __android_log_print(ANDROID_LOG_VERBOSE, "Native",__VA_ARGS__)
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG  , "Native",__VA_ARGS__)
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO   , "Native",__VA_ARGS__)
@@ -18,6 +28,36 @@
 
 namespace constructnative {
 
+    // Sets the threads used for normal estimation, 1 keeps the sequential
+    // estimation and 0 or less uses all cores, which is the default.
+    void setNormalEstimationThreads(int threads);
+
+    long long currentTimeInMicroseconds();
+
+    // clusters the points of vertices into k clusters with k-means, seeded with
+    // seed and stopped after maxIterations, and returns the cluster of every point
+    jintArray kMeansLabels(JNIEnv *env, jfloatArray vertices, int k, int maxIterations,
+                           unsigned int seed);
+
+    // clusters the points of vertices with centroid linkage up to maxDistance
+    // and returns the cluster of every point
+    jintArray agglomerativeLabels(JNIEnv *env, jfloatArray vertices, float maxDistance);
+
+    // meshes the voxels of size voxelSize which contain a point of vertices with
+    // marching cubes and returns the triangles as x, y, z floats
+    jfloatArray marchingCubesMesh(JNIEnv *env, jfloatArray vertices, float voxelSize);
+
+    // triangulates a batch of polygons given as x, y plane coordinates, every
+    // polygon has ringsPerPolygon rings of ringSizes vertices, the first being
+    // the outline. Returns three indices into points per triangle.
+    jintArray polygonTriangles(JNIEnv *env, jfloatArray points, jintArray ringSizes,
+                               jintArray ringsPerPolygon);
+
+    // estimates normals and runs the greedy triangulation over cloud, both
+    // share one search index
+    void triangulateWithNormals(const pcl::PointCloud<pcl::PointXYZ>::Ptr cloud,
+                                pcl::PolygonMesh &triangles);
+
     class GreedyApplication {
     public:
         GreedyApplication();
@@ -26,6 +66,19 @@ namespace constructnative {
 
         jfloatArray reconstruct(JNIEnv *env, jfloatArray vertices);
 
+        // triangulates the downsampled state of the accumulator, the last mesh is
+        // returned again if no frame was merged since
+        jfloatArray reconstruct(JNIEnv *env, VoxelAccumulator &accumulator);
+
+        // switches between re-meshing only changed regions of the accumulator and
+        // triangulating all of it
+        void setIncremental(bool incremental);
+
+    private:
+        std::vector<float> accumulatedMesh;
+        int accumulatedRevision = -1;
+        bool incrementalMode = true;
+        IncrementalTriangulation incremental;
     };
 
     class PlaneApplication {
@@ -36,6 +89,29 @@ namespace constructnative {
 
         jfloatArray reconstruct(JNIEnv *env, jfloatArray vertices);
 
+        // segments the downsampled state of the accumulator, the last mesh is
+        // returned again if no frame was merged since
+        jfloatArray reconstruct(JNIEnv *env, VoxelAccumulator &accumulator);
+
+    private:
+        std::vector<float> accumulatedMesh;
+        int accumulatedRevision = -1;
+    };
+
+    // PCL free planar reconstruction, the native version of the construct app's
+    // ReconstructionBuilder
+    class PlanarApplication {
+    public:
+        PlanarApplication();
+
+        ~PlanarApplication();
+
+        jfloatArray reconstruct(JNIEnv *env, jfloatArray vertices);
+
+        void setConfig(const PlanarReconstructionConfig &config) { engine.setConfig(config); }
+
+    private:
+        PlanarReconstruction engine;
     };
 }
 
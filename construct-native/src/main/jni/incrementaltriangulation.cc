@@ -0,0 +1,318 @@
+//
+// Region local greedy triangulation of a voxel accumulator.
+//
+#include "incrementaltriangulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <Eigen/Geometry>
+
+#include "constructnative.h"
+
+namespace {
+    // rounds towards negative infinity, so patches have the same size around 0
+    int floorDivide(int value, int divisor) {
+        return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+    }
+
+    // same key for both directions of an edge
+    uint64_t edgeKey(int a, int b) {
+        uint32_t low = static_cast<uint32_t>(std::min(a, b));
+        uint32_t high = static_cast<uint32_t>(std::max(a, b));
+        return (static_cast<uint64_t>(high) << 32) | low;
+    }
+
+    // part of the offset from a to c perpendicular to the edge a, b
+    Eigen::Vector3f edgePerpendicular(const pcl::PointXYZ &a, const pcl::PointXYZ &b,
+                                      const pcl::PointXYZ &c) {
+        Eigen::Vector3f edge = b.getVector3fMap() - a.getVector3fMap();
+        Eigen::Vector3f offset = c.getVector3fMap() - a.getVector3fMap();
+        float length = edge.squaredNorm();
+        if (length > 0.0f) {
+            offset -= edge * (offset.dot(edge) / length);
+        }
+        return offset;
+    }
+
+    // true if the corner of the triangle vertex, a0, a1 and the corner of the
+    // triangle vertex, b0, b1 overlap. Both are projected onto the plane of the
+    // first, corners of steep triangles are left to the edge tests.
+    bool cornersOverlap(const Eigen::Vector3f &vertex,
+                        const Eigen::Vector3f &a0, const Eigen::Vector3f &a1,
+                        const Eigen::Vector3f &b0, const Eigen::Vector3f &b1) {
+        const float kMinCosine = 0.5f;
+        const float kEpsilon = 1e-3f;
+        Eigen::Vector3f normal = (a0 - vertex).cross(a1 - vertex);
+        Eigen::Vector3f otherNormal = (b0 - vertex).cross(b1 - vertex);
+        if (normal.norm() == 0.0f || otherNormal.norm() == 0.0f ||
+            std::fabs(normal.normalized().dot(otherNormal.normalized())) < kMinCosine) {
+            return false;
+        }
+        normal.normalize();
+        Eigen::Vector3f u = a0 - vertex;
+        u = (u - normal * normal.dot(u)).normalized();
+        Eigen::Vector3f v = normal.cross(u);
+
+        // the first corner spans [0, width], the second [start, start + otherWidth]
+        float width = std::atan2((a1 - vertex).dot(v), (a1 - vertex).dot(u));
+        float start = std::atan2((b0 - vertex).dot(v), (b0 - vertex).dot(u));
+        float otherWidth = std::atan2((b1 - vertex).dot(v), (b1 - vertex).dot(u)) - start;
+        if (otherWidth > M_PI) {
+            otherWidth -= 2 * M_PI;
+        } else if (otherWidth <= -M_PI) {
+            otherWidth += 2 * M_PI;
+        }
+        if (otherWidth < 0.0f) {
+            start += otherWidth;
+            otherWidth = -otherWidth;
+        }
+        if (start < 0.0f) {
+            start += 2 * M_PI;
+        }
+        return start < width - kEpsilon || start + otherWidth > 2 * M_PI + kEpsilon;
+    }
+}
+
+namespace constructnative {
+
+    IncrementalTriangulation::IncrementalTriangulation(int patchSize) : patchSize(patchSize) {
+    }
+
+    void IncrementalTriangulation::clear() {
+        knownVoxels = 0;
+        patchVoxels.clear();
+        patchTriangles.clear();
+    }
+
+    VoxelKey IncrementalTriangulation::patchOf(const VoxelAccumulator &accumulator,
+                                               int index) const {
+        const VoxelKey &voxel = accumulator.getKey(index);
+        VoxelKey patch;
+        patch.x = floorDivide(voxel.x, patchSize);
+        patch.y = floorDivide(voxel.y, patchSize);
+        patch.z = floorDivide(voxel.z, patchSize);
+        return patch;
+    }
+
+    bool IncrementalTriangulation::touches(const VoxelAccumulator &accumulator,
+                                           const Triangle &triangle,
+                                           const PatchSet &patches) const {
+        for (int i = 0; i < 3; ++i) {
+            if (patches.count(patchOf(accumulator, triangle.vertices[i])) > 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void IncrementalTriangulation::collectSeam(const PatchSet &patches, SeamMesh &seam) const {
+        for (PatchSet::const_iterator it = patches.begin(); it != patches.end(); ++it) {
+            std::unordered_map<VoxelKey, std::vector<Triangle>, VoxelKeyHasher>::const_iterator triangles =
+                    patchTriangles.find(*it);
+            if (triangles == patchTriangles.end()) {
+                continue;
+            }
+            for (size_t i = 0; i < triangles->second.size(); ++i) {
+                addToSeam(triangles->second[i], seam);
+            }
+        }
+    }
+
+    void IncrementalTriangulation::addToSeam(const Triangle &triangle, SeamMesh &seam) {
+        for (int i = 0; i < 3; ++i) {
+            int a = triangle.vertices[i];
+            int b = triangle.vertices[(i + 1) % 3];
+            seam.edges[edgeKey(a, b)].push_back(triangle.vertices[(i + 2) % 3]);
+            seam.fans[a].push_back(triangle);
+        }
+    }
+
+    bool IncrementalTriangulation::covers(const VoxelAccumulator &accumulator,
+                                          const Triangle &triangle,
+                                          const PatchSet &dirtyPatches,
+                                          const SeamMesh &seam) const {
+        const pcl::PointCloud<pcl::PointXYZ> &cloud = *accumulator.getCloud();
+        for (int i = 0; i < 3; ++i) {
+            int a = triangle.vertices[i];
+            int b = triangle.vertices[(i + 1) % 3];
+            int c = triangle.vertices[(i + 2) % 3];
+            std::unordered_map<uint64_t, std::vector<int> >::const_iterator edge =
+                    seam.edges.find(edgeKey(a, b));
+            if (edge == seam.edges.end()) {
+                // an edge between kept vertices which the kept mesh does not have
+                // cuts across its triangles
+                if (dirtyPatches.count(patchOf(accumulator, a)) == 0 &&
+                    dirtyPatches.count(patchOf(accumulator, b)) == 0) {
+                    return true;
+                }
+                continue;
+            }
+            if (edge->second.size() >= 2) {
+                return true;
+            }
+            // a triangle on the other side of the edge continues the surface, one
+            // on the same side overlaps it
+            int d = edge->second[0];
+            Eigen::Vector3f side = edgePerpendicular(cloud.points[a], cloud.points[b],
+                                                     cloud.points[c]);
+            Eigen::Vector3f otherSide = edgePerpendicular(cloud.points[a], cloud.points[b],
+                                                          cloud.points[d]);
+            if (c == d || side.dot(otherSide) > 0.0f) {
+                return true;
+            }
+        }
+
+        // triangles which only share a vertex
+        for (int i = 0; i < 3; ++i) {
+            int a = triangle.vertices[i];
+            std::unordered_map<int, std::vector<Triangle> >::const_iterator fan = seam.fans.find(a);
+            if (fan == seam.fans.end()) {
+                continue;
+            }
+            Eigen::Vector3f vertex = cloud.points[a].getVector3fMap();
+            Eigen::Vector3f a0 = cloud.points[triangle.vertices[(i + 1) % 3]].getVector3fMap();
+            Eigen::Vector3f a1 = cloud.points[triangle.vertices[(i + 2) % 3]].getVector3fMap();
+            for (size_t j = 0; j < fan->second.size(); ++j) {
+                const Triangle &other = fan->second[j];
+                int k = other.vertices[0] == a ? 0 : (other.vertices[1] == a ? 1 : 2);
+                Eigen::Vector3f b0 = cloud.points[other.vertices[(k + 1) % 3]].getVector3fMap();
+                Eigen::Vector3f b1 = cloud.points[other.vertices[(k + 2) % 3]].getVector3fMap();
+                if (cornersOverlap(vertex, a0, a1, b0, b1)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void IncrementalTriangulation::update(VoxelAccumulator &accumulator,
+                                          std::vector<float> &vertices) {
+        if (accumulator.getGeneration() != generation) {
+            clear();
+            generation = accumulator.getGeneration();
+        }
+        pcl::PointCloud<pcl::PointXYZ>::Ptr cloud = accumulator.getCloud();
+
+        // sort new voxels into their patches, everything is new after a clear
+        bool rebuild = knownVoxels == 0;
+        int voxelCount = cloud->points.size();
+        for (int i = knownVoxels; i < voxelCount; ++i) {
+            patchVoxels[patchOf(accumulator, i)].push_back(i);
+        }
+        knownVoxels = voxelCount;
+
+        std::vector<int> dirty;
+        accumulator.takeDirtyVoxels(dirty);
+        PatchSet dirtyPatches;
+        for (size_t i = 0; i < dirty.size(); ++i) {
+            dirtyPatches.insert(patchOf(accumulator, dirty[i]));
+        }
+        if (rebuild) {
+            for (std::unordered_map<VoxelKey, std::vector<int>, VoxelKeyHasher>::const_iterator it =
+                    patchVoxels.begin(); it != patchVoxels.end(); ++it) {
+                dirtyPatches.insert(it->first);
+            }
+        }
+
+        if (!dirtyPatches.empty()) {
+            long long before = currentTimeInMicroseconds();
+
+            // dirty patches and the ring around them
+            PatchSet regionPatches;
+            for (PatchSet::const_iterator it = dirtyPatches.begin(); it != dirtyPatches.end(); ++it) {
+                for (int x = -1; x <= 1; ++x) {
+                    for (int y = -1; y <= 1; ++y) {
+                        for (int z = -1; z <= 1; ++z) {
+                            VoxelKey neighbour = {it->x + x, it->y + y, it->z + z};
+                            regionPatches.insert(neighbour);
+                        }
+                    }
+                }
+            }
+
+            // remove triangles touching a dirty patch, they are owned by the
+            // dirty patches or their ring
+            std::vector<int> regionIndices;
+            for (PatchSet::const_iterator it = regionPatches.begin(); it != regionPatches.end(); ++it) {
+                std::unordered_map<VoxelKey, std::vector<Triangle>, VoxelKeyHasher>::iterator triangles =
+                        patchTriangles.find(*it);
+                if (triangles != patchTriangles.end()) {
+                    std::vector<Triangle> &list = triangles->second;
+                    list.erase(std::remove_if(list.begin(), list.end(),
+                                              [&](const Triangle &triangle) {
+                                                  return touches(accumulator, triangle,
+                                                                 dirtyPatches);
+                                              }), list.end());
+                }
+                std::unordered_map<VoxelKey, std::vector<int>, VoxelKeyHasher>::const_iterator voxels =
+                        patchVoxels.find(*it);
+                if (voxels != patchVoxels.end()) {
+                    regionIndices.insert(regionIndices.end(), voxels->second.begin(),
+                                         voxels->second.end());
+                }
+            }
+
+            // kept triangles next to the dirty patches, new triangles may only
+            // continue them on their open side
+            PatchSet borderPatches;
+            for (PatchSet::const_iterator it = regionPatches.begin(); it != regionPatches.end(); ++it) {
+                for (int x = -1; x <= 1; ++x) {
+                    for (int y = -1; y <= 1; ++y) {
+                        for (int z = -1; z <= 1; ++z) {
+                            VoxelKey neighbour = {it->x + x, it->y + y, it->z + z};
+                            borderPatches.insert(neighbour);
+                        }
+                    }
+                }
+            }
+            SeamMesh seam;
+            collectSeam(borderPatches, seam);
+
+            // triangulate the region and keep the triangles touching dirty patches,
+            // the ring only connects them to the remaining mesh
+            pcl::PointCloud<pcl::PointXYZ>::Ptr region(new pcl::PointCloud<pcl::PointXYZ>);
+            region->points.resize(regionIndices.size());
+            for (size_t i = 0; i < regionIndices.size(); ++i) {
+                region->points[i] = cloud->points[regionIndices[i]];
+            }
+            region->width = region->points.size();
+            region->height = 1;
+            pcl::PolygonMesh mesh;
+            triangulateWithNormals(region, mesh);
+            int added = 0;
+            for (size_t i = 0; i < mesh.polygons.size(); ++i) {
+                const std::vector<uint32_t> &indices = mesh.polygons[i].vertices;
+                if (indices.size() != 3) {
+                    continue;
+                }
+                Triangle triangle;
+                for (int j = 0; j < 3; ++j) {
+                    triangle.vertices[j] = regionIndices[indices[j]];
+                }
+                if (touches(accumulator, triangle, dirtyPatches) &&
+                    !covers(accumulator, triangle, dirtyPatches, seam)) {
+                    patchTriangles[patchOf(accumulator, triangle.vertices[0])].push_back(triangle);
+                    addToSeam(triangle, seam);
+                    added++;
+                }
+            }
+            LOGE("Re-meshed %d dirty patches with %d points into %d polygons in %lld us",
+                 dirtyPatches.size(), region->points.size(), added,
+                 currentTimeInMicroseconds() - before);
+        }
+
+        // the whole mesh with the current voxel centroids
+        vertices.clear();
+        for (std::unordered_map<VoxelKey, std::vector<Triangle>, VoxelKeyHasher>::const_iterator it =
+                patchTriangles.begin(); it != patchTriangles.end(); ++it) {
+            for (size_t i = 0; i < it->second.size(); ++i) {
+                for (int j = 0; j < 3; ++j) {
+                    const pcl::PointXYZ &point = cloud->points[it->second[i].vertices[j]];
+                    vertices.push_back(point.x);
+                    vertices.push_back(point.y);
+                    vertices.push_back(point.z);
+                }
+            }
+        }
+    }
+}
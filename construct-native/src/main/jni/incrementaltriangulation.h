@@ -0,0 +1,81 @@
+//
+// Region local greedy triangulation of a voxel accumulator.
+//
+
+#ifndef MASTERPROTOTYPE_INCREMENTALTRIANGULATION_H
+#define MASTERPROTOTYPE_INCREMENTALTRIANGULATION_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "voxelaccumulator.h"
+
+namespace constructnative {
+
+    // Keeps the greedy triangulation of an accumulator between calls. The grid
+    // is split into patches of voxels, only patches with dirty voxels are
+    // triangulated again. Their triangles are removed and GP3 runs on the dirty
+    // patches plus a ring of neighbour patches, so the new triangles connect to
+    // the old ones. At the seam new triangles may only continue the kept mesh
+    // at its open edges, triangles which would cover kept ones are dropped so the
+    // mesh stays manifold. Triangles refer to the stable voxel indices.
+    class IncrementalTriangulation {
+    public:
+        // @param patchSize: edge length of a patch in voxels, must be larger than
+        //                   the GP3 search radius
+        explicit IncrementalTriangulation(int patchSize);
+
+        // triangulates the changed regions and writes the whole mesh as x, y, z
+        // floats into vertices
+        void update(VoxelAccumulator &accumulator, std::vector<float> &vertices);
+
+        // drops the mesh
+        void clear();
+
+    private:
+        struct Triangle {
+            int vertices[3];
+        };
+
+        typedef std::unordered_set<VoxelKey, VoxelKeyHasher> PatchSet;
+        // triangles next to the re-meshed region, new triangles are tested
+        // against them
+        struct SeamMesh {
+            // opposite vertices of the triangles on an edge, by the edge key
+            std::unordered_map<uint64_t, std::vector<int> > edges;
+            // triangles around a vertex
+            std::unordered_map<int, std::vector<Triangle> > fans;
+        };
+
+        VoxelKey patchOf(const VoxelAccumulator &accumulator, int index) const;
+
+        bool touches(const VoxelAccumulator &accumulator, const Triangle &triangle,
+                     const PatchSet &patches) const;
+
+        // adds the triangles stored in patches to seam
+        void collectSeam(const PatchSet &patches, SeamMesh &seam) const;
+
+        static void addToSeam(const Triangle &triangle, SeamMesh &seam);
+
+        // true if the triangle would overlap the triangles of seam. It overlaps if
+        // it is the third one on an edge, lies on the same side of an edge as
+        // another one, has an edge between two vertices outside the dirty patches
+        // which is not an edge of the kept mesh, or one of its corners covers the
+        // corner of a triangle at the same vertex
+        bool covers(const VoxelAccumulator &accumulator, const Triangle &triangle,
+                    const PatchSet &dirtyPatches, const SeamMesh &seam) const;
+
+        int patchSize;
+        // accumulator generation and voxel count the patches were built for
+        int generation = -1;
+        int knownVoxels = 0;
+
+        std::unordered_map<VoxelKey, std::vector<int>, VoxelKeyHasher> patchVoxels;
+        // triangles by the patch of their first vertex
+        std::unordered_map<VoxelKey, std::vector<Triangle>, VoxelKeyHasher> patchTriangles;
+    };
+}
+
+#endif //MASTERPROTOTYPE_INCREMENTALTRIANGULATION_H
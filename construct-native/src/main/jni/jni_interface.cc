@@ -20,6 +20,9 @@
 
 static constructnative::GreedyApplication greedyApp;
 static constructnative::PlaneApplication planeApp;
+static constructnative::PlanarApplication planarApp;
+// downsampled points of all frames, with the leaf size of the voxel grid filter
+static constructnative::VoxelAccumulator accumulator(0.03f);
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,6 +40,81 @@ Java_de_stetro_master_constructnative_JNIInterface_reconstructPiecewisePlanes(
     return planeApp.reconstruct(env, vertices);
 }
 
+JNIEXPORT jfloatArray JNICALL
+Java_de_stetro_master_constructnative_JNIInterface_reconstructPlanar(
+        JNIEnv* env, jobject /*obj*/, jfloatArray vertices) {
+    return planarApp.reconstruct(env, vertices);
+}
+
+JNIEXPORT jintArray JNICALL
+Java_de_stetro_master_constructnative_JNIInterface_clusterKMeans(
+        JNIEnv* env, jobject /*obj*/, jfloatArray vertices, jint k, jint maxIterations,
+        jint seed) {
+    return constructnative::kMeansLabels(env, vertices, k, maxIterations,
+                                         static_cast<unsigned int>(seed));
+}
+
+JNIEXPORT jintArray JNICALL
+Java_de_stetro_master_constructnative_JNIInterface_clusterAgglomerative(
+        JNIEnv* env, jobject /*obj*/, jfloatArray vertices, jfloat maxDistance) {
+    return constructnative::agglomerativeLabels(env, vertices, maxDistance);
+}
+
+JNIEXPORT jfloatArray JNICALL
+Java_de_stetro_master_constructnative_JNIInterface_reconstructMarchingCubes(
+        JNIEnv* env, jobject /*obj*/, jfloatArray vertices, jfloat voxelSize) {
+    return constructnative::marchingCubesMesh(env, vertices, voxelSize);
+}
+
+JNIEXPORT jintArray JNICALL
+Java_de_stetro_master_constructnative_JNIInterface_triangulatePolygons(
+        JNIEnv* env, jobject /*obj*/, jfloatArray points, jintArray ringSizes,
+        jintArray ringsPerPolygon) {
+    return constructnative::polygonTriangles(env, points, ringSizes, ringsPerPolygon);
+}
+
+JNIEXPORT void JNICALL
+Java_de_stetro_master_constructnative_JNIInterface_accumulatePoints(
+        JNIEnv* env, jobject /*obj*/, jfloatArray vertices) {
+    int count = env->GetArrayLength(vertices) / 3;
+    jfloat* points = static_cast<jfloat*>(env->GetPrimitiveArrayCritical(vertices, NULL));
+    if (points == NULL) {
+        return;
+    }
+    accumulator.addPoints(points, count);
+    env->ReleasePrimitiveArrayCritical(vertices, points, JNI_ABORT);
+}
+
+JNIEXPORT void JNICALL
+Java_de_stetro_master_constructnative_JNIInterface_clearAccumulatedPoints(
+        JNIEnv* /*env*/, jobject /*obj*/) {
+    accumulator.clear();
+}
+
+JNIEXPORT jfloatArray JNICALL
+Java_de_stetro_master_constructnative_JNIInterface_reconstructAccumulatedWithGreedy(
+        JNIEnv* env, jobject /*obj*/) {
+    return greedyApp.reconstruct(env, accumulator);
+}
+
+JNIEXPORT jfloatArray JNICALL
+Java_de_stetro_master_constructnative_JNIInterface_reconstructAccumulatedPiecewisePlanes(
+        JNIEnv* env, jobject /*obj*/) {
+    return planeApp.reconstruct(env, accumulator);
+}
+
+JNIEXPORT void JNICALL
+Java_de_stetro_master_constructnative_JNIInterface_setIncrementalTriangulation(
+        JNIEnv* /*env*/, jobject /*obj*/, jboolean incremental) {
+    greedyApp.setIncremental(incremental == JNI_TRUE);
+}
+
+JNIEXPORT void JNICALL
+Java_de_stetro_master_constructnative_JNIInterface_setNormalEstimationThreads(
+        JNIEnv* /*env*/, jobject /*obj*/, jint threads) {
+    constructnative::setNormalEstimationThreads(threads);
+}
+
 #ifdef __cplusplus
 }
 #endif
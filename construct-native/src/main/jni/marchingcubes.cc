@@ -0,0 +1,424 @@
+//
+// Marching cubes over the occupied voxels of a point cloud.
+//
+#include "marchingcubes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "constructnative.h"
+
+namespace {
+    // voxel coordinates are packed into 20 bits per axis
+    const int kCoordinateBits = 20;
+    const int kCoordinateOffset = 1 << (kCoordinateBits - 1);
+    const uint64_t kCoordinateMask = (1u << kCoordinateBits) - 1;
+    // cubes handed to a thread at once, neighbouring cubes share their lookups
+    const int kSlabCubes = 1024;
+
+    // corners of a cube relative to its lowest corner
+    const int kCornerOffsets[8][3] = {
+            {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0},
+            {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}
+    };
+
+    // corners joined by the edges of a cube, in the numbering of the table
+    const int kEdgeCorners[12][2] = {
+            {0, 1}, {1, 2}, {2, 3}, {3, 0},
+            {4, 5}, {5, 6}, {6, 7}, {7, 4},
+            {0, 4}, {1, 5}, {3, 7}, {2, 6}
+    };
+
+    // triangles of every corner case as edge triples, terminated by -1. This
+    // is the table of the Java Cube, where edges 10 and 11 are swapped against
+    // the usual numbering.
+    const signed char kTriangleTable[256][16] = {
+            {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {1, 8, 3, 9, 8, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {1, 2, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {0, 8, 3, 1, 2, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {9, 2, 11, 0, 2, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {2, 8, 3, 2, 11, 8, 11, 9, 8, -1, -1, -1, -1, -1, -1, -1},
+            {3, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {0, 10, 2, 8, 10, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {1, 9, 0, 2, 3, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {1, 10, 2, 1, 9, 10, 9, 8, 10, -1, -1, -1, -1, -1, -1, -1},
+            {3, 11, 1, 10, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {0, 11, 1, 0, 8, 11, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1},
+            {3, 9, 0, 3, 10, 9, 10, 11, 9, -1, -1, -1, -1, -1, -1, -1},
+            {9, 8, 11, 11, 8, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {4, 3, 0, 7, 3, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {0, 1, 9, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {4, 1, 9, 4, 7, 1, 7, 3, 1, -1, -1, -1, -1, -1, -1, -1},
+            {1, 2, 11, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {3, 4, 7, 3, 0, 4, 1, 2, 11, -1, -1, -1, -1, -1, -1, -1},
+            {9, 2, 11, 9, 0, 2, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1},
+            {2, 11, 9, 2, 9, 7, 2, 7, 3, 7, 9, 4, -1, -1, -1, -1},
+            {8, 4, 7, 3, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {10, 4, 7, 10, 2, 4, 2, 0, 4, -1, -1, -1, -1, -1, -1, -1},
+            {9, 0, 1, 8, 4, 7, 2, 3, 10, -1, -1, -1, -1, -1, -1, -1},
+            {4, 7, 10, 9, 4, 10, 9, 10, 2, 9, 2, 1, -1, -1, -1, -1},
+            {3, 11, 1, 3, 10, 11, 7, 8, 4, -1, -1, -1, -1, -1, -1, -1},
+            {1, 10, 11, 1, 4, 10, 1, 0, 4, 7, 10, 4, -1, -1, -1, -1},
+            {4, 7, 8, 9, 0, 10, 9, 10, 11, 10, 0, 3, -1, -1, -1, -1},
+            {4, 7, 10, 4, 10, 9, 9, 10, 11, -1, -1, -1, -1, -1, -1, -1},
+            {9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {9, 5, 4, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {0, 5, 4, 1, 5, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {8, 5, 4, 8, 3, 5, 3, 1, 5, -1, -1, -1, -1, -1, -1, -1},
+            {1, 2, 11, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {3, 0, 8, 1, 2, 11, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1},
+            {5, 2, 11, 5, 4, 2, 4, 0, 2, -1, -1, -1, -1, -1, -1, -1},
+            {2, 11, 5, 3, 2, 5, 3, 5, 4, 3, 4, 8, -1, -1, -1, -1},
+            {9, 5, 4, 2, 3, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {0, 10, 2, 0, 8, 10, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1},
+            {0, 5, 4, 0, 1, 5, 2, 3, 10, -1, -1, -1, -1, -1, -1, -1},
+            {2, 1, 5, 2, 5, 8, 2, 8, 10, 4, 8, 5, -1, -1, -1, -1},
+            {11, 3, 10, 11, 1, 3, 9, 5, 4, -1, -1, -1, -1, -1, -1, -1},
+            {4, 9, 5, 0, 8, 1, 8, 11, 1, 8, 10, 11, -1, -1, -1, -1},
+            {5, 4, 0, 5, 0, 10, 5, 10, 11, 10, 0, 3, -1, -1, -1, -1},
+            {5, 4, 8, 5, 8, 11, 11, 8, 10, -1, -1, -1, -1, -1, -1, -1},
+            {9, 7, 8, 5, 7, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {9, 3, 0, 9, 5, 3, 5, 7, 3, -1, -1, -1, -1, -1, -1, -1},
+            {0, 7, 8, 0, 1, 7, 1, 5, 7, -1, -1, -1, -1, -1, -1, -1},
+            {1, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {9, 7, 8, 9, 5, 7, 11, 1, 2, -1, -1, -1, -1, -1, -1, -1},
+            {11, 1, 2, 9, 5, 0, 5, 3, 0, 5, 7, 3, -1, -1, -1, -1},
+            {8, 0, 2, 8, 2, 5, 8, 5, 7, 11, 5, 2, -1, -1, -1, -1},
+            {2, 11, 5, 2, 5, 3, 3, 5, 7, -1, -1, -1, -1, -1, -1, -1},
+            {7, 9, 5, 7, 8, 9, 3, 10, 2, -1, -1, -1, -1, -1, -1, -1},
+            {9, 5, 7, 9, 7, 2, 9, 2, 0, 2, 7, 10, -1, -1, -1, -1},
+            {2, 3, 10, 0, 1, 8, 1, 7, 8, 1, 5, 7, -1, -1, -1, -1},
+            {10, 2, 1, 10, 1, 7, 7, 1, 5, -1, -1, -1, -1, -1, -1, -1},
+            {9, 5, 8, 8, 5, 7, 11, 1, 3, 11, 3, 10, -1, -1, -1, -1},
+            {5, 7, 0, 5, 0, 9, 7, 10, 0, 1, 0, 11, 10, 11, 0, -1},
+            {10, 11, 0, 10, 0, 3, 11, 5, 0, 8, 0, 7, 5, 7, 0, -1},
+            {10, 11, 5, 7, 10, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {11, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {0, 8, 3, 5, 11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {9, 0, 1, 5, 11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {1, 8, 3, 1, 9, 8, 5, 11, 6, -1, -1, -1, -1, -1, -1, -1},
+            {1, 6, 5, 2, 6, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {1, 6, 5, 1, 2, 6, 3, 0, 8, -1, -1, -1, -1, -1, -1, -1},
+            {9, 6, 5, 9, 0, 6, 0, 2, 6, -1, -1, -1, -1, -1, -1, -1},
+            {5, 9, 8, 5, 8, 2, 5, 2, 6, 3, 2, 8, -1, -1, -1, -1},
+            {2, 3, 10, 11, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {10, 0, 8, 10, 2, 0, 11, 6, 5, -1, -1, -1, -1, -1, -1, -1},
+            {0, 1, 9, 2, 3, 10, 5, 11, 6, -1, -1, -1, -1, -1, -1, -1},
+            {5, 11, 6, 1, 9, 2, 9, 10, 2, 9, 8, 10, -1, -1, -1, -1},
+            {6, 3, 10, 6, 5, 3, 5, 1, 3, -1, -1, -1, -1, -1, -1, -1},
+            {0, 8, 10, 0, 10, 5, 0, 5, 1, 5, 10, 6, -1, -1, -1, -1},
+            {3, 10, 6, 0, 3, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1},
+            {6, 5, 9, 6, 9, 10, 10, 9, 8, -1, -1, -1, -1, -1, -1, -1},
+            {5, 11, 6, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {4, 3, 0, 4, 7, 3, 6, 5, 11, -1, -1, -1, -1, -1, -1, -1},
+            {1, 9, 0, 5, 11, 6, 8, 4, 7, -1, -1, -1, -1, -1, -1, -1},
+            {11, 6, 5, 1, 9, 7, 1, 7, 3, 7, 9, 4, -1, -1, -1, -1},
+            {6, 1, 2, 6, 5, 1, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1},
+            {1, 2, 5, 5, 2, 6, 3, 0, 4, 3, 4, 7, -1, -1, -1, -1},
+            {8, 4, 7, 9, 0, 5, 0, 6, 5, 0, 2, 6, -1, -1, -1, -1},
+            {7, 3, 9, 7, 9, 4, 3, 2, 9, 5, 9, 6, 2, 6, 9, -1},
+            {3, 10, 2, 7, 8, 4, 11, 6, 5, -1, -1, -1, -1, -1, -1, -1},
+            {5, 11, 6, 4, 7, 2, 4, 2, 0, 2, 7, 10, -1, -1, -1, -1},
+            {0, 1, 9, 4, 7, 8, 2, 3, 10, 5, 11, 6, -1, -1, -1, -1},
+            {9, 2, 1, 9, 10, 2, 9, 4, 10, 7, 10, 4, 5, 11, 6, -1},
+            {8, 4, 7, 3, 10, 5, 3, 5, 1, 5, 10, 6, -1, -1, -1, -1},
+            {5, 1, 10, 5, 10, 6, 1, 0, 10, 7, 10, 4, 0, 4, 10, -1},
+            {0, 5, 9, 0, 6, 5, 0, 3, 6, 10, 6, 3, 8, 4, 7, -1},
+            {6, 5, 9, 6, 9, 10, 4, 7, 9, 7, 10, 9, -1, -1, -1, -1},
+            {11, 4, 9, 6, 4, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {4, 11, 6, 4, 9, 11, 0, 8, 3, -1, -1, -1, -1, -1, -1, -1},
+            {11, 0, 1, 11, 6, 0, 6, 4, 0, -1, -1, -1, -1, -1, -1, -1},
+            {8, 3, 1, 8, 1, 6, 8, 6, 4, 6, 1, 11, -1, -1, -1, -1},
+            {1, 4, 9, 1, 2, 4, 2, 6, 4, -1, -1, -1, -1, -1, -1, -1},
+            {3, 0, 8, 1, 2, 9, 2, 4, 9, 2, 6, 4, -1, -1, -1, -1},
+            {0, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {8, 3, 2, 8, 2, 4, 4, 2, 6, -1, -1, -1, -1, -1, -1, -1},
+            {11, 4, 9, 11, 6, 4, 10, 2, 3, -1, -1, -1, -1, -1, -1, -1},
+            {0, 8, 2, 2, 8, 10, 4, 9, 11, 4, 11, 6, -1, -1, -1, -1},
+            {3, 10, 2, 0, 1, 6, 0, 6, 4, 6, 1, 11, -1, -1, -1, -1},
+            {6, 4, 1, 6, 1, 11, 4, 8, 1, 2, 1, 10, 8, 10, 1, -1},
+            {9, 6, 4, 9, 3, 6, 9, 1, 3, 10, 6, 3, -1, -1, -1, -1},
+            {8, 10, 1, 8, 1, 0, 10, 6, 1, 9, 1, 4, 6, 4, 1, -1},
+            {3, 10, 6, 3, 6, 0, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1},
+            {6, 4, 8, 10, 6, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {7, 11, 6, 7, 8, 11, 8, 9, 11, -1, -1, -1, -1, -1, -1, -1},
+            {0, 7, 3, 0, 11, 7, 0, 9, 11, 6, 7, 11, -1, -1, -1, -1},
+            {11, 6, 7, 1, 11, 7, 1, 7, 8, 1, 8, 0, -1, -1, -1, -1},
+            {11, 6, 7, 11, 7, 1, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1},
+            {1, 2, 6, 1, 6, 8, 1, 8, 9, 8, 6, 7, -1, -1, -1, -1},
+            {2, 6, 9, 2, 9, 1, 6, 7, 9, 0, 9, 3, 7, 3, 9, -1},
+            {7, 8, 0, 7, 0, 6, 6, 0, 2, -1, -1, -1, -1, -1, -1, -1},
+            {7, 3, 2, 6, 7, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {2, 3, 10, 11, 6, 8, 11, 8, 9, 8, 6, 7, -1, -1, -1, -1},
+            {2, 0, 7, 2, 7, 10, 0, 9, 7, 6, 7, 11, 9, 11, 7, -1},
+            {1, 8, 0, 1, 7, 8, 1, 11, 7, 6, 7, 11, 2, 3, 10, -1},
+            {10, 2, 1, 10, 1, 7, 11, 6, 1, 6, 7, 1, -1, -1, -1, -1},
+            {8, 9, 6, 8, 6, 7, 9, 1, 6, 10, 6, 3, 1, 3, 6, -1},
+            {0, 9, 1, 10, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {7, 8, 0, 7, 0, 6, 3, 10, 0, 10, 6, 0, -1, -1, -1, -1},
+            {7, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {7, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {3, 0, 8, 10, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {0, 1, 9, 10, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {8, 1, 9, 8, 3, 1, 10, 7, 6, -1, -1, -1, -1, -1, -1, -1},
+            {11, 1, 2, 6, 10, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {1, 2, 11, 3, 0, 8, 6, 10, 7, -1, -1, -1, -1, -1, -1, -1},
+            {2, 9, 0, 2, 11, 9, 6, 10, 7, -1, -1, -1, -1, -1, -1, -1},
+            {6, 10, 7, 2, 11, 3, 11, 8, 3, 11, 9, 8, -1, -1, -1, -1},
+            {7, 2, 3, 6, 2, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {7, 0, 8, 7, 6, 0, 6, 2, 0, -1, -1, -1, -1, -1, -1, -1},
+            {2, 7, 6, 2, 3, 7, 0, 1, 9, -1, -1, -1, -1, -1, -1, -1},
+            {1, 6, 2, 1, 8, 6, 1, 9, 8, 8, 7, 6, -1, -1, -1, -1},
+            {11, 7, 6, 11, 1, 7, 1, 3, 7, -1, -1, -1, -1, -1, -1, -1},
+            {11, 7, 6, 1, 7, 11, 1, 8, 7, 1, 0, 8, -1, -1, -1, -1},
+            {0, 3, 7, 0, 7, 11, 0, 11, 9, 6, 11, 7, -1, -1, -1, -1},
+            {7, 6, 11, 7, 11, 8, 8, 11, 9, -1, -1, -1, -1, -1, -1, -1},
+            {6, 8, 4, 10, 8, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {3, 6, 10, 3, 0, 6, 0, 4, 6, -1, -1, -1, -1, -1, -1, -1},
+            {8, 6, 10, 8, 4, 6, 9, 0, 1, -1, -1, -1, -1, -1, -1, -1},
+            {9, 4, 6, 9, 6, 3, 9, 3, 1, 10, 3, 6, -1, -1, -1, -1},
+            {6, 8, 4, 6, 10, 8, 2, 11, 1, -1, -1, -1, -1, -1, -1, -1},
+            {1, 2, 11, 3, 0, 10, 0, 6, 10, 0, 4, 6, -1, -1, -1, -1},
+            {4, 10, 8, 4, 6, 10, 0, 2, 9, 2, 11, 9, -1, -1, -1, -1},
+            {11, 9, 3, 11, 3, 2, 9, 4, 3, 10, 3, 6, 4, 6, 3, -1},
+            {8, 2, 3, 8, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1},
+            {0, 4, 2, 4, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {1, 9, 0, 2, 3, 4, 2, 4, 6, 4, 3, 8, -1, -1, -1, -1},
+            {1, 9, 4, 1, 4, 2, 2, 4, 6, -1, -1, -1, -1, -1, -1, -1},
+            {8, 1, 3, 8, 6, 1, 8, 4, 6, 6, 11, 1, -1, -1, -1, -1},
+            {11, 1, 0, 11, 0, 6, 6, 0, 4, -1, -1, -1, -1, -1, -1, -1},
+            {4, 6, 3, 4, 3, 8, 6, 11, 3, 0, 3, 9, 11, 9, 3, -1},
+            {11, 9, 4, 6, 11, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {4, 9, 5, 7, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {0, 8, 3, 4, 9, 5, 10, 7, 6, -1, -1, -1, -1, -1, -1, -1},
+            {5, 0, 1, 5, 4, 0, 7, 6, 10, -1, -1, -1, -1, -1, -1, -1},
+            {10, 7, 6, 8, 3, 4, 3, 5, 4, 3, 1, 5, -1, -1, -1, -1},
+            {9, 5, 4, 11, 1, 2, 7, 6, 10, -1, -1, -1, -1, -1, -1, -1},
+            {6, 10, 7, 1, 2, 11, 0, 8, 3, 4, 9, 5, -1, -1, -1, -1},
+            {7, 6, 10, 5, 4, 11, 4, 2, 11, 4, 0, 2, -1, -1, -1, -1},
+            {3, 4, 8, 3, 5, 4, 3, 2, 5, 11, 5, 2, 10, 7, 6, -1},
+            {7, 2, 3, 7, 6, 2, 5, 4, 9, -1, -1, -1, -1, -1, -1, -1},
+            {9, 5, 4, 0, 8, 6, 0, 6, 2, 6, 8, 7, -1, -1, -1, -1},
+            {3, 6, 2, 3, 7, 6, 1, 5, 0, 5, 4, 0, -1, -1, -1, -1},
+            {6, 2, 8, 6, 8, 7, 2, 1, 8, 4, 8, 5, 1, 5, 8, -1},
+            {9, 5, 4, 11, 1, 6, 1, 7, 6, 1, 3, 7, -1, -1, -1, -1},
+            {1, 6, 11, 1, 7, 6, 1, 0, 7, 8, 7, 0, 9, 5, 4, -1},
+            {4, 0, 11, 4, 11, 5, 0, 3, 11, 6, 11, 7, 3, 7, 11, -1},
+            {7, 6, 11, 7, 11, 8, 5, 4, 11, 4, 8, 11, -1, -1, -1, -1},
+            {6, 9, 5, 6, 10, 9, 10, 8, 9, -1, -1, -1, -1, -1, -1, -1},
+            {3, 6, 10, 0, 6, 3, 0, 5, 6, 0, 9, 5, -1, -1, -1, -1},
+            {0, 10, 8, 0, 5, 10, 0, 1, 5, 5, 6, 10, -1, -1, -1, -1},
+            {6, 10, 3, 6, 3, 5, 5, 3, 1, -1, -1, -1, -1, -1, -1, -1},
+            {1, 2, 11, 9, 5, 10, 9, 10, 8, 10, 5, 6, -1, -1, -1, -1},
+            {0, 10, 3, 0, 6, 10, 0, 9, 6, 5, 6, 9, 1, 2, 11, -1},
+            {10, 8, 5, 10, 5, 6, 8, 0, 5, 11, 5, 2, 0, 2, 5, -1},
+            {6, 10, 3, 6, 3, 5, 2, 11, 3, 11, 5, 3, -1, -1, -1, -1},
+            {5, 8, 9, 5, 2, 8, 5, 6, 2, 3, 8, 2, -1, -1, -1, -1},
+            {9, 5, 6, 9, 6, 0, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1},
+            {1, 5, 8, 1, 8, 0, 5, 6, 8, 3, 8, 2, 6, 2, 8, -1},
+            {1, 5, 6, 2, 1, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {1, 3, 6, 1, 6, 11, 3, 8, 6, 5, 6, 9, 8, 9, 6, -1},
+            {11, 1, 0, 11, 0, 6, 9, 5, 0, 5, 6, 0, -1, -1, -1, -1},
+            {0, 3, 8, 5, 6, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {11, 5, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {10, 5, 11, 7, 5, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {10, 5, 11, 10, 7, 5, 8, 3, 0, -1, -1, -1, -1, -1, -1, -1},
+            {5, 10, 7, 5, 11, 10, 1, 9, 0, -1, -1, -1, -1, -1, -1, -1},
+            {11, 7, 5, 11, 10, 7, 9, 8, 1, 8, 3, 1, -1, -1, -1, -1},
+            {10, 1, 2, 10, 7, 1, 7, 5, 1, -1, -1, -1, -1, -1, -1, -1},
+            {0, 8, 3, 1, 2, 7, 1, 7, 5, 7, 2, 10, -1, -1, -1, -1},
+            {9, 7, 5, 9, 2, 7, 9, 0, 2, 2, 10, 7, -1, -1, -1, -1},
+            {7, 5, 2, 7, 2, 10, 5, 9, 2, 3, 2, 8, 9, 8, 2, -1},
+            {2, 5, 11, 2, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1},
+            {8, 2, 0, 8, 5, 2, 8, 7, 5, 11, 2, 5, -1, -1, -1, -1},
+            {9, 0, 1, 5, 11, 3, 5, 3, 7, 3, 11, 2, -1, -1, -1, -1},
+            {9, 8, 2, 9, 2, 1, 8, 7, 2, 11, 2, 5, 7, 5, 2, -1},
+            {1, 3, 5, 3, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {0, 8, 7, 0, 7, 1, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1},
+            {9, 0, 3, 9, 3, 5, 5, 3, 7, -1, -1, -1, -1, -1, -1, -1},
+            {9, 8, 7, 5, 9, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {5, 8, 4, 5, 11, 8, 11, 10, 8, -1, -1, -1, -1, -1, -1, -1},
+            {5, 0, 4, 5, 10, 0, 5, 11, 10, 10, 3, 0, -1, -1, -1, -1},
+            {0, 1, 9, 8, 4, 11, 8, 11, 10, 11, 4, 5, -1, -1, -1, -1},
+            {11, 10, 4, 11, 4, 5, 10, 3, 4, 9, 4, 1, 3, 1, 4, -1},
+            {2, 5, 1, 2, 8, 5, 2, 10, 8, 4, 5, 8, -1, -1, -1, -1},
+            {0, 4, 10, 0, 10, 3, 4, 5, 10, 2, 10, 1, 5, 1, 10, -1},
+            {0, 2, 5, 0, 5, 9, 2, 10, 5, 4, 5, 8, 10, 8, 5, -1},
+            {9, 4, 5, 2, 10, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {2, 5, 11, 3, 5, 2, 3, 4, 5, 3, 8, 4, -1, -1, -1, -1},
+            {5, 11, 2, 5, 2, 4, 4, 2, 0, -1, -1, -1, -1, -1, -1, -1},
+            {3, 11, 2, 3, 5, 11, 3, 8, 5, 4, 5, 8, 0, 1, 9, -1},
+            {5, 11, 2, 5, 2, 4, 1, 9, 2, 9, 4, 2, -1, -1, -1, -1},
+            {8, 4, 5, 8, 5, 3, 3, 5, 1, -1, -1, -1, -1, -1, -1, -1},
+            {0, 4, 5, 1, 0, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {8, 4, 5, 8, 5, 3, 9, 0, 5, 0, 3, 5, -1, -1, -1, -1},
+            {9, 4, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {4, 10, 7, 4, 9, 10, 9, 11, 10, -1, -1, -1, -1, -1, -1, -1},
+            {0, 8, 3, 4, 9, 7, 9, 10, 7, 9, 11, 10, -1, -1, -1, -1},
+            {1, 11, 10, 1, 10, 4, 1, 4, 0, 7, 4, 10, -1, -1, -1, -1},
+            {3, 1, 4, 3, 4, 8, 1, 11, 4, 7, 4, 10, 11, 10, 4, -1},
+            {4, 10, 7, 9, 10, 4, 9, 2, 10, 9, 1, 2, -1, -1, -1, -1},
+            {9, 7, 4, 9, 10, 7, 9, 1, 10, 2, 10, 1, 0, 8, 3, -1},
+            {10, 7, 4, 10, 4, 2, 2, 4, 0, -1, -1, -1, -1, -1, -1, -1},
+            {10, 7, 4, 10, 4, 2, 8, 3, 4, 3, 2, 4, -1, -1, -1, -1},
+            {2, 9, 11, 2, 7, 9, 2, 3, 7, 7, 4, 9, -1, -1, -1, -1},
+            {9, 11, 7, 9, 7, 4, 11, 2, 7, 8, 7, 0, 2, 0, 7, -1},
+            {3, 7, 11, 3, 11, 2, 7, 4, 11, 1, 11, 0, 4, 0, 11, -1},
+            {1, 11, 2, 8, 7, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {4, 9, 1, 4, 1, 7, 7, 1, 3, -1, -1, -1, -1, -1, -1, -1},
+            {4, 9, 1, 4, 1, 7, 0, 8, 1, 8, 7, 1, -1, -1, -1, -1},
+            {4, 0, 3, 7, 4, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {9, 11, 8, 11, 10, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {3, 0, 9, 3, 9, 10, 10, 9, 11, -1, -1, -1, -1, -1, -1, -1},
+            {0, 1, 11, 0, 11, 8, 8, 11, 10, -1, -1, -1, -1, -1, -1, -1},
+            {3, 1, 11, 10, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {1, 2, 10, 1, 10, 9, 9, 10, 8, -1, -1, -1, -1, -1, -1, -1},
+            {3, 0, 9, 3, 9, 10, 1, 2, 9, 2, 10, 9, -1, -1, -1, -1},
+            {0, 2, 10, 8, 0, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {3, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {2, 3, 8, 2, 8, 11, 11, 8, 9, -1, -1, -1, -1, -1, -1, -1},
+            {9, 11, 2, 0, 9, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {2, 3, 8, 2, 8, 11, 0, 1, 8, 1, 11, 8, -1, -1, -1, -1},
+            {1, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {1, 3, 8, 9, 1, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {0, 9, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {0, 3, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+            {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}
+    };
+
+    uint64_t pack(int x, int y, int z) {
+        return (static_cast<uint64_t>(z + kCoordinateOffset) & kCoordinateMask) << (2 * kCoordinateBits) |
+               (static_cast<uint64_t>(y + kCoordinateOffset) & kCoordinateMask) << kCoordinateBits |
+               (static_cast<uint64_t>(x + kCoordinateOffset) & kCoordinateMask);
+    }
+
+    void unpack(uint64_t key, int *coordinates) {
+        coordinates[0] = static_cast<int>(key & kCoordinateMask) - kCoordinateOffset;
+        coordinates[1] = static_cast<int>((key >> kCoordinateBits) & kCoordinateMask) - kCoordinateOffset;
+        coordinates[2] = static_cast<int>((key >> (2 * kCoordinateBits)) & kCoordinateMask) - kCoordinateOffset;
+    }
+
+    // an edge is identified by its lower corner and its axis in the top bits
+    uint64_t edgeKey(const int *cube, int edge) {
+        const int *a = kCornerOffsets[kEdgeCorners[edge][0]];
+        const int *b = kCornerOffsets[kEdgeCorners[edge][1]];
+        int axis = a[0] != b[0] ? 0 : (a[1] != b[1] ? 1 : 2);
+        uint64_t lower = pack(cube[0] + std::min(a[0], b[0]), cube[1] + std::min(a[1], b[1]),
+                              cube[2] + std::min(a[2], b[2]));
+        return lower | static_cast<uint64_t>(axis) << (3 * kCoordinateBits);
+    }
+
+    struct KeyHasher {
+        size_t operator()(uint64_t key) const {
+            return static_cast<size_t>(key ^ (key >> 29) ^ (key >> 47));
+        }
+    };
+}
+
+namespace constructnative {
+
+    MarchingCubes::MarchingCubes(float voxelSize) : voxelSize(voxelSize) {
+    }
+
+    void MarchingCubes::reconstruct(const float *points, int count, std::vector<float> &vertices,
+                                    std::vector<int> &indices) const {
+        vertices.clear();
+        indices.clear();
+        long long before = currentTimeInMicroseconds();
+
+        // hashed occupancy of the voxels
+        float inverseVoxelSize = 1.0f / voxelSize;
+        float limit = static_cast<float>(kCoordinateOffset - 2);
+        std::unordered_set<uint64_t, KeyHasher> occupied;
+        occupied.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            float x = std::floor(points[i * 3] * inverseVoxelSize);
+            float y = std::floor(points[i * 3 + 1] * inverseVoxelSize);
+            float z = std::floor(points[i * 3 + 2] * inverseVoxelSize);
+            // also drops NaN
+            if (!(std::fabs(x) < limit && std::fabs(y) < limit && std::fabs(z) < limit)) {
+                continue;
+            }
+            occupied.insert(pack(static_cast<int>(x), static_cast<int>(y), static_cast<int>(z)));
+        }
+
+        // every occupied voxel is a corner of eight cubes, sorting the packed keys
+        // orders the cubes in z slabs
+        std::vector<uint64_t> cubes;
+        cubes.reserve(occupied.size() * 8);
+        int voxel[3];
+        for (std::unordered_set<uint64_t, KeyHasher>::const_iterator it = occupied.begin();
+             it != occupied.end(); ++it) {
+            unpack(*it, voxel);
+            for (int corner = 0; corner < 8; ++corner) {
+                cubes.push_back(pack(voxel[0] - kCornerOffsets[corner][0],
+                                     voxel[1] - kCornerOffsets[corner][1],
+                                     voxel[2] - kCornerOffsets[corner][2]));
+            }
+        }
+        std::sort(cubes.begin(), cubes.end());
+        cubes.erase(std::unique(cubes.begin(), cubes.end()), cubes.end());
+
+        // triangles as edge keys, collected per slab so the order is stable
+        int cubeCount = static_cast<int>(cubes.size());
+        int slabCount = (cubeCount + kSlabCubes - 1) / kSlabCubes;
+        std::vector<std::vector<uint64_t> > slabTriangles(slabCount);
+#pragma omp parallel for schedule(dynamic)
+        for (int slab = 0; slab < slabCount; ++slab) {
+            std::vector<uint64_t> &triangles = slabTriangles[slab];
+            int end = std::min(cubeCount, (slab + 1) * kSlabCubes);
+            int cube[3];
+            for (int c = slab * kSlabCubes; c < end; ++c) {
+                unpack(cubes[c], cube);
+                int caseIndex = 0;
+                for (int corner = 0; corner < 8; ++corner) {
+                    uint64_t key = pack(cube[0] + kCornerOffsets[corner][0],
+                                        cube[1] + kCornerOffsets[corner][1],
+                                        cube[2] + kCornerOffsets[corner][2]);
+                    caseIndex |= static_cast<int>(occupied.count(key)) << corner;
+                }
+                // the table winds around occupied corners, so the triangles are
+                // reversed to face away from the occupied voxels
+                const signed char *edges = kTriangleTable[caseIndex];
+                for (int e = 0; edges[e] >= 0; e += 3) {
+                    triangles.push_back(edgeKey(cube, edges[e + 2]));
+                    triangles.push_back(edgeKey(cube, edges[e + 1]));
+                    triangles.push_back(edgeKey(cube, edges[e]));
+                }
+            }
+        }
+
+        // one vertex per distinct edge, in the middle between two voxel centers
+        std::unordered_map<uint64_t, int, KeyHasher> edgeVertices;
+        int edge[3];
+        for (int slab = 0; slab < slabCount; ++slab) {
+            const std::vector<uint64_t> &triangles = slabTriangles[slab];
+            for (size_t t = 0; t < triangles.size(); ++t) {
+                std::pair<std::unordered_map<uint64_t, int, KeyHasher>::iterator, bool> vertex =
+                        edgeVertices.insert(std::make_pair(triangles[t],
+                                                           static_cast<int>(vertices.size() / 3)));
+                if (vertex.second) {
+                    uint64_t key = triangles[t];
+                    unpack(key, edge);
+                    int axis = static_cast<int>(key >> (3 * kCoordinateBits));
+                    for (int i = 0; i < 3; ++i) {
+                        float center = (edge[i] + 0.5f + (i == axis ? 0.5f : 0.0f)) * voxelSize;
+                        vertices.push_back(center);
+                    }
+                }
+                indices.push_back(vertex.first->second);
+            }
+        }
+        LOGE("Marched %d cubes of %d voxels into %d triangles with %d vertices in %lld us",
+             cubeCount, occupied.size(), indices.size() / 3, vertices.size() / 3,
+             currentTimeInMicroseconds() - before);
+    }
+}
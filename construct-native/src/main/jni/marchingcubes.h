@@ -0,0 +1,36 @@
+//
+// Marching cubes over the occupied voxels of a point cloud.
+//
+
+#ifndef MASTERPROTOTYPE_MARCHINGCUBES_H
+#define MASTERPROTOTYPE_MARCHINGCUBES_H
+
+#include <vector>
+
+namespace constructnative {
+
+    // Meshes the surface around all voxels which contain a point. The voxel
+    // centers form the lattice of the cubes, a corner is inside if its voxel is
+    // occupied. Only cubes next to an occupied voxel are visited, they are
+    // sorted into z slabs which are processed on all cores. Triangle corners lie
+    // on cube edges, every edge gets one shared vertex.
+    class MarchingCubes {
+    public:
+        // @param voxelSize: edge length of the voxels and the cubes
+        explicit MarchingCubes(float voxelSize);
+
+        // meshes count points given as x, y, z floats
+        //
+        // @param vertices: gets the shared vertices as x, y, z floats
+        // @param indices: gets three vertex indices per triangle
+        void reconstruct(const float *points, int count, std::vector<float> &vertices,
+                         std::vector<int> &indices) const;
+
+        float getVoxelSize() const { return voxelSize; }
+
+    private:
+        float voxelSize;
+    };
+}
+
+#endif //MASTERPROTOTYPE_MARCHINGCUBES_H
@@ -0,0 +1,260 @@
+//
+// Planar reconstruction of a complete cloud over flat float buffers.
+//
+#include "planarreconstruction.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <Eigen/Eigenvalues>
+#include <Eigen/Geometry>
+
+#include "clustering.h"
+#include "constructnative.h"
+#include "polygontriangulation.h"
+
+namespace {
+    using constructnative::Point2D;
+    using constructnative::Polygon2D;
+    using constructnative::VoxelKey;
+    using constructnative::VoxelKeyHasher;
+
+    VoxelKey cellOf(const float *point, float size) {
+        VoxelKey key;
+        key.x = static_cast<int>(std::floor(point[0] / size));
+        key.y = static_cast<int>(std::floor(point[1] / size));
+        key.z = static_cast<int>(std::floor(point[2] / size));
+        return key;
+    }
+
+    float cross(const Point2D &o, const Point2D &a, const Point2D &b) {
+        return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+    }
+
+    // plane in hesse normal form with an orthonormal basis for projections
+    struct HessePlane {
+        Eigen::Vector3f normal;
+        float distance;
+        Eigen::Vector3f u;
+        Eigen::Vector3f v;
+
+        HessePlane(const Eigen::Vector3f &normal, float distance) :
+                normal(normal), distance(distance) {
+            Eigen::Vector3f helper = std::fabs(normal.x()) < 0.9f ? Eigen::Vector3f::UnitX()
+                                                                  : Eigen::Vector3f::UnitY();
+            u = normal.cross(helper).normalized();
+            v = normal.cross(u);
+        }
+
+        float distanceTo(const Eigen::Vector3f &point) const {
+            return std::fabs(normal.dot(point) - distance);
+        }
+
+        Point2D project(const Eigen::Vector3f &point) const {
+            Point2D projected = {point.dot(u), point.dot(v)};
+            return projected;
+        }
+
+        Eigen::Vector3f unproject(const Point2D &point) const {
+            return distance * normal + point.x * u + point.y * v;
+        }
+    };
+
+    // least squares plane through points, the normal is the eigenvector of the
+    // smallest eigenvalue of the covariance
+    HessePlane planeRegression(const std::vector<Eigen::Vector3f> &points) {
+        Eigen::Vector3f mean = Eigen::Vector3f::Zero();
+        for (size_t i = 0; i < points.size(); ++i) {
+            mean += points[i];
+        }
+        mean /= static_cast<float>(points.size());
+        Eigen::Matrix3f covariance = Eigen::Matrix3f::Zero();
+        for (size_t i = 0; i < points.size(); ++i) {
+            Eigen::Vector3f p = points[i] - mean;
+            covariance += p * p.transpose();
+        }
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f> solver(covariance);
+        Eigen::Vector3f normal = solver.eigenvectors().col(0).normalized();
+        return HessePlane(normal, normal.dot(mean));
+    }
+
+    // splits points into inliers and outliers of plane
+    void splitPoints(const HessePlane &plane, float threshold,
+                     const std::vector<Eigen::Vector3f> &points,
+                     std::vector<Eigen::Vector3f> &supporting,
+                     std::vector<Eigen::Vector3f> &notSupporting) {
+        supporting.clear();
+        notSupporting.clear();
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (plane.distanceTo(points[i]) <= threshold) {
+                supporting.push_back(points[i]);
+            } else {
+                notSupporting.push_back(points[i]);
+            }
+        }
+    }
+
+    // RANSAC over points, stops early when sufficientSupport points are within
+    // threshold. Returns false if every sample was degenerate.
+    bool detectPlane(const std::vector<Eigen::Vector3f> &points, float threshold,
+                     int iterations, size_t sufficientSupport, std::minstd_rand &random,
+                     HessePlane &best) {
+        std::uniform_int_distribution<size_t> pick(0, points.size() - 1);
+        size_t bestSupport = 0;
+        for (int iteration = 0; iteration < iterations && bestSupport < sufficientSupport;
+             ++iteration) {
+            size_t a = pick(random), b = pick(random), c = pick(random);
+            Eigen::Vector3f normal = (points[b] - points[a]).cross(points[c] - points[a]);
+            float length = normal.norm();
+            if (length < 1e-9f) {
+                continue;
+            }
+            normal /= length;
+            HessePlane plane(normal, normal.dot(points[a]));
+            size_t support = 0;
+            for (size_t i = 0; i < points.size(); ++i) {
+                support += plane.distanceTo(points[i]) <= threshold;
+            }
+            if (support > bestSupport) {
+                bestSupport = support;
+                best = plane;
+            }
+        }
+        return bestSupport > 0;
+    }
+
+    // appends the Delaunay triangulation of the convex hull of points in plane
+    // coordinates
+    void meshRegion(const HessePlane &plane, const std::vector<Point2D> &projection,
+                    std::vector<float> &vertices) {
+        std::vector<Point2D> hull = constructnative::convexHull(projection);
+        Polygon2D polygon;
+        polygon.ringSizes.push_back(static_cast<int>(hull.size()));
+        for (size_t i = 0; i < hull.size(); ++i) {
+            polygon.points.push_back(hull[i].x);
+            polygon.points.push_back(hull[i].y);
+        }
+        std::vector<int> triangles;
+        constructnative::triangulatePolygon(polygon, triangles);
+        for (size_t i = 0; i < triangles.size(); ++i) {
+            Eigen::Vector3f p = plane.unproject(hull[triangles[i]]);
+            vertices.push_back(p.x());
+            vertices.push_back(p.y());
+            vertices.push_back(p.z());
+        }
+    }
+}
+
+namespace constructnative {
+
+    std::vector<Point2D> convexHull(std::vector<Point2D> points) {
+        std::sort(points.begin(), points.end(), [](const Point2D &a, const Point2D &b) {
+            return a.x < b.x || (a.x == b.x && a.y < b.y);
+        });
+        if (points.size() < 3) {
+            return points;
+        }
+        std::vector<Point2D> hull(points.size() * 2);
+        int k = 0;
+        for (size_t i = 0; i < points.size(); ++i) {
+            while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0) {
+                k--;
+            }
+            hull[k++] = points[i];
+        }
+        for (int i = static_cast<int>(points.size()) - 2, lower = k + 1; i >= 0; --i) {
+            while (k >= lower && cross(hull[k - 2], hull[k - 1], points[i]) <= 0) {
+                k--;
+            }
+            hull[k++] = points[i];
+        }
+        hull.resize(k - 1);
+        return hull;
+    }
+
+    PlanarReconstruction::PlanarReconstruction() {
+    }
+
+    void PlanarReconstruction::reconstruct(const float *points, int count,
+                                           std::vector<float> &vertices) const {
+        vertices.clear();
+        long long before = currentTimeInMicroseconds();
+
+        // keep one point per cell and sort the points into their clusters
+        std::unordered_set<VoxelKey, VoxelKeyHasher> occupied;
+        std::unordered_map<VoxelKey, int, VoxelKeyHasher> clusterIndices;
+        std::vector<std::vector<Eigen::Vector3f> > clusters;
+        for (int i = 0; i < count; ++i) {
+            const float *point = points + i * 3;
+            if (!occupied.insert(cellOf(point, config.pointSpacing)).second) {
+                continue;
+            }
+            std::pair<std::unordered_map<VoxelKey, int, VoxelKeyHasher>::iterator, bool> cluster =
+                    clusterIndices.insert(std::make_pair(cellOf(point, config.clusterSize),
+                                                         static_cast<int>(clusters.size())));
+            if (cluster.second) {
+                clusters.push_back(std::vector<Eigen::Vector3f>());
+            }
+            clusters[cluster.first->second].push_back(Eigen::Vector3f(point[0], point[1], point[2]));
+        }
+        LOGI("Sorted %d of %d points into %d clusters", occupied.size(), count, clusters.size());
+
+        // clusters differ a lot in size, so they are handed out one by one
+        std::vector<std::vector<float> > clusterMeshes(clusters.size());
+        int clusterCount = static_cast<int>(clusters.size());
+#pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < clusterCount; ++i) {
+            reconstructCluster(clusters[i], static_cast<unsigned int>(i + 1), clusterMeshes[i]);
+        }
+        for (size_t i = 0; i < clusterMeshes.size(); ++i) {
+            vertices.insert(vertices.end(), clusterMeshes[i].begin(), clusterMeshes[i].end());
+        }
+        LOGE("Reconstructed %d polygons from %d clusters in %lld us", vertices.size() / 9,
+             clusters.size(), currentTimeInMicroseconds() - before);
+    }
+
+    void PlanarReconstruction::reconstructCluster(std::vector<Eigen::Vector3f> &points,
+                                                  unsigned int seed,
+                                                  std::vector<float> &vertices) const {
+        std::minstd_rand random(seed);
+        std::vector<Eigen::Vector3f> supporting, notSupporting;
+        std::vector<int> labels;
+        std::vector<float> centroids;
+        std::vector<std::vector<Point2D> > regions;
+        for (int i = 0; i < config.maxPlanes && points.size() >= 4; ++i) {
+            size_t sufficientSupport = static_cast<size_t>(points.size() * config.ransacSufficientSupport);
+            HessePlane plane(Eigen::Vector3f::UnitZ(), 0.0f);
+            if (!detectPlane(points, config.ransacThreshold, config.ransacIterations,
+                             sufficientSupport, random, plane)) {
+                break;
+            }
+            // refine with the inliers and take the inliers of the refined plane
+            splitPoints(plane, config.ransacThreshold, points, supporting, notSupporting);
+            if (supporting.size() >= 3) {
+                plane = planeRegression(supporting);
+                splitPoints(plane, config.ransacThreshold, points, supporting, notSupporting);
+            }
+            points.swap(notSupporting);
+            if (supporting.size() < sufficientSupport || supporting.size() < 4) {
+                continue;
+            }
+
+            // separate regions of the plane get their own polygon
+            // the vectors are packed x, y, z floats, so they are clustered in place
+            kMeansClustering(supporting[0].data(), static_cast<int>(supporting.size()),
+                             config.regionsPerPlane, config.maxRegionIterations, random(),
+                             labels, centroids);
+            regions.assign(config.regionsPerPlane, std::vector<Point2D>());
+            for (size_t j = 0; j < supporting.size(); ++j) {
+                regions[labels[j]].push_back(plane.project(supporting[j]));
+            }
+            for (size_t j = 0; j < regions.size(); ++j) {
+                if (static_cast<int>(regions[j].size()) >= config.minRegionPoints) {
+                    meshRegion(plane, regions[j], vertices);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,65 @@
+//
+// Planar reconstruction of a complete cloud over flat float buffers.
+//
+
+#ifndef MASTERPROTOTYPE_PLANARRECONSTRUCTION_H
+#define MASTERPROTOTYPE_PLANARRECONSTRUCTION_H
+
+#include <vector>
+#include <Eigen/Core>
+
+namespace constructnative {
+
+    struct Point2D {
+        float x;
+        float y;
+    };
+
+    // convex hull with Andrew's monotone chain, counter clockwise
+    std::vector<Point2D> convexHull(std::vector<Point2D> points);
+
+    struct PlanarReconstructionConfig {
+        // edge length of the spatial clusters, the depth 7 nodes of the 40 m tree
+        float clusterSize = 1.25f;
+        // only one point per cell of this size is used, the leaves of the tree
+        float pointSpacing = 40.0f / 2048;
+        // planes searched per cluster
+        int maxPlanes = 3;
+        float ransacThreshold = 0.06f;
+        int ransacIterations = 10;
+        // fraction of the remaining points which has to support a plane
+        float ransacSufficientSupport = 0.3f;
+        // k of the k-means which splits a plane into separate regions
+        int regionsPerPlane = 3;
+        int maxRegionIterations = 50;
+        // regions with less points get no polygon
+        int minRegionPoints = 5;
+    };
+
+    // The planar pipeline of the construct app without boxing points. The cloud
+    // is split into cubic clusters, each cluster gets up to maxPlanes RANSAC
+    // planes, the inliers of a plane are split into regions with k-means and
+    // every region is meshed as the convex hull in plane coordinates. Clusters
+    // are independent and reconstructed on all cores.
+    class PlanarReconstruction {
+    public:
+        PlanarReconstruction();
+
+        void setConfig(const PlanarReconstructionConfig &config) { this->config = config; }
+
+        const PlanarReconstructionConfig &getConfig() const { return config; }
+
+        // reconstructs count points given as x, y, z floats and writes the
+        // triangles as x, y, z floats into vertices
+        void reconstruct(const float *points, int count, std::vector<float> &vertices) const;
+
+    private:
+        // detects the planes of one cluster and appends their regions to vertices
+        void reconstructCluster(std::vector<Eigen::Vector3f> &points, unsigned int seed,
+                                std::vector<float> &vertices) const;
+
+        PlanarReconstructionConfig config;
+    };
+}
+
+#endif //MASTERPROTOTYPE_PLANARRECONSTRUCTION_H
@@ -0,0 +1,414 @@
+//
+// Constrained Delaunay triangulation of plane polygons with holes.
+//
+#include "polygontriangulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace {
+    using constructnative::Polygon2D;
+
+    // p lies within or on the triangle a, b, c of either orientation
+    bool pointInTriangle(double ax, double ay, double bx, double by, double cx, double cy,
+                         double px, double py) {
+        double ab = (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+        double bc = (cx - bx) * (py - by) - (cy - by) * (px - bx);
+        double ca = (ax - cx) * (py - cy) - (ay - cy) * (px - cx);
+        return !((ab < 0.0 || bc < 0.0 || ca < 0.0) && (ab > 0.0 || bc > 0.0 || ca > 0.0));
+    }
+
+    // node of a circular doubly linked ring of vertex indices, bridged holes
+    // visit their bridge vertices twice, so one vertex may have several nodes
+    struct RingNode {
+        int vertex;
+        int prev;
+        int next;
+    };
+
+    class EarClipper {
+    public:
+        EarClipper(const float *points) : points(points) {
+        }
+
+        // links the vertices first to first + count - 1 as a ring, counter clockwise
+        // for outlines and clockwise for holes. Returns -1 for degenerate rings.
+        int linkRing(int first, int count, bool counterClockwise) {
+            double area = 0.0;
+            for (int i = 0, j = count - 1; i < count; j = i++) {
+                area += (x(first + j) - x(first + i)) * (y(first + j) + y(first + i));
+            }
+            if (count < 3 || area == 0.0) {
+                return -1;
+            }
+            bool reverse = (area > 0.0) != counterClockwise;
+            int head = static_cast<int>(nodes.size());
+            for (int i = 0; i < count; ++i) {
+                RingNode node;
+                node.vertex = first + (reverse ? count - 1 - i : i);
+                node.prev = head + (i + count - 1) % count;
+                node.next = head + (i + 1) % count;
+                nodes.push_back(node);
+            }
+            return head;
+        }
+
+        // bridges the hole ring into the ring of outline
+        bool eliminateHole(int hole, int outline) {
+            int rightmost = hole;
+            for (int node = nodes[hole].next; node != hole; node = nodes[node].next) {
+                if (x(vertexOf(node)) > x(vertexOf(rightmost))) {
+                    rightmost = node;
+                }
+            }
+            int bridge = findBridge(rightmost, outline);
+            if (bridge < 0) {
+                return false;
+            }
+            split(bridge, rightmost);
+            return true;
+        }
+
+        // clips ears off the ring until only one triangle is left
+        bool clip(int node, std::vector<int> &triangles) {
+            int count = 1;
+            for (int n = nodes[node].next; n != node; n = nodes[n].next) {
+                count++;
+            }
+            bool dropped = false;
+            for (int unclipped = 0; count > 2;) {
+                int prev = nodes[node].prev, next = nodes[node].next;
+                if (isEar(node)) {
+                    triangles.push_back(vertexOf(prev));
+                    triangles.push_back(vertexOf(node));
+                    triangles.push_back(vertexOf(next));
+                    remove(node);
+                    node = next;
+                    count--;
+                    unclipped = 0;
+                    dropped = false;
+                    continue;
+                }
+                node = next;
+                if (++unclipped < count) {
+                    continue;
+                }
+                // a whole round without an ear, first collinear vertices are
+                // dropped, then any convex vertex is clipped
+                unclipped = 0;
+                if (!dropped) {
+                    dropped = true;
+                    for (int i = count; i > 0 && count > 2; --i) {
+                        int n = nodes[node].next;
+                        if (area(nodes[node].prev, node, nodes[node].next) == 0.0) {
+                            remove(node);
+                            count--;
+                        }
+                        node = n;
+                    }
+                    continue;
+                }
+                int convex = -1;
+                for (int i = 0, n = node; i < count && convex < 0; ++i, n = nodes[n].next) {
+                    convex = area(nodes[n].prev, n, nodes[n].next) > 0.0 ? n : -1;
+                }
+                if (convex < 0) {
+                    return count < 3;
+                }
+                triangles.push_back(vertexOf(nodes[convex].prev));
+                triangles.push_back(vertexOf(convex));
+                triangles.push_back(vertexOf(nodes[convex].next));
+                node = nodes[convex].next;
+                remove(convex);
+                count--;
+            }
+            return true;
+        }
+
+    private:
+        const float *points;
+        std::vector<RingNode> nodes;
+
+        int vertexOf(int node) const { return nodes[node].vertex; }
+
+        double x(int vertex) const { return points[vertex * 2]; }
+
+        double y(int vertex) const { return points[vertex * 2 + 1]; }
+
+        // twice the signed area of the nodes a, b, c, positive if counter clockwise
+        double area(int a, int b, int c) const {
+            int va = vertexOf(a), vb = vertexOf(b), vc = vertexOf(c);
+            return (x(vb) - x(va)) * (y(vc) - y(va)) - (y(vb) - y(va)) * (x(vc) - x(va));
+        }
+
+        bool samePosition(int a, int b) const {
+            int va = vertexOf(a), vb = vertexOf(b);
+            return x(va) == x(vb) && y(va) == y(vb);
+        }
+
+        // p lies within or on the counter clockwise triangle a, b, c
+        bool inTriangle(int a, int b, int c, int p) const {
+            return area(a, b, p) >= 0.0 && area(b, c, p) >= 0.0 && area(c, a, p) >= 0.0;
+        }
+
+        // the diagonal from a to b leaves a into the polygon
+        bool locallyInside(int a, int b) const {
+            int prev = nodes[a].prev, next = nodes[a].next;
+            if (area(prev, a, next) >= 0.0) {
+                return area(a, next, b) >= 0.0 && area(a, b, prev) >= 0.0;
+            }
+            return area(a, next, b) >= 0.0 || area(a, b, prev) >= 0.0;
+        }
+
+        bool isEar(int ear) const {
+            int a = nodes[ear].prev, c = nodes[ear].next;
+            if (area(a, ear, c) <= 0.0) {
+                return false;
+            }
+            for (int p = nodes[c].next; p != a; p = nodes[p].next) {
+                if (samePosition(p, a) || samePosition(p, ear) || samePosition(p, c)) {
+                    continue;
+                }
+                if (inTriangle(a, ear, c, p) && area(nodes[p].prev, p, nodes[p].next) <= 0.0) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // finds an outline node visible from the hole node, David Eberly's
+        // "Triangulation by Ear Clipping" with a ray towards +x
+        int findBridge(int hole, int outline) const {
+            double hx = x(vertexOf(hole)), hy = y(vertexOf(hole));
+            double closest = std::numeric_limits<double>::infinity();
+            int candidate = -1;
+            int node = outline;
+            do {
+                int next = nodes[node].next;
+                double ay = y(vertexOf(node)), by = y(vertexOf(next));
+                // only edges going up are left towards the outside by the ray
+                if (ay <= hy && hy <= by && ay != by) {
+                    double ax = x(vertexOf(node)), bx = x(vertexOf(next));
+                    double ix = ax + (hy - ay) * (bx - ax) / (by - ay);
+                    if (ix >= hx && ix < closest) {
+                        closest = ix;
+                        candidate = ax > bx ? node : next;
+                        if (ix == hx) {
+                            return hy == ay ? node : (hy == by ? next : candidate);
+                        }
+                    }
+                }
+                node = next;
+            } while (node != outline);
+            if (candidate < 0) {
+                return -1;
+            }
+
+            // nodes within the triangle of hole, ray hit and candidate may block the
+            // view, the one with the smallest angle to the ray is visible
+            double cx = x(vertexOf(candidate)), cy = y(vertexOf(candidate));
+            double ix = closest;
+            double bestTangent = std::numeric_limits<double>::infinity();
+            int stop = candidate;
+            node = candidate;
+            do {
+                int v = vertexOf(node);
+                double px = x(v), py = y(v);
+                bool inside = px != hx && pointInTriangle(hx, hy, ix, hy, cx, cy, px, py);
+                if (inside && locallyInside(node, hole)) {
+                    double tangent = std::fabs(hy - py) / (px - hx);
+                    if (tangent < bestTangent ||
+                        (tangent == bestTangent && px > x(vertexOf(candidate)))) {
+                        bestTangent = tangent;
+                        candidate = node;
+                    }
+                }
+                node = nodes[node].next;
+            } while (node != stop);
+            return candidate;
+        }
+
+        // links outline node a to hole node b and back through copies of both
+        void split(int a, int b) {
+            int a2 = static_cast<int>(nodes.size());
+            int b2 = a2 + 1;
+            RingNode copy;
+            copy.vertex = nodes[a].vertex;
+            nodes.push_back(copy);
+            copy.vertex = nodes[b].vertex;
+            nodes.push_back(copy);
+            int an = nodes[a].next, bp = nodes[b].prev;
+            nodes[a].next = b;
+            nodes[b].prev = a;
+            nodes[a2].next = an;
+            nodes[an].prev = a2;
+            nodes[b2].next = a2;
+            nodes[a2].prev = b2;
+            nodes[bp].next = b2;
+            nodes[b2].prev = bp;
+        }
+
+        void remove(int node) {
+            nodes[nodes[node].prev].next = nodes[node].next;
+            nodes[nodes[node].next].prev = nodes[node].prev;
+        }
+    };
+
+    uint64_t edgeKey(int a, int b) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(a)) << 32 | static_cast<uint32_t>(b);
+    }
+
+    uint64_t undirectedKey(int a, int b) {
+        return a < b ? edgeKey(a, b) : edgeKey(b, a);
+    }
+
+    // flips every edge which is not part of a ring until no vertex lies within
+    // the circumcircle of a neighbouring triangle
+    void delaunayFlips(const Polygon2D &polygon, std::vector<int> &triangles) {
+        const float *points = polygon.points.data();
+        std::unordered_set<uint64_t> constrained;
+        for (int ring = 0, first = 0; ring < static_cast<int>(polygon.ringSizes.size()); ++ring) {
+            int size = polygon.ringSizes[ring];
+            for (int i = 0; i < size; ++i) {
+                constrained.insert(undirectedKey(first + i, first + (i + 1) % size));
+            }
+            first += size;
+        }
+
+        // triangle of every directed edge
+        std::unordered_map<uint64_t, int> edges;
+        int triangleCount = static_cast<int>(triangles.size() / 3);
+        edges.reserve(triangles.size());
+        std::vector<std::pair<int, int> > pending;
+        for (int t = 0; t < triangleCount; ++t) {
+            for (int i = 0; i < 3; ++i) {
+                int a = triangles[t * 3 + i], b = triangles[t * 3 + (i + 1) % 3];
+                edges[edgeKey(a, b)] = t;
+                if (!constrained.count(undirectedKey(a, b))) {
+                    pending.push_back(std::make_pair(a, b));
+                }
+            }
+        }
+
+        float min[2] = {points[0], points[1]}, max[2] = {points[0], points[1]};
+        for (size_t i = 0; i < polygon.points.size(); ++i) {
+            min[i % 2] = std::min(min[i % 2], polygon.points[i]);
+            max[i % 2] = std::max(max[i % 2], polygon.points[i]);
+        }
+        double scale = std::max(max[0] - min[0], max[1] - min[1]);
+        // keeps cocircular vertices from flipping back and forth
+        double tolerance = 1e-10 * scale * scale * scale * scale;
+        size_t remainingFlips = triangles.size() * triangles.size() + 16;
+
+        while (!pending.empty() && remainingFlips > 0) {
+            int a = pending.back().first, b = pending.back().second;
+            pending.pop_back();
+            std::unordered_map<uint64_t, int>::iterator left = edges.find(edgeKey(a, b));
+            std::unordered_map<uint64_t, int>::iterator right = edges.find(edgeKey(b, a));
+            if (left == edges.end() || right == edges.end()) {
+                continue;
+            }
+            int t1 = left->second, t2 = right->second;
+            int *first = &triangles[t1 * 3], *second = &triangles[t2 * 3];
+            int c = first[0] + first[1] + first[2] - a - b;
+            int d = second[0] + second[1] + second[2] - a - b;
+
+            double adx = points[a * 2] - points[d * 2], ady = points[a * 2 + 1] - points[d * 2 + 1];
+            double bdx = points[b * 2] - points[d * 2], bdy = points[b * 2 + 1] - points[d * 2 + 1];
+            double cdx = points[c * 2] - points[d * 2], cdy = points[c * 2 + 1] - points[d * 2 + 1];
+            double inCircle = (adx * adx + ady * ady) * (bdx * cdy - cdx * bdy) -
+                              (bdx * bdx + bdy * bdy) * (adx * cdy - cdx * ady) +
+                              (cdx * cdx + cdy * cdy) * (adx * bdy - bdx * ady);
+            // d within the circumcircle of a, b, c, both new triangles a, d, c and
+            // d, b, c have to stay counter clockwise
+            if (inCircle <= tolerance || adx * cdy - ady * cdx >= 0.0 ||
+                bdx * cdy - bdy * cdx <= 0.0) {
+                continue;
+            }
+            edges.erase(left);
+            edges.erase(right);
+            first[0] = a, first[1] = d, first[2] = c;
+            second[0] = d, second[1] = b, second[2] = c;
+            edges[edgeKey(a, d)] = t1;
+            edges[edgeKey(d, c)] = t1;
+            edges[edgeKey(c, a)] = t1;
+            edges[edgeKey(d, b)] = t2;
+            edges[edgeKey(b, c)] = t2;
+            edges[edgeKey(c, d)] = t2;
+            const int outer[4][2] = {{a, d}, {d, b}, {b, c}, {c, a}};
+            for (int i = 0; i < 4; ++i) {
+                if (!constrained.count(undirectedKey(outer[i][0], outer[i][1]))) {
+                    pending.push_back(std::make_pair(outer[i][0], outer[i][1]));
+                }
+            }
+            remainingFlips--;
+        }
+    }
+}
+
+namespace constructnative {
+
+    bool triangulatePolygon(const Polygon2D &polygon, std::vector<int> &triangles) {
+        triangles.clear();
+        int vertexCount = 0;
+        for (size_t i = 0; i < polygon.ringSizes.size(); ++i) {
+            vertexCount += polygon.ringSizes[i];
+        }
+        if (polygon.ringSizes.empty() || vertexCount * 2 != static_cast<int>(polygon.points.size())) {
+            return false;
+        }
+
+        EarClipper clipper(polygon.points.data());
+        int outline = clipper.linkRing(0, polygon.ringSizes[0], true);
+        if (outline < 0) {
+            return false;
+        }
+
+        // holes are bridged from right to left, so every bridge only crosses
+        // the outline and holes which are already part of it
+        std::vector<std::pair<float, int> > holes;
+        for (int ring = 1, first = polygon.ringSizes[0];
+             ring < static_cast<int>(polygon.ringSizes.size()); first += polygon.ringSizes[ring++]) {
+            int hole = clipper.linkRing(first, polygon.ringSizes[ring], false);
+            if (hole < 0) {
+                continue;
+            }
+            float right = -std::numeric_limits<float>::infinity();
+            for (int i = 0; i < polygon.ringSizes[ring]; ++i) {
+                right = std::max(right, polygon.points[(first + i) * 2]);
+            }
+            holes.push_back(std::make_pair(-right, hole));
+        }
+        std::sort(holes.begin(), holes.end());
+        for (size_t i = 0; i < holes.size(); ++i) {
+            if (!clipper.eliminateHole(holes[i].second, outline)) {
+                return false;
+            }
+        }
+
+        if (!clipper.clip(outline, triangles)) {
+            triangles.clear();
+            return false;
+        }
+        delaunayFlips(polygon, triangles);
+        return true;
+    }
+
+    int triangulatePolygons(const std::vector<Polygon2D> &polygons,
+                            std::vector<std::vector<int> > &triangles) {
+        triangles.resize(polygons.size());
+        int count = static_cast<int>(polygons.size());
+        int triangulated = 0;
+        // polygons differ a lot in size, so they are handed out one by one
+#pragma omp parallel for schedule(dynamic) reduction(+:triangulated)
+        for (int i = 0; i < count; ++i) {
+            triangulated += triangulatePolygon(polygons[i], triangles[i]) ? 1 : 0;
+        }
+        return triangulated;
+    }
+}
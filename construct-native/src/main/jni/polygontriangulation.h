@@ -0,0 +1,37 @@
+//
+// Constrained Delaunay triangulation of plane polygons with holes.
+//
+
+#ifndef MASTERPROTOTYPE_POLYGONTRIANGULATION_H
+#define MASTERPROTOTYPE_POLYGONTRIANGULATION_H
+
+#include <vector>
+
+namespace constructnative {
+
+    // polygon in plane coordinates, the first ring is the outline and all
+    // following rings are holes. Rings may have either orientation.
+    struct Polygon2D {
+        // x, y pairs of all rings one after another
+        std::vector<float> points;
+        // vertex count of every ring
+        std::vector<int> ringSizes;
+    };
+
+    // Triangulates polygon without adding vertices. Holes are bridged into the
+    // outline and ears are clipped, then every edge which is not part of a ring
+    // is flipped until the triangulation is constrained Delaunay.
+    //
+    // @param triangles: gets three vertex indices per counter clockwise triangle,
+    //                   indices count the vertices of all rings in order
+    // @return: false if the rings could not be triangulated, triangles is empty then
+    bool triangulatePolygon(const Polygon2D &polygon, std::vector<int> &triangles);
+
+    // triangulates all polygons on all cores, failed polygons get no triangles
+    //
+    // @return: number of polygons which could be triangulated
+    int triangulatePolygons(const std::vector<Polygon2D> &polygons,
+                            std::vector<std::vector<int> > &triangles);
+}
+
+#endif //MASTERPROTOTYPE_POLYGONTRIANGULATION_H
@@ -0,0 +1,87 @@
+//
+// Persistent voxel grid over all frames of a session.
+//
+#include "voxelaccumulator.h"
+
+#include <cmath>
+
+namespace constructnative {
+
+    VoxelAccumulator::VoxelAccumulator(float leafSize) :
+            leafSize(leafSize),
+            inverseLeafSize(1.0f / leafSize),
+            cloud(new pcl::PointCloud<pcl::PointXYZ>) {
+    }
+
+    VoxelKey VoxelAccumulator::keyOf(float x, float y, float z) const {
+        VoxelKey key;
+        key.x = static_cast<int>(std::floor(x * inverseLeafSize));
+        key.y = static_cast<int>(std::floor(y * inverseLeafSize));
+        key.z = static_cast<int>(std::floor(z * inverseLeafSize));
+        return key;
+    }
+
+    int VoxelAccumulator::findVoxel(const VoxelKey &key) const {
+        std::unordered_map<VoxelKey, int, VoxelKeyHasher>::const_iterator it = indices.find(key);
+        return it == indices.end() ? -1 : it->second;
+    }
+
+    void VoxelAccumulator::addPoints(const float *points, int count) {
+        if (count <= 0) {
+            return;
+        }
+        for (int i = 0; i < count; ++i) {
+            float x = points[i * 3];
+            float y = points[i * 3 + 1];
+            float z = points[i * 3 + 2];
+            if (!std::isfinite(x) || !std::isfinite(y) || !std::isfinite(z)) {
+                continue;
+            }
+            VoxelKey key = keyOf(x, y, z);
+            std::pair<std::unordered_map<VoxelKey, int, VoxelKeyHasher>::iterator, bool> inserted =
+                    indices.insert(std::make_pair(key, static_cast<int>(keys.size())));
+            int index = inserted.first->second;
+            if (inserted.second) {
+                keys.push_back(key);
+                counts.push_back(1);
+                cloud->points.push_back(pcl::PointXYZ(x, y, z));
+                dirtyFlags.push_back(false);
+            } else {
+                // running centroid of all points in the voxel
+                int n = ++counts[index];
+                pcl::PointXYZ &centroid = cloud->points[index];
+                centroid.x += (x - centroid.x) / n;
+                centroid.y += (y - centroid.y) / n;
+                centroid.z += (z - centroid.z) / n;
+            }
+            if (!dirtyFlags[index]) {
+                dirtyFlags[index] = true;
+                dirtyVoxels.push_back(index);
+            }
+        }
+        cloud->width = cloud->points.size();
+        cloud->height = 1;
+        revision++;
+    }
+
+    void VoxelAccumulator::clear() {
+        indices.clear();
+        keys.clear();
+        counts.clear();
+        cloud->points.clear();
+        cloud->width = 0;
+        cloud->height = 1;
+        dirtyVoxels.clear();
+        dirtyFlags.clear();
+        revision++;
+        generation++;
+    }
+
+    void VoxelAccumulator::takeDirtyVoxels(std::vector<int> &dirty) {
+        dirty.swap(dirtyVoxels);
+        dirtyVoxels.clear();
+        for (size_t i = 0; i < dirty.size(); ++i) {
+            dirtyFlags[dirty[i]] = false;
+        }
+    }
+}
@@ -0,0 +1,89 @@
+//
+// Persistent voxel grid over all frames of a session.
+//
+
+#ifndef MASTERPROTOTYPE_VOXELACCUMULATOR_H
+#define MASTERPROTOTYPE_VOXELACCUMULATOR_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+
+namespace constructnative {
+
+    // integer coordinates of a voxel
+    struct VoxelKey {
+        int x;
+        int y;
+        int z;
+
+        bool operator==(const VoxelKey &other) const {
+            return x == other.x && y == other.y && z == other.z;
+        }
+    };
+
+    struct VoxelKeyHasher {
+        size_t operator()(const VoxelKey &key) const {
+            return static_cast<size_t>(static_cast<unsigned int>(key.x) * 73856093u ^
+                                       static_cast<unsigned int>(key.y) * 19349663u ^
+                                       static_cast<unsigned int>(key.z) * 83492791u);
+        }
+    };
+
+    // Hashed voxel grid which merges frames as they arrive. Every voxel keeps the
+    // running centroid of its points, so the grid is the downsampled cloud of the
+    // whole session and adding a frame only costs the points of that frame.
+    // Voxels are never removed before clear(), their index in the cloud is stable.
+    class VoxelAccumulator {
+    public:
+        explicit VoxelAccumulator(float leafSize);
+
+        // merges count points given as x, y, z floats
+        void addPoints(const float *points, int count);
+
+        // removes all voxels
+        void clear();
+
+        // one centroid per voxel, indexed like the voxels
+        pcl::PointCloud<pcl::PointXYZ>::Ptr getCloud() const { return cloud; }
+
+        // voxel coordinates of the voxel with index
+        const VoxelKey &getKey(int index) const { return keys[index]; }
+
+        // index of the voxel at key or -1 if it is empty
+        int findVoxel(const VoxelKey &key) const;
+
+        // voxel coordinates of a point
+        VoxelKey keyOf(float x, float y, float z) const;
+
+        float getLeafSize() const { return leafSize; }
+
+        // changes with every merged frame which touched a voxel
+        int getRevision() const { return revision; }
+
+        // changes with every clear, voxel indices of older generations are invalid
+        int getGeneration() const { return generation; }
+
+        // moves the indices of voxels changed since the last call into dirty
+        void takeDirtyVoxels(std::vector<int> &dirty);
+
+    private:
+        float leafSize;
+        float inverseLeafSize;
+        int revision = 0;
+        int generation = 0;
+
+        std::unordered_map<VoxelKey, int, VoxelKeyHasher> indices;
+        std::vector<VoxelKey> keys;
+        std::vector<int> counts;
+        pcl::PointCloud<pcl::PointXYZ>::Ptr cloud;
+
+        // voxels changed since the last takeDirtyVoxels call
+        std::vector<int> dirtyVoxels;
+        std::vector<bool> dirtyFlags;
+    };
+}
+
+#endif //MASTERPROTOTYPE_VOXELACCUMULATOR_H
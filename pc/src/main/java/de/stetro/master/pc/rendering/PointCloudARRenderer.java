@@ -20,6 +20,8 @@ public class PointCloudARRenderer extends TangoRajawaliRenderer {
     private PointCollection collectedPoints;
     private PointCloudManager pointCloudManager;
     private boolean collectPoints;
+    // set from the UI thread, the collection is cleared on the GL thread
+    private volatile boolean clearPoints;
 
     public PointCloudARRenderer(Context context) {
         super(context);
@@ -59,6 +61,10 @@ public class PointCloudARRenderer extends TangoRajawaliRenderer {
     @Override
     protected void onRender(long ellapsedRealtime, double deltaTime) {
         super.onRender(ellapsedRealtime, deltaTime);
+        if (clearPoints) {
+            clearPoints = false;
+            collectedPoints.clear();
+        }
         if (pointCloudManager != null && pointCloudManager.hasNewPoints()) {
             Pose pose = mScenePoseCalcuator.toOpenGLPointCloudPose(pointCloudManager.getDevicePoseAtCloudTime());
             if (collectPoints) {
@@ -79,6 +85,6 @@ public class PointCloudARRenderer extends TangoRajawaliRenderer {
     }
 
     public void clearPointCloud() {
-        collectedPoints.clear();
+        clearPoints = true;
     }
 }
@@ -12,9 +12,18 @@ import org.rajawali3d.materials.Material;
 import org.rajawali3d.math.Matrix4;
 import org.rajawali3d.math.vector.Vector3;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.nio.FloatBuffer;
 
+import de.stetro.master.pc.util.JNIInterface;
+
 public class PointCollection extends Object3D {
+    // edge length of the voxels of the native store, one point is kept per voxel
+    private static final float VOXEL_SIZE = 0.01f;
+    private final boolean nativeStore = JNIInterface.isAvailable();
+    private final float[] transform = new float[16];
+    private final int[] dirtyRange = new int[2];
     private FloatBuffer buffer;
     private int mMaxNumberOfVertices;
     private int count = 0;
@@ -30,7 +39,17 @@ public class PointCollection extends Object3D {
 
     protected void init() {
         count = 0;
-        buffer = FloatBuffer.allocate(mMaxNumberOfVertices * 3);
+        if (nativeStore) {
+            // the native store writes its points straight into this buffer
+            buffer = JNIInterface.createPointStore(mMaxNumberOfVertices, VOXEL_SIZE)
+                    .order(ByteOrder.nativeOrder())
+                    .asFloatBuffer();
+        } else {
+            // direct buffer, so the native exporter can read it without a copy
+            buffer = ByteBuffer.allocateDirect(mMaxNumberOfVertices * 3 * 4)
+                    .order(ByteOrder.nativeOrder())
+                    .asFloatBuffer();
+        }
         float[] vertices = new float[mMaxNumberOfVertices * 3];
         int[] indices = new int[mMaxNumberOfVertices];
         for (int i = 0; i < indices.length; ++i) {
@@ -45,7 +64,9 @@ public class PointCollection extends Object3D {
     }
 
     public void updatePoints(FloatBuffer pointCloudBuffer, int pointCount, Pose pose) {
-        if (count + pointCount < mMaxNumberOfVertices) {
+        if (nativeStore) {
+            updateNativePoints(pointCloudBuffer, pointCount, pose);
+        } else if (count + pointCount < mMaxNumberOfVertices) {
             pointCloudBuffer.position(0);
             FloatBuffer transformedPoints = FloatBuffer.allocate(pointCount * 3);
             for (int i = 0; i < pointCount; i++) {
@@ -70,6 +91,19 @@ public class PointCollection extends Object3D {
         }
     }
 
+    private void updateNativePoints(FloatBuffer pointCloudBuffer, int pointCount, Pose pose) {
+        Matrix4.createTranslationMatrix(pose.getPosition()).rotate(pose.getOrientation()).toFloatArray(transform);
+        count = JNIInterface.accumulatePoints(pointCloudBuffer, pointCount, transform, dirtyRange);
+        mGeometry.setNumIndices(count);
+        if (dirtyRange[1] > dirtyRange[0]) {
+            // only upload the points which changed with this frame
+            buffer.position(dirtyRange[0] * 3);
+            FloatBuffer dirty = buffer.slice();
+            buffer.position(0);
+            mGeometry.changeBufferData(mGeometry.getVertexBufferInfo(), dirty, dirtyRange[0] * 3, (dirtyRange[1] - dirtyRange[0]) * 3);
+        }
+    }
+
     public void preRender() {
         super.preRender();
         setDrawingMode(GLES20.GL_POINTS);
@@ -84,8 +118,13 @@ public class PointCollection extends Object3D {
         return buffer;
     }
 
+    // has to run on the GL thread, like updatePoints
     public void clear() {
         count = 0;
+        if (nativeStore) {
+            JNIInterface.clearPointStore();
+        }
+        buffer.clear();
         mGeometry.setNumIndices(0);
     }
 
@@ -0,0 +1,47 @@
+package de.stetro.master.pc.util;
+
+
+import android.util.Log;
+
+import java.nio.ByteBuffer;
+import java.nio.FloatBuffer;
+
+public class JNIInterface {
+    public static final int FORMAT_XYZ = 0;
+    public static final int FORMAT_PLY = 1;
+    private static final String TAG = "JNIInterface";
+    private static boolean available;
+
+    static {
+        try {
+            System.loadLibrary("pointcloudexporter");
+            available = true;
+        } catch (UnsatisfiedLinkError e) {
+            Log.w(TAG, "native exporter not available, using java exporter", e);
+            available = false;
+        }
+    }
+
+    public static boolean isAvailable() {
+        return available;
+    }
+
+    // writes count points of a direct buffer to path, progress is reported about every 100ms
+    public static native boolean exportPoints(FloatBuffer buffer, int count, String path, int format, ProgressListener listener);
+
+    // creates the native point store with one mean per voxel, the returned direct
+    // buffer holds capacity x, y, z points and stays valid while the store is
+    // recreated with the same capacity and voxel size
+    public static native ByteBuffer createPointStore(int capacity, float voxelSize);
+
+    // merges count points of a direct buffer transformed by the column major 4x4
+    // transform into the point store, dirtyRange gets the first and one past the
+    // last changed point. Returns the number of stored points.
+    public static native int accumulatePoints(FloatBuffer buffer, int count, float[] transform, int[] dirtyRange);
+
+    public static native void clearPointStore();
+
+    public interface ProgressListener {
+        void onProgress(int writtenPoints);
+    }
+}
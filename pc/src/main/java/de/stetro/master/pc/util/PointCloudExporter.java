@@ -8,10 +8,13 @@ import android.widget.Toast;
 
 import com.afollestad.materialdialogs.MaterialDialog;
 
+import java.io.BufferedOutputStream;
 import java.io.File;
 import java.io.FileOutputStream;
 import java.io.IOException;
 import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.nio.FloatBuffer;
 import java.text.Format;
 import java.text.SimpleDateFormat;
@@ -22,14 +25,24 @@ import de.stetro.master.pc.R;
 import de.stetro.master.pc.rendering.PointCollection;
 
 public class PointCloudExporter {
+    private static final int BUFFER_SIZE = 4 * 1024 * 1024;
+    private static final long PROGRESS_INTERVAL_MS = 100;
+    // points converted and written at once by the ply fallback
+    private static final int PLY_POINTS_PER_STEP = 16 * 1024;
     private final Context context;
     private final PointCollection pointCollection;
     private MaterialDialog dialog;
     private String filePath;
+    private int format;
 
     public PointCloudExporter(Context context, PointCollection pointCollection) {
+        this(context, pointCollection, JNIInterface.FORMAT_XYZ);
+    }
+
+    public PointCloudExporter(Context context, PointCollection pointCollection, int format) {
         this.context = context;
         this.pointCollection = pointCollection;
+        this.format = format;
         dialog = new MaterialDialog.Builder(context)
                 .title(R.string.exporting_pointcloud)
                 .content(R.string.please_wait)
@@ -44,45 +57,99 @@ public class PointCloudExporter {
         new ExportAsyncTask().execute(pointCollection);
     }
 
-    private class ExportAsyncTask extends AsyncTask<PointCollection, Integer, Void> {
+    private class ExportAsyncTask extends AsyncTask<PointCollection, Integer, Boolean> {
 
         @Override
-        protected Void doInBackground(PointCollection... params) {
+        protected Boolean doInBackground(PointCollection... params) {
             if (params.length == 0) {
-                return null;
+                return false;
             }
             PointCollection pointCollection = params[0];
             Format formatter = new SimpleDateFormat("yyyy-MM-dd_HH-mm", Locale.GERMAN);
 
-            String fileName = "pointcloud-" + formatter.format(new Date()) + ".xyz";
+            String extension = format == JNIInterface.FORMAT_PLY ? ".ply" : ".xyz";
+            String fileName = "pointcloud-" + formatter.format(new Date()) + extension;
             File f = new File(Environment.getExternalStorageDirectory().getAbsolutePath() + "/pointclouds");
             if (!f.exists()) {
                 f.mkdirs();
             }
             final File file = new File(f, fileName);
             filePath = file.getPath();
+            int size = pointCollection.getCount();
+            dialog.setMaxProgress(size);
+            FloatBuffer floatBuffer = pointCollection.getBuffer();
+            if (JNIInterface.isAvailable()) {
+                return JNIInterface.exportPoints(floatBuffer, size, filePath, format, new JNIInterface.ProgressListener() {
+                    @Override
+                    public void onProgress(int writtenPoints) {
+                        publishProgress(writtenPoints);
+                    }
+                });
+            }
+            try {
+                if (format == JNIInterface.FORMAT_PLY) {
+                    exportPly(floatBuffer, size, file);
+                } else {
+                    exportXyz(floatBuffer, size, file);
+                }
+                return true;
+            } catch (IOException e) {
+                dialog.setCancelable(true);
+                return false;
+            }
+        }
+
+        // java fallback of the native xyz writer
+        private void exportXyz(FloatBuffer floatBuffer, int size, File file) throws IOException {
+            OutputStream os = new BufferedOutputStream(new FileOutputStream(file), BUFFER_SIZE);
             try {
-                OutputStream os = new FileOutputStream(file);
-                int size = pointCollection.getCount();
-                dialog.setMaxProgress(size);
-                FloatBuffer floatBuffer = pointCollection.getBuffer();
-                floatBuffer.rewind();
-                int progressCounter = 0;
+                StringBuilder row = new StringBuilder(64);
+                long lastProgress = System.currentTimeMillis();
                 for (int i = 0; i < size; i++) {
-                    String row = String.valueOf(floatBuffer.get()) + " " + String.valueOf(floatBuffer.get()) + " " + String.valueOf(floatBuffer.get()) + "\n";
-                    os.write(row.getBytes());
-                    progressCounter++;
-                    if (progressCounter % (int) ((double) size / 200.0) == 0) {
-                        publishProgress(progressCounter);
+                    row.setLength(0);
+                    row.append(floatBuffer.get(i * 3)).append(' ')
+                            .append(floatBuffer.get(i * 3 + 1)).append(' ')
+                            .append(floatBuffer.get(i * 3 + 2)).append('\n');
+                    for (int j = 0; j < row.length(); j++) {
+                        os.write(row.charAt(j));
+                    }
+                    if ((i & 0xFFF) == 0 && System.currentTimeMillis() - lastProgress >= PROGRESS_INTERVAL_MS) {
+                        lastProgress = System.currentTimeMillis();
+                        publishProgress(i);
                     }
                 }
+            } finally {
                 os.close();
-            } catch (IOException e) {
-                dialog.setCancelable(true);
+            }
+            publishProgress(size);
+        }
+
+        // java fallback of the native ply writer, binary little endian like the native one
+        private void exportPly(FloatBuffer floatBuffer, int size, File file) throws IOException {
+            OutputStream os = new BufferedOutputStream(new FileOutputStream(file), BUFFER_SIZE);
+            try {
+                String header = "ply\n" +
+                        "format binary_little_endian 1.0\n" +
+                        "element vertex " + size + "\n" +
+                        "property float x\n" +
+                        "property float y\n" +
+                        "property float z\n" +
+                        "end_header\n";
+                os.write(header.getBytes("US-ASCII"));
+                ByteBuffer points = ByteBuffer.allocate(PLY_POINTS_PER_STEP * 3 * 4).order(ByteOrder.LITTLE_ENDIAN);
+                for (int start = 0; start < size; start += PLY_POINTS_PER_STEP) {
+                    int end = Math.min(size, start + PLY_POINTS_PER_STEP);
+                    points.clear();
+                    for (int i = start * 3; i < end * 3; i++) {
+                        points.putFloat(floatBuffer.get(i));
+                    }
+                    os.write(points.array(), 0, points.position());
+                    publishProgress(end);
+                }
             } finally {
-                dialog.dismiss();
+                os.close();
             }
-            return null;
+            publishProgress(size);
         }
 
         @Override
@@ -91,9 +158,13 @@ public class PointCloudExporter {
         }
 
         @Override
-        protected void onPostExecute(Void aVoid) {
+        protected void onPostExecute(Boolean success) {
             dialog.dismiss();
-            Toast.makeText(context, String.format(context.getString(R.string.export_pointcloud_result), filePath), Toast.LENGTH_LONG).show();
+            if (success) {
+                Toast.makeText(context, String.format(context.getString(R.string.export_pointcloud_result), filePath), Toast.LENGTH_LONG).show();
+            } else {
+                Toast.makeText(context, R.string.export_pointcloud_failure, Toast.LENGTH_LONG).show();
+            }
         }
 
         @Override
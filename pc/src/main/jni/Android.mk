@@ -0,0 +1,12 @@
+LOCAL_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := pointcloudexporter
+LOCAL_CFLAGS := -std=gnu++11 -O3 -mfloat-abi=softfp -mfpu=neon
+LOCAL_SRC_FILES := jni_interface.cc \
+                   pointcloudexporter.cc \
+                   pointaccumulator.cc
+LOCAL_LDLIBS := -llog
+
+include $(BUILD_SHARED_LIBRARY)
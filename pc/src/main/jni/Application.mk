@@ -0,0 +1,4 @@
+APP_ABI := armeabi-v7a
+APP_STL := gnustl_static
+APP_PLATFORM := android-19
+NDK_TOOLCHAIN_VERSION=4.9
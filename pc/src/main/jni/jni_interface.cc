@@ -0,0 +1,106 @@
+#include <jni.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "pointaccumulator.h"
+#include "pointcloudexporter.h"
+
+// collected points of the session, its buffer is shared with Java
+static std::unique_ptr<pointcloud::PointAccumulator> pointStore;
+// guards pointStore, the GL thread accumulates while exports read it
+static std::mutex pointStoreMutex;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+JNIEXPORT jboolean JNICALL
+Java_de_stetro_master_pc_util_JNIInterface_exportPoints(
+        JNIEnv* env, jobject /*obj*/, jobject buffer, jint count, jstring path, jint format,
+        jobject listener) {
+    const float* points = static_cast<const float*>(env->GetDirectBufferAddress(buffer));
+    if (points == nullptr || env->GetDirectBufferCapacity(buffer) < static_cast<jlong>(count) * 3) {
+        LOGE("Export needs a direct buffer with %d points", count);
+        return JNI_FALSE;
+    }
+    const char* file = env->GetStringUTFChars(path, nullptr);
+    std::string filePath(file);
+    env->ReleaseStringUTFChars(path, file);
+
+    std::vector<float> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(pointStoreMutex);
+        if (pointStore && points == pointStore->getPoints()) {
+            // the store keeps changing during the export, write a copy of it
+            count = std::min(count, static_cast<jint>(pointStore->getCount()));
+            snapshot.assign(points, points + count * 3);
+            points = snapshot.data();
+        }
+    }
+
+    jmethodID onProgress = env->GetMethodID(env->GetObjectClass(listener), "onProgress", "(I)V");
+    pointcloud::PointCloudExporter exporter;
+    bool success = exporter.exportPoints(
+            points, count, filePath.c_str(), static_cast<pointcloud::ExportFormat>(format),
+            [env, listener, onProgress](size_t written) {
+                env->CallVoidMethod(listener, onProgress, static_cast<jint>(written));
+                // a throwing listener aborts the export, the exception is raised in Java
+                return env->ExceptionCheck() == JNI_FALSE;
+            });
+    return success ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jobject JNICALL
+Java_de_stetro_master_pc_util_JNIInterface_createPointStore(
+        JNIEnv* env, jobject /*obj*/, jint capacity, jfloat voxelSize) {
+    std::lock_guard<std::mutex> lock(pointStoreMutex);
+    // a store of the same size is reused, so buffers handed out before stay valid
+    if (pointStore && pointStore->getCapacity() == static_cast<size_t>(capacity) &&
+        pointStore->getVoxelSize() == voxelSize) {
+        pointStore->clear();
+    } else {
+        pointStore.reset(new pointcloud::PointAccumulator(capacity, voxelSize));
+    }
+    return env->NewDirectByteBuffer(pointStore->getPoints(),
+                                    static_cast<jlong>(capacity) * 3 * sizeof(float));
+}
+
+JNIEXPORT jint JNICALL
+Java_de_stetro_master_pc_util_JNIInterface_accumulatePoints(
+        JNIEnv* env, jobject /*obj*/, jobject buffer, jint count, jfloatArray transform,
+        jintArray dirtyRange) {
+    const float* points = static_cast<const float*>(env->GetDirectBufferAddress(buffer));
+    std::lock_guard<std::mutex> lock(pointStoreMutex);
+    if (!pointStore || points == nullptr ||
+        env->GetDirectBufferCapacity(buffer) < static_cast<jlong>(count) * 3) {
+        LOGE("Accumulation needs a point store and a direct buffer with %d points", count);
+        return 0;
+    }
+    jfloat matrix[16];
+    env->GetFloatArrayRegion(transform, 0, 16, matrix);
+    size_t dropped = pointStore->getDroppedPoints();
+    jint stored = static_cast<jint>(pointStore->addFrame(points, count, matrix));
+    if (pointStore->getDroppedPoints() > dropped) {
+        LOGI("Point store is full, dropped %d points", pointStore->getDroppedPoints() - dropped);
+    }
+    jint range[2] = {static_cast<jint>(pointStore->getDirtyBegin()),
+                     static_cast<jint>(pointStore->getDirtyEnd())};
+    env->SetIntArrayRegion(dirtyRange, 0, 2, range);
+    return stored;
+}
+
+JNIEXPORT void JNICALL
+Java_de_stetro_master_pc_util_JNIInterface_clearPointStore(
+        JNIEnv* /*env*/, jobject /*obj*/) {
+    std::lock_guard<std::mutex> lock(pointStoreMutex);
+    if (pointStore) {
+        pointStore->clear();
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,124 @@
+#include "pointaccumulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+    // voxel coordinates are packed into 21 bits per axis
+    const int kCoordinateBits = 21;
+    const int kCoordinateOffset = 1 << (kCoordinateBits - 1);
+    const uint64_t kCoordinateMask = (1u << kCoordinateBits) - 1;
+
+    uint64_t pack(float x, float y, float z) {
+        return (static_cast<uint64_t>(static_cast<int>(z) + kCoordinateOffset) & kCoordinateMask)
+               << (2 * kCoordinateBits) |
+               (static_cast<uint64_t>(static_cast<int>(y) + kCoordinateOffset) & kCoordinateMask)
+               << kCoordinateBits |
+               (static_cast<uint64_t>(static_cast<int>(x) + kCoordinateOffset) & kCoordinateMask);
+    }
+
+    // out = m * (point, 1) for count x, y, z points and a column major 4x4 matrix m
+    void transformPoints(const float *points, size_t count, const float *m, float *out) {
+        size_t i = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+        // four points per step, loaded as separate x, y and z lanes
+        float32x4_t tx = vdupq_n_f32(m[12]), ty = vdupq_n_f32(m[13]), tz = vdupq_n_f32(m[14]);
+        for (; i + 4 <= count; i += 4) {
+            float32x4x3_t p = vld3q_f32(points + i * 3);
+            float32x4x3_t r;
+            r.val[0] = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(tx, p.val[0], m[0]), p.val[1], m[4]),
+                                   p.val[2], m[8]);
+            r.val[1] = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(ty, p.val[0], m[1]), p.val[1], m[5]),
+                                   p.val[2], m[9]);
+            r.val[2] = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(tz, p.val[0], m[2]), p.val[1], m[6]),
+                                   p.val[2], m[10]);
+            vst3q_f32(out + i * 3, r);
+        }
+#endif
+        for (; i < count; ++i) {
+            const float *p = points + i * 3;
+            float *r = out + i * 3;
+            r[0] = m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12];
+            r[1] = m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13];
+            r[2] = m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14];
+        }
+    }
+}
+
+namespace pointcloud {
+
+    PointAccumulator::PointAccumulator(size_t capacity, float voxelSize) :
+            capacity(capacity),
+            voxelSize(voxelSize),
+            inverseVoxelSize(1.0f / voxelSize),
+            dirtyBegin(0),
+            dirtyEnd(0),
+            droppedPoints(0),
+            means(capacity * 3) {
+        counts.reserve(capacity);
+        voxels.reserve(capacity);
+    }
+
+    size_t PointAccumulator::addFrame(const float *points, size_t count, const float *transform) {
+        transformed.resize(count * 3);
+        transformPoints(points, count, transform, transformed.data());
+
+        float limit = static_cast<float>(kCoordinateOffset - 1);
+        dirtyBegin = capacity;
+        dirtyEnd = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const float *point = &transformed[i * 3];
+            float x = std::floor(point[0] * inverseVoxelSize);
+            float y = std::floor(point[1] * inverseVoxelSize);
+            float z = std::floor(point[2] * inverseVoxelSize);
+            // also drops NaN
+            if (!(std::fabs(x) < limit && std::fabs(y) < limit && std::fabs(z) < limit)) {
+                continue;
+            }
+            uint64_t key = pack(x, y, z);
+
+            uint32_t index;
+            if (counts.size() < capacity) {
+                std::pair<std::unordered_map<uint64_t, uint32_t, KeyHasher>::iterator, bool> voxel =
+                        voxels.insert(std::make_pair(key, static_cast<uint32_t>(counts.size())));
+                index = voxel.first->second;
+                if (voxel.second) {
+                    counts.push_back(0);
+                }
+            } else {
+                std::unordered_map<uint64_t, uint32_t, KeyHasher>::const_iterator voxel =
+                        voxels.find(key);
+                if (voxel == voxels.end()) {
+                    droppedPoints++;
+                    continue;
+                }
+                index = voxel->second;
+            }
+
+            // running mean of all points in the voxel
+            float *mean = &means[index * 3];
+            float weight = 1.0f / ++counts[index];
+            mean[0] += (point[0] - mean[0]) * weight;
+            mean[1] += (point[1] - mean[1]) * weight;
+            mean[2] += (point[2] - mean[2]) * weight;
+            dirtyBegin = std::min<size_t>(dirtyBegin, index);
+            dirtyEnd = std::max<size_t>(dirtyEnd, index + 1);
+        }
+        if (dirtyEnd == 0) {
+            dirtyBegin = 0;
+        }
+        return counts.size();
+    }
+
+    void PointAccumulator::clear() {
+        voxels.clear();
+        counts.clear();
+        dirtyBegin = 0;
+        dirtyEnd = 0;
+        droppedPoints = 0;
+    }
+}
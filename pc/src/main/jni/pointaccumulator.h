@@ -0,0 +1,69 @@
+#ifndef MASTERPROTOTYPE_POINTACCUMULATOR_H
+#define MASTERPROTOTYPE_POINTACCUMULATOR_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+namespace pointcloud {
+
+    // Collects depth frames into at most capacity points. Every frame is
+    // transformed into world space in one batch and merged into a hashed voxel
+    // grid, each voxel keeps the running mean of its points. The means are kept
+    // in one preallocated array which never moves, so it can be handed to Java
+    // as a direct buffer. Points of new voxels are dropped once the store is full.
+    class PointAccumulator {
+    public:
+        PointAccumulator(size_t capacity, float voxelSize);
+
+        // transforms count x, y, z points with the column major 4x4 matrix and
+        // merges them into the store
+        //
+        // @return: number of stored points
+        size_t addFrame(const float *points, size_t count, const float *transform);
+
+        void clear();
+
+        // x, y, z means of all stored points, capacity * 3 floats
+        float *getPoints() { return means.data(); }
+
+        size_t getCount() const { return counts.size(); }
+
+        size_t getCapacity() const { return capacity; }
+
+        float getVoxelSize() const { return voxelSize; }
+
+        // first and one past the last point changed by the last frame, both are
+        // zero if the frame changed nothing
+        size_t getDirtyBegin() const { return dirtyBegin; }
+
+        size_t getDirtyEnd() const { return dirtyEnd; }
+
+        // points which were dropped because the store was full
+        size_t getDroppedPoints() const { return droppedPoints; }
+
+    private:
+        struct KeyHasher {
+            size_t operator()(uint64_t key) const {
+                return static_cast<size_t>(key ^ (key >> 21) ^ (key >> 42));
+            }
+        };
+
+        size_t capacity;
+        float voxelSize;
+        float inverseVoxelSize;
+        size_t dirtyBegin;
+        size_t dirtyEnd;
+        size_t droppedPoints;
+
+        std::vector<float> means;
+        // points merged into every stored point
+        std::vector<uint32_t> counts;
+        std::unordered_map<uint64_t, uint32_t, KeyHasher> voxels;
+        // world space points of the current frame
+        std::vector<float> transformed;
+    };
+}
+
+#endif //MASTERPROTOTYPE_POINTACCUMULATOR_H
@@ -0,0 +1,194 @@
+#include "pointcloudexporter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+    // size of the write buffer
+    const size_t kBufferSize = 4 * 1024 * 1024;
+    // points converted between two progress checks
+    const size_t kPointsPerStep = 16 * 1024;
+    const long long kProgressIntervalMs = 100;
+    // longest text of one point, three numbers with sign, 10 digits and 6 decimals
+    const size_t kMaxLineLength = 3 * 20 + 3;
+
+    long long currentTimeInMilliseconds() {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        return ((tv.tv_sec * 1000) + (tv.tv_usec / 1000));
+    }
+
+    // formats a float with up to six decimals, without locale lookups
+    char *formatFloat(float value, char *out) {
+        if (value != value) {
+            memcpy(out, "nan", 3);
+            return out + 3;
+        }
+        double v = value;
+        if (v < 0) {
+            *out++ = '-';
+            v = -v;
+        }
+        if (v >= 1e9) {
+            // far outside of any scan, also covers inf
+            return out + snprintf(out, 16, "%g", v);
+        }
+        uint64_t scaled = static_cast<uint64_t>(v * 1e6 + 0.5);
+        uint64_t integer = scaled / 1000000;
+        uint32_t fraction = static_cast<uint32_t>(scaled % 1000000);
+
+        char digits[20];
+        int length = 0;
+        do {
+            digits[length++] = static_cast<char>('0' + integer % 10);
+            integer /= 10;
+        } while (integer > 0);
+        while (length > 0) {
+            *out++ = digits[--length];
+        }
+        *out++ = '.';
+        int decimals = 6;
+        // drop trailing zeros, keep at least one decimal
+        while (decimals > 1 && fraction % 10 == 0) {
+            fraction /= 10;
+            decimals--;
+        }
+        for (int i = decimals - 1; i >= 0; --i) {
+            out[i] = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+        return out + decimals;
+    }
+}
+
+namespace pointcloud {
+
+    PointCloudExporter::PointCloudExporter() : bufferUsed(0), fd(-1), lastProgress(0) { }
+
+    bool PointCloudExporter::exportPoints(const float *points, size_t count, const char *path,
+                                          ExportFormat format,
+                                          const ProgressCallback &progress) {
+        long long before = currentTimeInMilliseconds();
+        fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            LOGE("Could not open %s for export", path);
+            return false;
+        }
+        buffer.resize(kBufferSize);
+        bufferUsed = 0;
+        lastProgress = before;
+
+        bool success;
+        if (format == FORMAT_PLY) {
+            success = writePly(points, count, progress);
+        } else {
+            success = writeXyz(points, count, progress);
+        }
+        success = flush() && success;
+        success = close(fd) == 0 && success;
+        fd = -1;
+        // release the buffer between exports
+        std::vector<char>().swap(buffer);
+
+        success = success && progress(count);
+        if (success) {
+            LOGI("Exported %d points in %lld ms", static_cast<int>(count),
+                 currentTimeInMilliseconds() - before);
+        } else {
+            LOGE("Export to %s failed", path);
+        }
+        return success;
+    }
+
+    bool PointCloudExporter::writeXyz(const float *points, size_t count,
+                                      const ProgressCallback &progress) {
+        char line[kMaxLineLength];
+        for (size_t start = 0; start < count; start += kPointsPerStep) {
+            size_t end = std::min(count, start + kPointsPerStep);
+            for (size_t i = start; i < end; ++i) {
+                char *out = formatFloat(points[i * 3], line);
+                *out++ = ' ';
+                out = formatFloat(points[i * 3 + 1], out);
+                *out++ = ' ';
+                out = formatFloat(points[i * 3 + 2], out);
+                *out++ = '\n';
+                if (!append(line, out - line)) {
+                    return false;
+                }
+            }
+            if (!reportProgress(end, progress)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool PointCloudExporter::writePly(const float *points, size_t count,
+                                      const ProgressCallback &progress) {
+        char header[256];
+        int length = snprintf(header, sizeof(header),
+                              "ply\n"
+                                      "format binary_little_endian 1.0\n"
+                                      "element vertex %lu\n"
+                                      "property float x\n"
+                                      "property float y\n"
+                                      "property float z\n"
+                                      "end_header\n", static_cast<unsigned long>(count));
+        if (!append(header, length)) {
+            return false;
+        }
+        // the floats are little endian already, they are copied as they are
+        for (size_t start = 0; start < count; start += kPointsPerStep) {
+            size_t end = std::min(count, start + kPointsPerStep);
+            if (!append(reinterpret_cast<const char *>(points + start * 3),
+                        (end - start) * 3 * sizeof(float))) {
+                return false;
+            }
+            if (!reportProgress(end, progress)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool PointCloudExporter::append(const char *data, size_t size) {
+        while (size > 0) {
+            size_t chunk = std::min(size, buffer.size() - bufferUsed);
+            memcpy(buffer.data() + bufferUsed, data, chunk);
+            bufferUsed += chunk;
+            data += chunk;
+            size -= chunk;
+            if (bufferUsed == buffer.size() && !flush()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool PointCloudExporter::flush() {
+        size_t written = 0;
+        while (written < bufferUsed) {
+            ssize_t result = write(fd, buffer.data() + written, bufferUsed - written);
+            if (result <= 0) {
+                return false;
+            }
+            written += result;
+        }
+        bufferUsed = 0;
+        return true;
+    }
+
+    bool PointCloudExporter::reportProgress(size_t written, const ProgressCallback &progress) {
+        long long now = currentTimeInMilliseconds();
+        if (now - lastProgress >= kProgressIntervalMs) {
+            lastProgress = now;
+            return progress(written);
+        }
+        return true;
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef MASTERPROTOTYPE_POINTCLOUDEXPORTER_H
+#define MASTERPROTOTYPE_POINTCLOUDEXPORTER_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include <android/log.h>
+
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO   , "Native",__VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR  , "Native",__VA_ARGS__)
+
+namespace pointcloud {
+
+    enum ExportFormat {
+        // one "x y z" text line per point
+        FORMAT_XYZ = 0,
+        // binary little endian PLY with float x, y, z
+        FORMAT_PLY = 1
+    };
+
+    // Writes point clouds to files through one large buffer, so the export is
+    // bound by the disk instead of per point allocations and system calls.
+    class PointCloudExporter {
+    public:
+        // called with the number of written points, returns false to abort the export
+        typedef std::function<bool(size_t)> ProgressCallback;
+
+        PointCloudExporter();
+
+        // Writes count xyz points to path. progress is called at most every
+        // progressIntervalMs milliseconds and once at the end. The export stops
+        // and fails as soon as progress returns false.
+        bool exportPoints(const float *points, size_t count, const char *path,
+                          ExportFormat format, const ProgressCallback &progress);
+
+    private:
+        bool writeXyz(const float *points, size_t count, const ProgressCallback &progress);
+
+        bool writePly(const float *points, size_t count, const ProgressCallback &progress);
+
+        // appends to the buffer and flushes it when it is full
+        bool append(const char *data, size_t size);
+
+        bool flush();
+
+        // reports progress if the interval passed since the last report
+        //
+        // @return: false if the export got aborted
+        bool reportProgress(size_t written, const ProgressCallback &progress);
+
+        std::vector<char> buffer;
+        size_t bufferUsed;
+        int fd;
+        long long lastProgress;
+    };
+}
+
+#endif //MASTERPROTOTYPE_POINTCLOUDEXPORTER_H
@@ -177,6 +177,7 @@ public class MainActivity extends Activity implements
         // between the application and Tango Service.
         // The activity object is used for checking if the API version is outdated.
         TangoJNINative.initialize(this);
+        TangoJNINative.setShaderCacheDirectory(getCacheDir().getAbsolutePath());
     }
 
     @Override
@@ -85,6 +85,36 @@ public class TangoJNINative {
     // change the the depth map to fullscreen
     public static native void setDepthFullscreen(boolean checked);
 
+    // render the occlusion objects only once into the depth buffer, they are
+    // shown at the occlusion resolution then, off by default
+    public static native void setSinglePassOcclusion(boolean singlePass);
+
+    // lower the occlusion resolution when frames take too long
+    public static native void setDynamicResolution(boolean dynamic);
+
+    // store linked shader programs in this directory to skip compiling them next time
+    public static native void setShaderCacheDirectory(String directory);
+
+    // plane detection of the plane mode, 0 is RANSAC per octree leaf and 1 region
+    // growing on the depth frame
+    public static native void setPlaneDetection(int detection);
+
+    // parameters of the plane reconstruction in every octree leaf, defaults are 2
+    // planes, 12 iterations, 0.12 m threshold, 0.33 support and 1.01 hull scale
+    public static native void setReconstructorConfig(int maxPlanes, int ransacIterations,
+                                                     float ransacThreshold,
+                                                     float ransacSufficientSupport,
+                                                     float hullScale);
+
+    // merge coplanar planes of the octree leaves into one mesh per surface
+    public static native void setMergeLeafPlanes(boolean merge);
+
+    // upload the geometry with quantized vertex positions and normals
+    public static native void setVertexCompression(boolean compressed);
+
+    // adapt the native quality parameters to hold the frame time
+    public static native void setAdaptiveQuality(boolean adaptive);
+
     // raypicking for the object placement
     public static native void addObject(float x, float y);
 
@@ -24,6 +24,7 @@ OPENCV:=/home/stetro/Source/opencv/platforms/build_android_arm/
 BOOST_ANDROID_INCLUDE := $(LOCAL_PATH)/../../../../native-libraries/boost
 EIGEN_INCLUDE := $(LOCAL_PATH)/../../../../native-libraries/eigen
 CHISEL := $(LOCAL_PATH)/../../../../native-libraries/open_chisel
+CONSTRUCT_NATIVE := $(LOCAL_PATH)/../../../../construct-native/src/main/jni
 
 
 include $(CLEAR_VARS)
@@ -70,7 +71,9 @@ LOCAL_SRC_FILES += $(TANGO_GL)/axis.cc \
                    $(CHISEL)/src/marching_cubes/MarchingCubes.cpp \
                    $(CHISEL)/src/io/PLY.cpp \
                    $(CHISEL)/src/geometry/Raycast.cpp \
+                   $(CONSTRUCT_NATIVE)/polygontriangulation.cc \
                    ar_object.cc \
+                   ply_loader.cc \
                    augmented_reality_app.cc \
                    jni_interface.cc \
                    pose_data.cc \
@@ -81,6 +84,17 @@ LOCAL_SRC_FILES += $(TANGO_GL)/axis.cc \
                    reconstructor.cc \
                    convex_hull.cc \
                    point_cloud_drawable.cc \
+                   streaming_vertex_buffer.cc \
+                   gpu_buffer_arena.cc \
+                   vertex_format.cc \
+                   shader_cache.cc \
+                   depth_readback.cc \
+                   depth_filter.cc \
+                   resolution_controller.cc \
+                   quality_controller.cc \
+                   organized_point_cloud.cc \
+                   plane_extractor.cc \
+                   plane_map.cc \
                    yuv_drawable.cc \
                    depth_drawable.cc \
                    tango_event_data.cc
@@ -89,7 +103,8 @@ LOCAL_C_INCLUDES += $(TANGO_GL)/include \
                     $(GLM)/ \
                     $(BOOST_ANDROID_INCLUDE)/include \
                     $(EIGEN_INCLUDE) \
-                    $(CHISEL)/include
+                    $(CHISEL)/include \
+                    $(CONSTRUCT_NATIVE)
 
 SYSTEM_C_INCLUDES +=
 
@@ -1,4 +1,57 @@
 #include "tango-augmented-reality/ar_object.h"
+#include "tango-augmented-reality/ply_loader.h"
+#include "tango-augmented-reality/shader_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace {
+    // same lighting as the tango-gl shaded shader, decodeNormal depends on the format
+    const std::string kShadedVertexShaderHeader =
+            "attribute vec4 vertex;\n"
+                    "uniform mat4 mvp;\n"
+                    "uniform mat4 mv;\n"
+                    "uniform vec4 color;\n"
+                    "uniform vec3 lightVec;\n"
+                    "varying vec4 v_color;\n";
+    const std::string kShadedVertexShaderMain =
+            "void main() {\n"
+                    "  gl_Position = mvp * vertex;\n"
+                    "  vec3 mvNormal = normalize(vec3(mv * vec4(decodeNormal(normal), 0.0)));\n"
+                    "  float diffuse = max(-dot(mvNormal, lightVec), 0.0);\n"
+                    "  v_color.a = color.a;\n"
+                    "  v_color.xyz = color.xyz * diffuse + color.xyz * 0.3;\n"
+                    "}\n";
+    const std::string kFloatVertexShader =
+            kShadedVertexShaderHeader +
+            "attribute vec3 normal;\n"
+                    "vec3 decodeNormal(vec3 n) { return n; }\n" +
+            kShadedVertexShaderMain;
+    const std::string kCompressedVertexShader =
+            kShadedVertexShaderHeader +
+            "attribute vec2 normal;\n" +
+            tango_augmented_reality::kOctDecodeNormalShader +
+            "vec3 decodeNormal(vec2 e) { return octDecodeNormal(e); }\n" +
+            kShadedVertexShaderMain;
+    const std::string kFragmentShader =
+            "precision mediump float;\n"
+                    "varying vec4 v_color;\n"
+                    "void main() {\n"
+                    "  gl_FragColor = v_color;\n"
+                    "}\n";
+
+    const char *kModelPath = "/storage/emulated/0/teapot.ply";
+
+    const glm::vec3 kLightDirection = glm::vec3(-1.0f, -3.0f, -1.0f);
+
+    // one vertex of the compressed buffer, 12 instead of 24 bytes
+    struct CompressedVertex {
+        GLshort position[4];
+        GLshort normal[2];
+    };
+}  // namespace
 
 
 namespace tango_augmented_reality {
@@ -27,76 +80,141 @@ namespace tango_augmented_reality {
             1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f,
             0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f};
 
-    ArObject::ArObject() {
-        SetShader(true);
-
-        std::ifstream input("/storage/emulated/0/teapot.ply");
-        std::string line;
-
-        if (input.is_open()) {
-            std::vector <glm::vec3> vertices;
-            std::vector <GLfloat> final_vertices;
-            std::vector <GLfloat> final_normals;
-
-            int vertices_count = 0;
-            int indices_count = 0;
-
-            bool end_of_header = false;
-            do {
-                std::getline(input, line);
-                line = line.substr(0, line.size() - 1);
-                std::sscanf(line.c_str(), "element vertex %d", &vertices_count);
-                std::sscanf(line.c_str(), "element face %d", &indices_count);
-                if (line.compare("end_header") == 0) {
-                    end_of_header = true;
-                }
-            } while (!end_of_header);
-
-            for (int i = 0; i < vertices_count; ++i) {
-                std::getline(input, line);
-                line = line.substr(0, line.size() - 1);
-                float x, y, z;
-                std::sscanf(line.c_str(), "%f %f %f", &x, &y, &z);
-                vertices.push_back(glm::vec3(x, y, z));
-            }
-
-            for (int i = 0; i < indices_count; ++i) {
-                std::getline(input, line);
-                line = line.substr(0, line.size() - 1);
-                unsigned short p0, p1, p2;
-                std::sscanf(line.c_str(), "3 %hu %hu %hu", &p0, &p1, &p2);
-
-                glm::vec3 normal = glm::cross(vertices[p1]-vertices[p0],vertices[p2]-vertices[p0]);
-                normal = glm::normalize(normal);
-                for (int j = 0; j < 3; ++j) {
-                    final_normals.push_back(normal.x);
-                    final_normals.push_back(normal.y);
-                    final_normals.push_back(normal.z);
-                }
-                final_vertices.push_back(vertices[p0].x);
-                final_vertices.push_back(vertices[p0].y);
-                final_vertices.push_back(vertices[p0].z);
-
-                final_vertices.push_back(vertices[p1].x);
-                final_vertices.push_back(vertices[p1].y);
-                final_vertices.push_back(vertices[p1].z);
-
-                final_vertices.push_back(vertices[p2].x);
-                final_vertices.push_back(vertices[p2].y);
-                final_vertices.push_back(vertices[p2].z);
-            }
-
-            SetVertices(final_vertices, final_normals);
+    ArObject::ArObject() : compressed_(false) {
+        render_mode_ = GL_TRIANGLES;
+        LoadProgram(float_program_, kFloatVertexShader);
+        LoadProgram(compressed_program_, kCompressedVertexShader);
+
+        // show the cube until the model is loaded
+        std::vector <GLfloat> vertices(const_vertices,
+                                       const_vertices +
+                                       sizeof(const_vertices) /
+                                       sizeof(GLfloat));
+        std::vector <GLfloat> normals(const_normals,
+                                      const_normals +
+                                      sizeof(const_normals) /
+                                      sizeof(GLfloat));
+        SetVertices(vertices, normals);
+        CreateCompressedBuffer();
+
+        // parse the model on a worker, the GL thread only uploads it
+        model_ = std::async(std::launch::async, []() {
+            PlyMesh mesh;
+            LoadPly(kModelPath, mesh);
+            return mesh;
+        });
+    }
+
+    bool ArObject::UpdateModel() {
+        if (!model_.valid() ||
+            model_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return false;
+        }
+        PlyMesh mesh = model_.get();
+        if (mesh.vertices.empty()) {
+            return false;
+        }
+        SetVertices(mesh.vertices, mesh.normals);
+        CreateCompressedBuffer();
+        return true;
+    }
+
+    ArObject::~ArObject() {
+        if (compressed_buffer_) {
+            glDeleteBuffers(1, &compressed_buffer_);
+        }
+    }
+
+    void ArObject::LoadProgram(Program &program, const std::string &vertex_shader) {
+        program.program = ShaderCache::GetProgram(vertex_shader, kFragmentShader);
+        if (!program.program) {
+            LOGE("Could not create program.");
+        }
+        program.mvp = glGetUniformLocation(program.program, "mvp");
+        program.mv = glGetUniformLocation(program.program, "mv");
+        program.color = glGetUniformLocation(program.program, "color");
+        program.light = glGetUniformLocation(program.program, "lightVec");
+        program.vertex = glGetAttribLocation(program.program, "vertex");
+        program.normal = glGetAttribLocation(program.program, "normal");
+    }
+
+    void ArObject::CreateCompressedBuffer() {
+        if (compressed_buffer_) {
+            glDeleteBuffers(1, &compressed_buffer_);
+            compressed_buffer_ = 0;
+        }
+        compressed_count_ = vertices_.size() / 3;
+        if (compressed_count_ == 0) {
+            return;
+        }
+
+        // quantize the positions inside the bounding cube of the object
+        glm::vec3 min_corner(vertices_[0], vertices_[1], vertices_[2]);
+        glm::vec3 max_corner = min_corner;
+        for (GLsizei i = 1; i < compressed_count_; ++i) {
+            glm::vec3 vertex(vertices_[i * 3], vertices_[i * 3 + 1], vertices_[i * 3 + 2]);
+            min_corner = glm::min(min_corner, vertex);
+            max_corner = glm::max(max_corner, vertex);
+        }
+        glm::vec3 extent = (max_corner - min_corner) * 0.5f;
+        float half_range = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f));
+        PositionQuantizer quantizer((min_corner + max_corner) * 0.5f, half_range);
+        decode_mat_ = quantizer.GetDecodeMatrix(VERTEX_FORMAT_SHORT);
+
+        std::vector <GLshort> positions;
+        quantizer.Encode(VERTEX_FORMAT_SHORT, vertices_.data(), compressed_count_, positions);
+        std::vector <CompressedVertex> compressed(compressed_count_);
+        for (GLsizei i = 0; i < compressed_count_; ++i) {
+            std::copy(positions.begin() + i * 4, positions.begin() + i * 4 + 4,
+                      compressed[i].position);
+            OctEncodeNormal(glm::vec3(normals_[i * 3], normals_[i * 3 + 1], normals_[i * 3 + 2]),
+                            compressed[i].normal);
+        }
+
+        glGenBuffers(1, &compressed_buffer_);
+        glBindBuffer(GL_ARRAY_BUFFER, compressed_buffer_);
+        glBufferData(GL_ARRAY_BUFFER, compressed.size() * sizeof(CompressedVertex),
+                     compressed.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void ArObject::Render(const glm::mat4 &projection_mat, const glm::mat4 &view_mat) const {
+        bool compressed = compressed_ && compressed_buffer_;
+        const Program &program = compressed ? compressed_program_ : float_program_;
+        glUseProgram(program.program);
+        glm::mat4 mv_mat = view_mat * GetTransformationMatrix();
+        glm::mat4 mvp_mat = projection_mat * mv_mat;
+        if (compressed) {
+            // the decode matrix only scales uniformly and moves, normals can skip it
+            mvp_mat = mvp_mat * decode_mat_;
+        }
+        glUniformMatrix4fv(program.mvp, 1, GL_FALSE, glm::value_ptr(mvp_mat));
+        glUniformMatrix4fv(program.mv, 1, GL_FALSE, glm::value_ptr(mv_mat));
+        glUniform4f(program.color, red_, green_, blue_, alpha_);
+        glm::vec3 light_direction = glm::mat3(view_mat) * kLightDirection;
+        glUniform3fv(program.light, 1, glm::value_ptr(light_direction));
+
+        glEnableVertexAttribArray(program.vertex);
+        glEnableVertexAttribArray(program.normal);
+        if (compressed) {
+            glBindBuffer(GL_ARRAY_BUFFER, compressed_buffer_);
+            glVertexAttribPointer(program.vertex, 4, GL_SHORT, GL_TRUE, sizeof(CompressedVertex),
+                                  reinterpret_cast<const GLvoid *>(
+                                          offsetof(CompressedVertex, position)));
+            glVertexAttribPointer(program.normal, 2, GL_SHORT, GL_TRUE, sizeof(CompressedVertex),
+                                  reinterpret_cast<const GLvoid *>(
+                                          offsetof(CompressedVertex, normal)));
+            glDrawArrays(render_mode_, 0, compressed_count_);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
         } else {
-            std::vector <GLfloat> vertices(const_vertices,
-                                           const_vertices +
-                                           sizeof(const_vertices) /
-                                           sizeof(GLfloat));
-            std::vector <GLfloat> normals(const_normals,
-                                          const_normals +
-                                          sizeof(const_normals) /
-                                          sizeof(GLfloat));
-            SetVertices(vertices, normals);
+            glVertexAttribPointer(program.vertex, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat),
+                                  vertices_.data());
+            glVertexAttribPointer(program.normal, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat),
+                                  normals_.data());
+            glDrawArrays(render_mode_, 0, vertices_.size() / 3);
         }
+        glDisableVertexAttribArray(program.normal);
+        glDisableVertexAttribArray(program.vertex);
+        glUseProgram(0);
     }
-}  // namespace tango_gl
\ No newline at end of file
+}  // namespace tango_gl
@@ -21,6 +21,9 @@
 namespace {
     const int kVersionStringLength = 128;
 
+    // Frame time the adaptive quality tries to hold.
+    const float kTargetFrameTimeMs = 33.0f;
+
     // Far clipping plane of the AR camera.
     const float kArCameraNearClippingPlane = 0.1f;
     const float kArCameraFarClippingPlane = 50.0f;
@@ -67,8 +70,7 @@ namespace {
 namespace tango_augmented_reality {
 
     void AugmentedRealityApp::onFrameAvailable(const TangoImageBuffer *buffer) {
-        skip_value++;
-        if (skip_value % SKIP_INTERVAL == 0) {
+        if (++skip_value >= skip_interval) {
             skip_value = 0;
             if (init) {
                 time(&timev);
@@ -97,7 +99,11 @@ namespace tango_augmented_reality {
     }
 
     AugmentedRealityApp::AugmentedRealityApp() : calling_activity_obj_(nullptr),
-                                                 on_demand_render_(nullptr) {
+                                                 on_demand_render_(nullptr),
+                                                 skip_value(0),
+                                                 skip_interval(SKIP_INTERVAL),
+                                                 quality_controller_(kTargetFrameTimeMs),
+                                                 reset_quality_(false) {
     }
 
     AugmentedRealityApp::~AugmentedRealityApp() {
@@ -303,6 +309,25 @@ namespace tango_augmented_reality {
         glm::mat4 color_camera_pose = GetPoseMatrixAtTimestamp(video_overlay_timestamp);
         color_camera_pose = pose_data_.GetExtrinsicsAppliedOpenGLWorldFrame(color_camera_pose);
         main_scene_.Render(color_camera_pose);
+
+        if (reset_quality_) {
+            reset_quality_ = false;
+            quality_controller_.Reset();
+            ApplyQualitySettings();
+        }
+
+        float stage_ms[STAGE_COUNT];
+        float frame_ms;
+        if (adaptive_quality && main_scene_.GetFrameTimings(stage_ms, &frame_ms) &&
+            quality_controller_.Update(stage_ms, frame_ms)) {
+            ApplyQualitySettings();
+        }
+    }
+
+    void AugmentedRealityApp::ApplyQualitySettings() {
+        const QualitySettings &settings = quality_controller_.GetSettings();
+        skip_interval = settings.skip_interval;
+        main_scene_.SetQualitySettings(settings);
     }
 
     void AugmentedRealityApp::DeleteResources() { main_scene_.DeleteResources(); }
@@ -416,6 +441,44 @@ namespace tango_augmented_reality {
         main_scene_.SetDepthFullscreen(show);
     }
 
+    void AugmentedRealityApp::setSinglePassOcclusion(bool single_pass) {
+        main_scene_.SetSinglePassOcclusion(single_pass);
+    }
+
+    void AugmentedRealityApp::setDynamicResolution(bool dynamic) {
+        main_scene_.SetDynamicResolution(dynamic);
+    }
+
+    void AugmentedRealityApp::setShaderCacheDirectory(const std::string &directory) {
+        ShaderCache::SetDirectory(directory);
+    }
+
+    void AugmentedRealityApp::setPlaneDetection(int detection) {
+        main_scene_.SetPlaneDetection(detection);
+    }
+
+    void AugmentedRealityApp::setReconstructorConfig(const ReconstructorConfig &config) {
+        main_scene_.SetReconstructorConfig(config);
+    }
+
+    void AugmentedRealityApp::setMergeLeafPlanes(bool merge) {
+        main_scene_.SetMergeLeafPlanes(merge);
+    }
+
+    void AugmentedRealityApp::setVertexCompression(bool compressed) {
+        main_scene_.SetVertexCompression(compressed);
+    }
+
+    void AugmentedRealityApp::setAdaptiveQuality(bool adaptive) {
+        adaptive_quality = adaptive;
+        if (adaptive) {
+            // the quality controller owns the occlusion resolution now
+            main_scene_.SetDynamicResolution(false);
+        }
+        // settings touch GL resources, they are applied with the next frame
+        reset_quality_ = true;
+    }
+
     void AugmentedRealityApp::addObject(float x, float y) {
         x *= image_width;
         y *= image_height;
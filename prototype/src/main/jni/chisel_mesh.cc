@@ -17,10 +17,19 @@
 #include "tango-augmented-reality/chisel_mesh.h"
 #include <tango-gl/shaders.h>
 
+#include "tango-augmented-reality/shader_cache.h"
+
+namespace {
+    const GLsizei kInitialArenaVertices = 256 * 1024;
+}  // namespace
+
 namespace tango_augmented_reality {
-    ChiselMesh::ChiselMesh() {
+    ChiselMesh::ChiselMesh() : quantizer(glm::vec3(0, 0, 0), kReconstructionHalfRange) {
         render_mode_ = GL_TRIANGLES;
         SetShader();
+        vertexFormat = VERTEX_FORMAT_FLOAT;
+        pendingVertexFormat = VERTEX_FORMAT_FLOAT;
+        arena_ = new GpuBufferArena(vertexFormat, kInitialArenaVertices);
 
         chunkSize = 8;
         truncationDistScale = 8.0;
@@ -31,7 +40,11 @@ namespace tango_augmented_reality {
         farClipping = 2.0;
         rayTruncation = 0.5;
 
+        createMap();
+        LOGI("chisel container was created in native environment");
+    }
 
+    void ChiselMesh::createMap() {
         chiselMap = chisel::ChiselPtr(
                 new chisel::Chisel(Eigen::Vector3i(chunkSize, chunkSize, chunkSize),
                                    chunkResolution, false));
@@ -43,7 +56,6 @@ namespace tango_augmented_reality {
         projectionIntegrator = chisel::ProjectionIntegrator(truncator, weighter, carvingDistance,
                                                             enableCarving, centroids);
         projectionIntegrator.SetCentroids(chiselMap->GetChunkManager().GetCentroids());
-        LOGI("chisel container was created in native environment");
     }
 
     void ChiselMesh::addPoints(glm::mat4 transformation, TangoCameraIntrinsics intrinsics,
@@ -116,42 +128,81 @@ namespace tango_augmented_reality {
     }
 
     void ChiselMesh::updateVertices() {
+        // remember the chunks chisel is going to remesh, only those get uploaded
+        chisel::ChunkSet updatedChunks = chiselMap->GetMeshesToUpdate();
         chiselMap->UpdateMeshes();
         LOGI("Generating Mesh ...");
-        chisel::MeshMap meshMap = chiselMap->GetChunkManager().GetAllMeshes();
-        LOGI("Map with %d items", meshMap.size());
+        const chisel::MeshMap &meshMap = chiselMap->GetChunkManager().GetAllMeshes();
+        LOGI("Map with %d items, %d updated", meshMap.size(), updatedChunks.size());
 
+        std::lock_guard <std::mutex> lock(render_mutex);
+        if (pendingVertexFormat != vertexFormat) {
+            // a new arena in the requested format, every chunk is uploaded again
+            delete arena_;
+            vertexFormat = pendingVertexFormat;
+            arena_ = new GpuBufferArena(vertexFormat, kInitialArenaVertices);
+            chunkHandles.clear();
+        }
         std::vector <GLfloat> mesh;
+        std::vector <GLshort> quantized;
         for (const std::pair <chisel::ChunkID, chisel::MeshPtr> &meshes : meshMap) {
+            std::unordered_map<chisel::ChunkID, int, chisel::ChunkHasher>::iterator handle =
+                    chunkHandles.find(meshes.first);
+            if (handle != chunkHandles.end() &&
+                updatedChunks.find(meshes.first) == updatedChunks.end()) {
+                continue;
+            }
+            mesh.clear();
             for (size_t &index: meshes.second->indices) {
                 mesh.push_back(meshes.second->vertices[index](0));
                 mesh.push_back(meshes.second->vertices[index](1));
                 mesh.push_back(meshes.second->vertices[index](2));
             }
+            GLsizei count = mesh.size() / 3;
+            const void *data = quantizer.Encode(vertexFormat, mesh.data(), count, quantized);
+            if (handle == chunkHandles.end()) {
+                chunkHandles[meshes.first] = arena_->Allocate(data, count);
+            } else {
+                arena_->Update(handle->second, data, count);
+            }
         }
-        LOGI("Got %d polygons", mesh.size() / 3);
 
-        {
-            std::lock_guard <std::mutex> lock(render_mutex);
-            SetVertices(mesh);
+        // drop chunks chisel does not mesh anymore
+        for (std::unordered_map<chisel::ChunkID, int, chisel::ChunkHasher>::iterator it =
+                chunkHandles.begin(); it != chunkHandles.end();) {
+            if (meshMap.find(it->first) == meshMap.end()) {
+                arena_->Free(it->second);
+                it = chunkHandles.erase(it);
+            } else {
+                ++it;
+            }
         }
+        LOGI("Got %d polygons", arena_->GetVertexCount() / 3);
     }
 
     void ChiselMesh::clear() {
         std::lock_guard <std::mutex> lock(render_mutex);
-        std::vector <GLfloat> mesh;
-        SetVertices(mesh);
+        arena_->Clear();
+        chunkHandles.clear();
         chiselMap->Reset();
     }
 
-    ChiselMesh::ChiselMesh(GLenum render_mode) {
+    ChiselMesh::ChiselMesh(GLenum render_mode) :
+            quantizer(glm::vec3(0, 0, 0), kReconstructionHalfRange) {
         render_mode_ = render_mode;
+        vertexFormat = VERTEX_FORMAT_FLOAT;
+        pendingVertexFormat = VERTEX_FORMAT_FLOAT;
+        arena_ = new GpuBufferArena(vertexFormat, kInitialArenaVertices);
+    }
+
+    ChiselMesh::~ChiselMesh() {
+        delete arena_;
     }
 
     void ChiselMesh::SetShader() {
-        shader_program_ = tango_gl::util::CreateProgram(
-                tango_gl::shaders::GetBasicVertexShader().c_str(),
-                tango_gl::shaders::GetBasicFragmentShader().c_str());
+        // the basic program is shared by all reconstruction meshes
+        shader_program_ = ShaderCache::GetProgram(tango_gl::shaders::GetBasicVertexShader(),
+                                                  tango_gl::shaders::GetBasicFragmentShader());
         if (!shader_program_) {
             LOGE("Could not create program.");
         }
@@ -163,29 +214,22 @@ namespace tango_augmented_reality {
         SetAlpha(0.4);
     }
 
+    void ChiselMesh::setVertexFormat(VertexFormat format) {
+        std::lock_guard <std::mutex> lock(render_mutex);
+        pendingVertexFormat = format;
+    }
+
     void ChiselMesh::Render(const glm::mat4 &projection_mat,
                             const glm::mat4 &view_mat) const {
         glUseProgram(shader_program_);
         glm::mat4 model_mat = GetTransformationMatrix();
         glm::mat4 mv_mat = view_mat * model_mat;
-        glm::mat4 mvp_mat = projection_mat * mv_mat;
+        // positions in a compressed format are decoded by the mvp matrix
+        glm::mat4 mvp_mat = projection_mat * mv_mat * quantizer.GetDecodeMatrix(vertexFormat);
         glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
         glUniform4f(uniform_color_, red_, green_, blue_, alpha_);
 
-        glEnableVertexAttribArray(attrib_vertices_);
-
-        if (!indices_.empty()) {
-            glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
-                                  3 * sizeof(GLfloat), vertices_.data());
-            glDrawElements(render_mode_, indices_.size(), GL_UNSIGNED_SHORT,
-                           indices_.data());
-        } else {
-            glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
-                                  3 * sizeof(GLfloat), &vertices_[0]);
-            glDrawArrays(render_mode_, 0, vertices_.size() / 3);
-        }
-
-        glDisableVertexAttribArray(attrib_vertices_);
+        arena_->Draw(render_mode_, attrib_vertices_);
         glUseProgram(0);
     }
 }  // namespace tango_augmented_reality
@@ -15,6 +15,7 @@
  */
 
 #include "tango-augmented-reality/depth_drawable.h"
+#include "tango-augmented-reality/shader_cache.h"
 #include <string>
 
 namespace {
@@ -51,8 +52,7 @@ namespace tango_augmented_reality {
 
     DepthDrawable::DepthDrawable() {
         glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
-        shader_program_ = tango_gl::util::CreateProgram(kVertexShader.c_str(),
-                                                        kFragmetnShader.c_str());
+        shader_program_ = ShaderCache::GetProgram(kVertexShader, kFragmetnShader);
         if (!shader_program_) {
             LOGE("Could not create program.");
         }
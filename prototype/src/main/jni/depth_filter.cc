@@ -0,0 +1,100 @@
+#include "tango-augmented-reality/depth_filter.h"
+
+#include <android/log.h>
+#include <sys/time.h>
+
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/ximgproc.hpp>
+
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG  , "Native",__VA_ARGS__)
+
+namespace {
+    long long currentTimeInMilliseconds() {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        return ((tv.tv_sec * 1000) + (tv.tv_usec / 1000));
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    DepthFilter::DepthFilter() : last_filter_time_ms_(0.0f) {
+        worker_ = std::thread(&DepthFilter::Run, this);
+    }
+
+    DepthFilter::~DepthFilter() {
+        {
+            std::lock_guard <std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        condition_.notify_one();
+        worker_.join();
+    }
+
+    void DepthFilter::Submit(const cv::Mat &depth, const cv::Mat &rgb, int diameter,
+                             double sigma) {
+        {
+            std::lock_guard <std::mutex> lock(mutex_);
+            depth.copyTo(pending_depth_);
+            rgb.copyTo(pending_rgb_);
+            pending_diameter_ = diameter;
+            pending_sigma_ = sigma;
+            has_pending_ = true;
+        }
+        condition_.notify_one();
+    }
+
+    bool DepthFilter::TakeResult(cv::Mat &target) {
+        std::lock_guard <std::mutex> lock(mutex_);
+        if (!has_result_) {
+            return false;
+        }
+        cv::swap(target, result_);
+        has_result_ = false;
+        return true;
+    }
+
+    void DepthFilter::Filter(const cv::Mat &depth, const cv::Mat &rgb, int diameter,
+                             double sigma, cv::Mat &filtered) {
+        // apply opencv filters
+        cv::Mat temp_frame;
+        depth.convertTo(temp_frame, CV_8U, 0.00390625);
+        cv::ximgproc::guidedFilter(rgb, temp_frame, temp_frame, diameter, sigma);
+        temp_frame.convertTo(filtered, CV_16UC1, 255);
+    }
+
+    void DepthFilter::Run() {
+        cv::Mat depth;
+        cv::Mat rgb;
+        cv::Mat filtered;
+        while (true) {
+            int diameter;
+            double sigma;
+            {
+                std::unique_lock <std::mutex> lock(mutex_);
+                condition_.wait(lock, [this] { return has_pending_ || !running_; });
+                if (!running_) {
+                    return;
+                }
+                cv::swap(depth, pending_depth_);
+                cv::swap(rgb, pending_rgb_);
+                diameter = pending_diameter_;
+                sigma = pending_sigma_;
+                has_pending_ = false;
+            }
+
+            long long before = currentTimeInMilliseconds();
+            Filter(depth, rgb, diameter, sigma, filtered);
+            long long after = currentTimeInMilliseconds();
+            LOGD("%lld miliseconds for filtering", after - before);
+            last_filter_time_ms_ = static_cast<float>(after - before);
+
+            {
+                std::lock_guard <std::mutex> lock(mutex_);
+                cv::swap(result_, filtered);
+                has_result_ = true;
+            }
+        }
+    }
+
+}  // namespace tango_augmented_reality
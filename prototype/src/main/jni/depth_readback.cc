@@ -0,0 +1,89 @@
+#include "tango-augmented-reality/depth_readback.h"
+
+#include <cstring>
+
+namespace tango_augmented_reality {
+
+    DepthReadback::DepthReadback(int width, int height, GLenum gl_depth_format) :
+            width_(width),
+            height_(height),
+            gl_depth_format_(gl_depth_format) {
+        size_t pixel_size = gl_depth_format == GL_UNSIGNED_SHORT ? sizeof(GLushort)
+                                                                 : sizeof(GLuint);
+        size_ = width * height * pixel_size;
+
+        glGenBuffers(2, pixel_buffers_);
+        for (int i = 0; i < 2; ++i) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers_[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, size_, nullptr, GL_STREAM_READ);
+            fences_[i] = 0;
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    DepthReadback::~DepthReadback() {
+        DeleteGlResources();
+    }
+
+    void DepthReadback::DeleteGlResources() {
+        for (int i = 0; i < 2; ++i) {
+            if (fences_[i]) {
+                glDeleteSync(fences_[i]);
+                fences_[i] = 0;
+            }
+        }
+        if (pixel_buffers_[0]) {
+            glDeleteBuffers(2, pixel_buffers_);
+            pixel_buffers_[0] = 0;
+            pixel_buffers_[1] = 0;
+        }
+    }
+
+    void DepthReadback::Read(GLuint frame_buffer) {
+        if (fences_[write_index_]) {
+            // the buffer was never mapped, drop the old read
+            glDeleteSync(fences_[write_index_]);
+        }
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, frame_buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers_[write_index_]);
+        // with a bound pack buffer the last argument is an offset, the call returns
+        // without waiting for the render to finish
+        glReadPixels(0, 0, width_, height_, GL_DEPTH_COMPONENT, gl_depth_format_, 0);
+        fences_[write_index_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+        write_index_ = 1 - write_index_;
+        tango_gl::util::CheckGlError("DepthReadback::Read()");
+    }
+
+    bool DepthReadback::Map(cv::Mat &target) {
+        // after Read() the write index points to the older of both reads
+        int read_index = write_index_;
+        GLsync fence = fences_[read_index];
+        if (!fence) {
+            return false;
+        }
+
+        // poll without timeout, an unfinished read is picked up next frame
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            return false;
+        }
+        glDeleteSync(fence);
+        fences_[read_index] = 0;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers_[read_index]);
+        void *data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size_, GL_MAP_READ_BIT);
+        bool mapped = data != nullptr;
+        if (mapped) {
+            memcpy(target.ptr(), data, size_);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        tango_gl::util::CheckGlError("DepthReadback::Map()");
+        return mapped;
+    }
+
+}  // namespace tango_augmented_reality
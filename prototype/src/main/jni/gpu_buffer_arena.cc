@@ -0,0 +1,239 @@
+#include "tango-augmented-reality/gpu_buffer_arena.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace {
+    // extra vertices reserved per piece, so small updates stay in place
+    const float kSlack = 0.25f;
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    GpuBufferArena::GpuBufferArena(VertexFormat format, GLsizei capacity) :
+            format_(format),
+            stride_(GetVertexStride(format)),
+            capacity_(capacity) {
+        glGenBuffers(1, &buffer_);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+        glBufferData(GL_ARRAY_BUFFER, capacity_ * stride_, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        free_ranges_[0] = capacity_;
+    }
+
+    GpuBufferArena::~GpuBufferArena() {
+        DeleteGlResources();
+    }
+
+    void GpuBufferArena::DeleteGlResources() {
+        if (buffer_) {
+            glDeleteBuffers(1, &buffer_);
+            buffer_ = 0;
+        }
+    }
+
+    int GpuBufferArena::Allocate(const void *data, GLsizei count) {
+        Allocation allocation;
+        allocation.capacity = count + static_cast<GLsizei>(count * kSlack);
+        allocation.count = count;
+        allocation.offset = Reserve(allocation.capacity);
+        Upload(allocation.offset, data, count);
+
+        int handle = next_handle_++;
+        allocations_[handle] = allocation;
+        used_ += count;
+        return handle;
+    }
+
+    void GpuBufferArena::Update(int handle, const void *data, GLsizei count) {
+        std::map<int, Allocation>::iterator it = allocations_.find(handle);
+        if (it == allocations_.end()) {
+            return;
+        }
+        used_ += count - it->second.count;
+        if (count <= it->second.capacity) {
+            it->second.count = count;
+            Upload(it->second.offset, data, count);
+            return;
+        }
+
+        // the piece outgrew its range, move it. It is taken out of the pieces
+        // while reserving, so packing the buffer does not lay out its old range.
+        Allocation allocation = it->second;
+        allocations_.erase(it);
+        Release(allocation.offset, allocation.capacity);
+        allocation.capacity = count + static_cast<GLsizei>(count * kSlack);
+        allocation.count = count;
+        allocation.offset = Reserve(allocation.capacity);
+        allocations_[handle] = allocation;
+        Upload(allocation.offset, data, count);
+    }
+
+    void GpuBufferArena::Free(int handle) {
+        std::map<int, Allocation>::iterator it = allocations_.find(handle);
+        if (it == allocations_.end()) {
+            return;
+        }
+        used_ -= it->second.count;
+        Release(it->second.offset, it->second.capacity);
+        allocations_.erase(it);
+    }
+
+    void GpuBufferArena::Clear() {
+        allocations_.clear();
+        free_ranges_.clear();
+        free_ranges_[0] = capacity_;
+        used_ = 0;
+        reserved_ = 0;
+    }
+
+    void GpuBufferArena::Draw(GLenum mode, GLuint attrib) const {
+        if (allocations_.empty()) {
+            return;
+        }
+        std::vector <Allocation> ranges;
+        ranges.reserve(allocations_.size());
+        for (std::map<int, Allocation>::const_iterator it = allocations_.begin();
+             it != allocations_.end(); ++it) {
+            if (it->second.count > 0) {
+                ranges.push_back(it->second);
+            }
+        }
+        std::sort(ranges.begin(), ranges.end(), [](const Allocation &a, const Allocation &b) {
+            return a.offset < b.offset;
+        });
+
+        glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+        glEnableVertexAttribArray(attrib);
+        SetVertexAttribPointer(format_, attrib, 0);
+
+        // join pieces which are completely filled and directly follow each other
+        GLint first = 0;
+        GLsizei count = 0;
+        for (size_t i = 0; i < ranges.size(); ++i) {
+            if (count > 0 && first + count == ranges[i].offset) {
+                count += ranges[i].count;
+            } else {
+                if (count > 0) {
+                    glDrawArrays(mode, first, count);
+                }
+                first = ranges[i].offset;
+                count = ranges[i].count;
+            }
+            if (ranges[i].count < ranges[i].capacity) {
+                glDrawArrays(mode, first, count);
+                count = 0;
+            }
+        }
+        if (count > 0) {
+            glDrawArrays(mode, first, count);
+        }
+
+        glDisableVertexAttribArray(attrib);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    GLint GpuBufferArena::FindRange(GLsizei count) {
+        for (std::map<GLint, GLsizei>::iterator it = free_ranges_.begin();
+             it != free_ranges_.end(); ++it) {
+            if (it->second >= count) {
+                GLint offset = it->first;
+                GLsizei rest = it->second - count;
+                free_ranges_.erase(it);
+                if (rest > 0) {
+                    free_ranges_[offset + count] = rest;
+                }
+                return offset;
+            }
+        }
+        return -1;
+    }
+
+    GLint GpuBufferArena::Reserve(GLsizei capacity) {
+        GLint offset = FindRange(capacity);
+        GLsizei needed = reserved_ + capacity;
+        if (offset < 0 && needed <= capacity_ && reserved_ < capacity_ / 2) {
+            // enough space, but too fragmented
+            Reallocate(capacity_);
+            offset = FindRange(capacity);
+        }
+        if (offset < 0) {
+            // packing leaves the tail behind all reserved ranges free
+            Reallocate(std::max(capacity_ * 2, needed * 3 / 2));
+            offset = FindRange(capacity);
+        }
+        assert(offset >= 0);
+        reserved_ += capacity;
+        return offset;
+    }
+
+    void GpuBufferArena::Release(GLint offset, GLsizei capacity) {
+        reserved_ -= capacity;
+        std::map<GLint, GLsizei>::iterator next = free_ranges_.lower_bound(offset);
+        // merge with following range
+        if (next != free_ranges_.end() && offset + capacity == next->first) {
+            capacity += next->second;
+            next = free_ranges_.erase(next);
+        }
+        // merge with previous range
+        if (next != free_ranges_.begin()) {
+            std::map<GLint, GLsizei>::iterator previous = next;
+            --previous;
+            if (previous->first + previous->second == offset) {
+                previous->second += capacity;
+                return;
+            }
+        }
+        free_ranges_[offset] = capacity;
+    }
+
+    void GpuBufferArena::Reallocate(GLsizei capacity) {
+        GLuint buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, capacity * stride_, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer_);
+
+        // pack all pieces in offset order, the copies stay on the GPU
+        std::vector < std::pair < GLint, int > > order;
+        for (std::map<int, Allocation>::iterator it = allocations_.begin();
+             it != allocations_.end(); ++it) {
+            order.push_back(std::make_pair(it->second.offset, it->first));
+        }
+        std::sort(order.begin(), order.end());
+        GLint offset = 0;
+        for (size_t i = 0; i < order.size(); ++i) {
+            Allocation &allocation = allocations_[order[i].second];
+            if (allocation.count > 0) {
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                                    allocation.offset * stride_, offset * stride_,
+                                    allocation.count * stride_);
+            }
+            allocation.offset = offset;
+            offset += allocation.capacity;
+        }
+
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glDeleteBuffers(1, &buffer_);
+        buffer_ = buffer;
+        capacity_ = capacity;
+
+        free_ranges_.clear();
+        if (offset < capacity_) {
+            free_ranges_[offset] = capacity_ - offset;
+        }
+        tango_gl::util::CheckGlError("GpuBufferArena::Reallocate()");
+    }
+
+    void GpuBufferArena::Upload(GLint offset, const void *data, GLsizei count) {
+        if (count == 0) {
+            return;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+        glBufferSubData(GL_ARRAY_BUFFER, offset * stride_, count * stride_, data);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+}  // namespace tango_augmented_reality
@@ -158,6 +158,63 @@ Java_de_stetro_master_prototype_TangoJNINative_setDepthFullscreen(
 app.setDepthFullscreen(show);
 }
 
+JNIEXPORT void JNICALL
+Java_de_stetro_master_prototype_TangoJNINative_setSinglePassOcclusion(
+        JNIEnv*, jobject, jboolean single_pass) {
+app.setSinglePassOcclusion(single_pass);
+}
+
+JNIEXPORT void JNICALL
+Java_de_stetro_master_prototype_TangoJNINative_setDynamicResolution(
+        JNIEnv*, jobject, jboolean dynamic) {
+app.setDynamicResolution(dynamic);
+}
+
+JNIEXPORT void JNICALL
+Java_de_stetro_master_prototype_TangoJNINative_setShaderCacheDirectory(
+        JNIEnv* env, jobject, jstring directory) {
+const char* path = env->GetStringUTFChars(directory, nullptr);
+app.setShaderCacheDirectory(path);
+env->ReleaseStringUTFChars(directory, path);
+}
+
+JNIEXPORT void JNICALL
+Java_de_stetro_master_prototype_TangoJNINative_setPlaneDetection(
+        JNIEnv*, jobject, jint detection) {
+app.setPlaneDetection(detection);
+}
+
+JNIEXPORT void JNICALL
+Java_de_stetro_master_prototype_TangoJNINative_setReconstructorConfig(
+        JNIEnv*, jobject, jint max_planes, jint ransac_iterations, jfloat ransac_threshold,
+        jfloat ransac_sufficient_support, jfloat hull_scale) {
+tango_augmented_reality::ReconstructorConfig config;
+config.max_planes = max_planes;
+config.ransac_iterations = ransac_iterations;
+config.ransac_threshold = ransac_threshold;
+config.ransac_sufficient_support = ransac_sufficient_support;
+config.hull_scale = hull_scale;
+app.setReconstructorConfig(config);
+}
+
+JNIEXPORT void JNICALL
+Java_de_stetro_master_prototype_TangoJNINative_setMergeLeafPlanes(
+        JNIEnv*, jobject, jboolean merge) {
+app.setMergeLeafPlanes(merge);
+}
+
+JNIEXPORT void JNICALL
+Java_de_stetro_master_prototype_TangoJNINative_setVertexCompression(
+        JNIEnv*, jobject, jboolean compressed) {
+app.setVertexCompression(compressed);
+}
+
+JNIEXPORT void JNICALL
+Java_de_stetro_master_prototype_TangoJNINative_setAdaptiveQuality(
+        JNIEnv*, jobject, jboolean adaptive) {
+app.setAdaptiveQuality(adaptive);
+}
+
 JNIEXPORT void JNICALL
 Java_de_stetro_master_prototype_TangoJNINative_addObject(
         JNIEnv*, jobject, float x, float y) {
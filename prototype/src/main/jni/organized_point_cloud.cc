@@ -0,0 +1,80 @@
+#include "tango-augmented-reality/organized_point_cloud.h"
+
+#include <cmath>
+
+namespace {
+    // allowed depth difference between neighbouring cells, relative to the depth
+    // and per cell between them
+    const float kMaxDepthChangeFactor = 0.02f;
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    OrganizedPointCloud::OrganizedPointCloud() { }
+
+    void OrganizedPointCloud::Update(const TangoXYZij &xyz_ij,
+                                     const TangoCameraIntrinsics &intrinsics, int downscale) {
+        width_ = intrinsics.width / downscale;
+        height_ = intrinsics.height / downscale;
+        int size = width_ * height_;
+        points_.resize(size);
+        flags_.assign(size, 0);
+
+        float fx = static_cast<float>(intrinsics.fx) / downscale;
+        float fy = static_cast<float>(intrinsics.fy) / downscale;
+        float cx = static_cast<float>(intrinsics.cx) / downscale;
+        float cy = static_cast<float>(intrinsics.cy) / downscale;
+        for (uint32_t i = 0; i < xyz_ij.xyz_count; ++i) {
+            glm::vec3 point(xyz_ij.xyz[i][0], xyz_ij.xyz[i][1], xyz_ij.xyz[i][2]);
+            if (point.z <= 0.0f) {
+                continue;
+            }
+            int x = static_cast<int>(fx * point.x / point.z + cx);
+            int y = static_cast<int>(fy * point.y / point.z + cy);
+            if (x < 0 || x >= width_ || y < 0 || y >= height_) {
+                continue;
+            }
+            int index = y * width_ + x;
+            if (!HasPoint(index) || point.z < points_[index].z) {
+                points_[index] = point;
+                flags_[index] = kHasPoint;
+            }
+        }
+    }
+
+    void OrganizedPointCloud::ComputeSmoothMask(int radius) {
+        for (int y = 0; y < height_; ++y) {
+            for (int x = 0; x < width_; ++x) {
+                int index = y * width_ + x;
+                if (!HasPoint(index)) {
+                    continue;
+                }
+                flags_[index] &= ~kIsSmooth;
+                if (HasSmoothNeighbour(x, y, -1, 0, radius) &&
+                    HasSmoothNeighbour(x, y, 1, 0, radius) &&
+                    HasSmoothNeighbour(x, y, 0, -1, radius) &&
+                    HasSmoothNeighbour(x, y, 0, 1, radius)) {
+                    flags_[index] |= kIsSmooth;
+                }
+            }
+        }
+    }
+
+    bool OrganizedPointCloud::HasSmoothNeighbour(int x, int y, int dx, int dy,
+                                                 int radius) const {
+        float depth = points_[y * width_ + x].z;
+        for (int step = 1; step <= radius; ++step) {
+            int nx = x + dx * step;
+            int ny = y + dy * step;
+            if (nx < 0 || nx >= width_ || ny < 0 || ny >= height_) {
+                return false;
+            }
+            int index = ny * width_ + nx;
+            if (HasPoint(index)) {
+                float max_change = kMaxDepthChangeFactor * depth * step;
+                return std::fabs(points_[index].z - depth) <= max_change;
+            }
+        }
+        return false;
+    }
+}  // namespace tango_augmented_reality
@@ -0,0 +1,207 @@
+#include "tango-augmented-reality/plane_extractor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <Eigen/Core>
+#include <Eigen/Eigenvalues>
+
+namespace {
+    // cells per block edge
+    const int kBlockSize = 4;
+    // blocks need half of their cells filled
+    const int kMinBlockPoints = kBlockSize * kBlockSize / 2;
+    // allowed plane fitting error, the depth noise grows with the square of the depth
+    const float kMaxRmsBase = 0.005f;
+    const float kMaxRmsDepth = 0.0025f;
+    // neighbouring blocks are only merged if their normals are this close
+    const float kMinMergeCosine = 0.95f;
+    // planes need this many blocks
+    const int kMinPlaneBlocks = 3;
+
+    float MaxMse(float depth) {
+        float rms = kMaxRmsBase + kMaxRmsDepth * depth * depth;
+        return rms * rms;
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    void PlaneMoments::Add(const glm::vec3 &point) {
+        sum_[0] += point.x;
+        sum_[1] += point.y;
+        sum_[2] += point.z;
+        sum_sq_[0] += point.x * point.x;
+        sum_sq_[1] += point.x * point.y;
+        sum_sq_[2] += point.x * point.z;
+        sum_sq_[3] += point.y * point.y;
+        sum_sq_[4] += point.y * point.z;
+        sum_sq_[5] += point.z * point.z;
+        count_++;
+    }
+
+    void PlaneMoments::Merge(const PlaneMoments &other) {
+        for (int i = 0; i < 3; ++i) {
+            sum_[i] += other.sum_[i];
+        }
+        for (int i = 0; i < 6; ++i) {
+            sum_sq_[i] += other.sum_sq_[i];
+        }
+        count_ += other.count_;
+    }
+
+    glm::vec3 PlaneMoments::GetMean() const {
+        if (count_ == 0) {
+            return glm::vec3(0, 0, 0);
+        }
+        return glm::vec3(sum_[0] / count_, sum_[1] / count_, sum_[2] / count_);
+    }
+
+    bool PlaneMoments::Fit(glm::vec3 *normal, float *distance, float *mse) const {
+        if (count_ < 3) {
+            return false;
+        }
+        double mean[3] = {sum_[0] / count_, sum_[1] / count_, sum_[2] / count_};
+        Eigen::Matrix3d covariance;
+        covariance(0, 0) = sum_sq_[0] / count_ - mean[0] * mean[0];
+        covariance(0, 1) = sum_sq_[1] / count_ - mean[0] * mean[1];
+        covariance(0, 2) = sum_sq_[2] / count_ - mean[0] * mean[2];
+        covariance(1, 1) = sum_sq_[3] / count_ - mean[1] * mean[1];
+        covariance(1, 2) = sum_sq_[4] / count_ - mean[1] * mean[2];
+        covariance(2, 2) = sum_sq_[5] / count_ - mean[2] * mean[2];
+        covariance(1, 0) = covariance(0, 1);
+        covariance(2, 0) = covariance(0, 2);
+        covariance(2, 1) = covariance(1, 2);
+
+        // the eigen vector of the smallest eigen value is the normal
+        Eigen::SelfAdjointEigenSolver <Eigen::Matrix3d> solver(covariance);
+        Eigen::Vector3d smallest = solver.eigenvectors().col(0);
+        *normal = glm::normalize(glm::vec3(smallest[0], smallest[1], smallest[2]));
+        *distance = normal->x * mean[0] + normal->y * mean[1] + normal->z * mean[2];
+        *mse = static_cast<float>(std::max(0.0, solver.eigenvalues()[0]));
+        return true;
+    }
+
+    int PlaneExtractor::FindRoot(int block) {
+        while (parents_[block] != block) {
+            parents_[block] = parents_[parents_[block]];
+            block = parents_[block];
+        }
+        return block;
+    }
+
+    void PlaneExtractor::Extract(const OrganizedPointCloud &cloud,
+                                 std::vector <DetectedPlane> &planes) {
+        planes.clear();
+        int columns = cloud.GetWidth() / kBlockSize;
+        int rows = cloud.GetHeight() / kBlockSize;
+        int block_count = columns * rows;
+        blocks_.assign(block_count, Block());
+        parents_.resize(block_count);
+
+        // 1. fit a plane to every block
+        for (int row = 0; row < rows; ++row) {
+            for (int column = 0; column < columns; ++column) {
+                int index = row * columns + column;
+                Block &block = blocks_[index];
+                parents_[index] = index;
+                for (int y = row * kBlockSize; y < (row + 1) * kBlockSize; ++y) {
+                    for (int x = column * kBlockSize; x < (column + 1) * kBlockSize; ++x) {
+                        int cell = y * cloud.GetWidth() + x;
+                        if (cloud.HasPoint(cell)) {
+                            block.moments.Add(cloud.GetPoint(cell));
+                        }
+                    }
+                }
+                block.planar = block.moments.GetCount() >= kMinBlockPoints &&
+                               block.moments.Fit(&block.normal, &block.distance, &block.mse) &&
+                               block.mse < MaxMse(block.moments.GetMean().z);
+            }
+        }
+
+        // 2. merge neighbouring blocks, the best fitting pairs first
+        std::vector <std::pair<float, std::pair<int, int> > > edges;
+        for (int row = 0; row < rows; ++row) {
+            for (int column = 0; column < columns; ++column) {
+                int index = row * columns + column;
+                if (!blocks_[index].planar) {
+                    continue;
+                }
+                int neighbours[2] = {column + 1 < columns ? index + 1 : -1,
+                                     row + 1 < rows ? index + columns : -1};
+                for (int i = 0; i < 2; ++i) {
+                    int other = neighbours[i];
+                    if (other >= 0 && blocks_[other].planar) {
+                        edges.push_back(std::make_pair(blocks_[index].mse + blocks_[other].mse,
+                                                       std::make_pair(index, other)));
+                    }
+                }
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        for (size_t i = 0; i < edges.size(); ++i) {
+            int a = FindRoot(edges[i].second.first);
+            int b = FindRoot(edges[i].second.second);
+            if (a == b) {
+                continue;
+            }
+            Block &first = blocks_[a];
+            Block &second = blocks_[b];
+            if (std::fabs(glm::dot(first.normal, second.normal)) < kMinMergeCosine) {
+                continue;
+            }
+            Block merged = first;
+            merged.moments.Merge(second.moments);
+            if (!merged.moments.Fit(&merged.normal, &merged.distance, &merged.mse) ||
+                merged.mse >= MaxMse(merged.moments.GetMean().z)) {
+                continue;
+            }
+            parents_[b] = a;
+            blocks_[a] = merged;
+        }
+
+        // 3. collect the points of large regions
+        std::vector <int> plane_of_root(block_count, -1);
+        std::vector <int> blocks_of_root(block_count, 0);
+        for (int i = 0; i < block_count; ++i) {
+            if (blocks_[i].planar) {
+                blocks_of_root[FindRoot(i)]++;
+            }
+        }
+        for (int row = 0; row < rows; ++row) {
+            for (int column = 0; column < columns; ++column) {
+                int index = row * columns + column;
+                if (!blocks_[index].planar) {
+                    continue;
+                }
+                int root = FindRoot(index);
+                if (blocks_of_root[root] < kMinPlaneBlocks) {
+                    continue;
+                }
+                if (plane_of_root[root] < 0) {
+                    plane_of_root[root] = planes.size();
+                    DetectedPlane plane;
+                    plane.normal = blocks_[root].normal;
+                    plane.distance = blocks_[root].distance;
+                    // the camera is at the origin, point the normal to it
+                    if (plane.distance > 0.0f) {
+                        plane.normal = -plane.normal;
+                        plane.distance = -plane.distance;
+                    }
+                    planes.push_back(plane);
+                }
+                DetectedPlane &plane = planes[plane_of_root[root]];
+                for (int y = row * kBlockSize; y < (row + 1) * kBlockSize; ++y) {
+                    for (int x = column * kBlockSize; x < (column + 1) * kBlockSize; ++x) {
+                        int cell = y * cloud.GetWidth() + x;
+                        if (cloud.HasPoint(cell)) {
+                            plane.points.push_back(cloud.GetPoint(cell));
+                        }
+                    }
+                }
+            }
+        }
+        std::sort(planes.begin(), planes.end(), [](const DetectedPlane &a, const DetectedPlane &b) {
+            return a.points.size() > b.points.size();
+        });
+    }
+}  // namespace tango_augmented_reality
@@ -0,0 +1,180 @@
+#include "tango-augmented-reality/plane_map.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "tango-augmented-reality/convex_hull.h"
+#include "polygontriangulation.h"
+
+namespace {
+    // planes with normals closer than about 10 degrees can be merged
+    const float kMinMergeCosine = 0.985f;
+    // largest distance of the new points to a matching plane
+    const float kMaxMergeDistance = 0.05f;
+    // largest gap between the hull of a plane and the new points
+    const float kMaxMergeGap = 0.25f;
+
+    // versions are unique over all planes, so a new plane never looks like an
+    // older mesh at the same address
+    int next_mesh_version = 0;
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    GlobalPlane::GlobalPlane(const std::vector <glm::vec3> &points) :
+            mesh_version_(next_mesh_version++) {
+        AddPoints(points);
+    }
+
+    bool GlobalPlane::Matches(const glm::vec3 &normal,
+                              const std::vector <glm::vec3> &points) const {
+        if (std::fabs(glm::dot(normal, plane_.normal)) < kMinMergeCosine || points.empty()) {
+            return false;
+        }
+        glm::vec3 mean;
+        glm::vec2 min(1e9f, 1e9f), max(-1e9f, -1e9f);
+        for (size_t i = 0; i < points.size(); ++i) {
+            mean += points[i];
+            glm::vec2 projected = plane_.project(points[i]);
+            min = glm::min(min, projected);
+            max = glm::max(max, projected);
+        }
+        mean = mean / static_cast<float>(points.size());
+        if (std::fabs(glm::dot(plane_.normal, mean) - plane_.distance) > kMaxMergeDistance) {
+            return false;
+        }
+        // compare the bounding boxes in the plane
+        glm::vec2 hull_min(1e9f, 1e9f), hull_max(-1e9f, -1e9f);
+        for (size_t i = 0; i < hull_.size(); ++i) {
+            glm::vec2 projected = plane_.project(hull_[i]);
+            hull_min = glm::min(hull_min, projected);
+            hull_max = glm::max(hull_max, projected);
+        }
+        return min.x <= hull_max.x + kMaxMergeGap && max.x >= hull_min.x - kMaxMergeGap &&
+               min.y <= hull_max.y + kMaxMergeGap && max.y >= hull_min.y - kMaxMergeGap;
+    }
+
+    void GlobalPlane::AddPoints(const std::vector <glm::vec3> &points) {
+        for (size_t i = 0; i < points.size(); ++i) {
+            moments_.Add(points[i]);
+        }
+        Update(points);
+    }
+
+    void GlobalPlane::Merge(const GlobalPlane &other) {
+        moments_.Merge(other.moments_);
+        Update(other.hull_);
+    }
+
+    void GlobalPlane::Update(const std::vector <glm::vec3> &points) {
+        glm::vec3 normal;
+        float distance, mse;
+        if (!moments_.Fit(&normal, &distance, &mse)) {
+            return;
+        }
+        // keep the side the plane was seen from
+        if (!hull_.empty() && glm::dot(normal, plane_.normal) < 0.0f) {
+            normal = -normal;
+            distance = -distance;
+        }
+        plane_ = Plane(normal, distance);
+
+        std::vector <glm::vec2> projection;
+        projection.reserve(hull_.size() + points.size());
+        for (size_t i = 0; i < hull_.size(); ++i) {
+            projection.push_back(plane_.project(hull_[i]));
+        }
+        for (size_t i = 0; i < points.size(); ++i) {
+            projection.push_back(plane_.project(points[i]));
+        }
+        ConvexHull convex_hull;
+        std::vector <glm::vec2> hull = convex_hull.generateConvexHull(projection);
+        if (!hull.empty()) {
+            hull.pop_back();    // remove last point which is available twice
+        }
+
+        hull_.clear();
+        for (size_t i = 0; i < hull.size(); ++i) {
+            hull_.push_back(plane_.unproject(hull[i]));
+        }
+        // delaunay triangles of the hull in plane coordinates
+        constructnative::Polygon2D polygon;
+        polygon.ringSizes.push_back(hull.size());
+        for (size_t i = 0; i < hull.size(); ++i) {
+            polygon.points.push_back(hull[i].x);
+            polygon.points.push_back(hull[i].y);
+        }
+        std::vector<int> triangles;
+        constructnative::triangulatePolygon(polygon, triangles);
+        mesh_.clear();
+        for (size_t i = 0; i < triangles.size(); ++i) {
+            mesh_.push_back(hull_[triangles[i]]);
+        }
+        mesh_version_ = next_mesh_version++;
+    }
+
+    PlaneMap::~PlaneMap() {
+        Clear();
+    }
+
+    void PlaneMap::AddPlanes(const glm::mat4 &transformation,
+                             const std::vector <DetectedPlane> &planes) {
+        std::vector <glm::vec3> points;
+        for (size_t p = 0; p < planes.size(); ++p) {
+            points.clear();
+            PlaneMoments moments;
+            for (size_t i = 0; i < planes[p].points.size(); ++i) {
+                glm::vec4 point = glm::vec4(planes[p].points[i], 1) * transformation;
+                points.push_back(glm::vec3(point.x, point.y, point.z));
+                moments.Add(points.back());
+            }
+            glm::vec3 normal;
+            float distance, mse;
+            if (moments.Fit(&normal, &distance, &mse)) {
+                AddPlane(normal, points);
+            }
+        }
+    }
+
+    GlobalPlane *PlaneMap::AddPlane(const glm::vec3 &normal, const std::vector <glm::vec3> &points,
+                                    std::vector <GlobalPlane *> *merged) {
+        // the first matching plane takes the points and all other matches
+        GlobalPlane *target = nullptr;
+        for (std::vector<GlobalPlane *>::iterator it = planes_.begin(); it != planes_.end();) {
+            if (!(*it)->Matches(normal, points)) {
+                ++it;
+            } else if (target == nullptr) {
+                target = *it;
+                target->AddPoints(points);
+                ++it;
+            } else {
+                target->Merge(**it);
+                if (merged != nullptr) {
+                    merged->push_back(*it);
+                }
+                delete *it;
+                it = planes_.erase(it);
+            }
+        }
+        if (target == nullptr) {
+            target = new GlobalPlane(points);
+            planes_.push_back(target);
+        }
+        return target;
+    }
+
+    void PlaneMap::RemovePlane(GlobalPlane *plane) {
+        std::vector<GlobalPlane *>::iterator it = std::find(planes_.begin(), planes_.end(), plane);
+        if (it != planes_.end()) {
+            delete *it;
+            planes_.erase(it);
+        }
+    }
+
+    void PlaneMap::Clear() {
+        for (size_t i = 0; i < planes_.size(); ++i) {
+            delete planes_[i];
+        }
+        planes_.clear();
+    }
+}  // namespace tango_augmented_reality
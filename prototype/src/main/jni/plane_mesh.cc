@@ -16,12 +16,27 @@
 
 #include "tango-augmented-reality/plane_mesh.h"
 #include <tango-gl/shaders.h>
+#include <algorithm>
+#include <limits>
+
+#include "tango-augmented-reality/shader_cache.h"
+
+namespace {
+    const GLsizei kInitialArenaVertices = 64 * 1024;
+}  // namespace
 
 namespace tango_augmented_reality {
 
-    PlaneMesh::PlaneMesh() {
+    PlaneMesh::PlaneMesh() : quantizer_(glm::vec3(0, 0, 0), kReconstructionHalfRange) {
         render_mode_ = GL_TRIANGLES;
         SetShader();
+        vertex_format_ = VERTEX_FORMAT_FLOAT;
+        pending_vertex_format_ = VERTEX_FORMAT_FLOAT;
+        arena_ = new GpuBufferArena(vertex_format_, kInitialArenaVertices);
+        plane_detection_ = PLANE_DETECTION_OCTREE;
+        merge_leaf_planes_ = true;
+        ransac_iteration_limit_ = std::numeric_limits<int>::max();
+        config_changed_ = false;
 
         tree = new ReconstructionOcTree(glm::vec3(-20, -20, -20), 40, 7);
     }
@@ -34,32 +49,220 @@ namespace tango_augmented_reality {
             tree->addPoint(glm::vec3(point.x, point.y, point.z));
         }
         LOGE("got %d points into %d clusters", tree->getSize(), tree->getClusterCount());
+        ApplyReconstructorConfig();
         tree->reconstruct();
     }
 
+    void PlaneMesh::addPoints(glm::mat4 transformation, OrganizedPointCloud &cloud,
+                              int smooth_radius) {
+        if (plane_detection_ == PLANE_DETECTION_REGION_GROWING) {
+            std::vector <DetectedPlane> planes;
+            extractor_.Extract(cloud, planes);
+            plane_map_.AddPlanes(transformation, planes);
+            LOGE("got %d frame planes into %d planes", planes.size(), plane_map_.GetPlaneCount());
+            return;
+        }
+        cloud.ComputeSmoothMask(smooth_radius);
+        frame_vertices_.clear();
+        int size = cloud.GetWidth() * cloud.GetHeight();
+        for (int i = 0; i < size; ++i) {
+            if (cloud.IsSmooth(i)) {
+                const glm::vec3 &point = cloud.GetPoint(i);
+                frame_vertices_.push_back(point.x);
+                frame_vertices_.push_back(point.y);
+                frame_vertices_.push_back(point.z);
+            }
+        }
+        addPoints(transformation, frame_vertices_);
+    }
+
     void PlaneMesh::updateVertices() {
-        std::vector <GLfloat> mesh;
-        std::vector <glm::vec3> reconstruction = tree->getMesh();
-        for (int i = 0; i < reconstruction.size(); ++i) {
-            mesh.push_back(reconstruction[i].x);
-            mesh.push_back(reconstruction[i].y);
-            mesh.push_back(reconstruction[i].z);
+        std::vector <Reconstructor *> reconstructors;
+        tree->getReconstructors(reconstructors);
+        std::vector <GlobalPlane *> planes;
+        plane_map_.GetPlanes(planes);
+
+        std::lock_guard <std::mutex> lock(render_mutex);
+        if (pending_vertex_format_ != vertex_format_) {
+            // a new arena in the requested format, every cluster is uploaded again
+            delete arena_;
+            vertex_format_ = pending_vertex_format_;
+            arena_ = new GpuBufferArena(vertex_format_, kInitialArenaVertices);
+            pieces_.clear();
+        }
+        std::vector <GLshort> quantized;
+        std::unordered_set<const void *> live;
+        for (Reconstructor *reconstructor : reconstructors) {
+            reconstructor->clearPoints();
+        }
+        if (merge_leaf_planes_) {
+            // one mesh per surface instead of the hulls of every cluster
+            MergeLeafPlanes(reconstructors);
+            std::vector <GlobalPlane *> leaf_planes;
+            leaf_planes_.GetPlanes(leaf_planes);
+            planes.insert(planes.end(), leaf_planes.begin(), leaf_planes.end());
+        } else {
+            // only clusters and planes with a new mesh are uploaded
+            for (Reconstructor *reconstructor : reconstructors) {
+                live.insert(reconstructor);
+                int version = reconstructor->getMeshVersion();
+                if (!IsUploaded(reconstructor, version)) {
+                    UploadPiece(reconstructor, version, reconstructor->getMesh(), quantized);
+                }
+            }
+        }
+        for (GlobalPlane *plane : planes) {
+            live.insert(plane);
+            int version = plane->getMeshVersion();
+            if (!IsUploaded(plane, version)) {
+                UploadPiece(plane, version, plane->getMesh(), quantized);
+            }
+        }
+        // planes merged into others are gone
+        for (std::unordered_map<const void *, Piece>::iterator piece = pieces_.begin();
+             piece != pieces_.end();) {
+            if (live.count(piece->first) == 0) {
+                arena_->Free(piece->second.handle);
+                piece = pieces_.erase(piece);
+            } else {
+                ++piece;
+            }
         }
-        LOGI("Got %d polygons", mesh.size() / 9);
-        if (mesh.size() >= 0) {
-            std::lock_guard <std::mutex> lock(render_mutex);
-            SetVertices(mesh);
+        LOGI("Got %d polygons", arena_->GetVertexCount() / 3);
+    }
+
+    void PlaneMesh::MergeLeafPlanes(const std::vector <Reconstructor *> &reconstructors) {
+        // clusters with a new mesh and clusters which are gone
+        std::unordered_set<const Reconstructor *> changed;
+        std::unordered_map<const Reconstructor *, int> versions;
+        for (Reconstructor *reconstructor : reconstructors) {
+            int version = reconstructor->getMeshVersion();
+            versions[reconstructor] = version;
+            std::unordered_map<const Reconstructor *, int>::const_iterator known =
+                    leaf_versions_.find(reconstructor);
+            if (known == leaf_versions_.end() || known->second != version) {
+                changed.insert(reconstructor);
+            }
+        }
+        for (const std::pair<const Reconstructor *const, int> &known : leaf_versions_) {
+            if (versions.count(known.first) == 0) {
+                changed.insert(known.first);
+            }
+        }
+        if (changed.empty()) {
+            return;
+        }
+        leaf_versions_.swap(versions);
+
+        // surfaces holding a plane of a changed cluster are built again, all other
+        // surfaces keep their mesh and stay uploaded
+        std::vector <LeafPlane> kept;
+        for (std::unordered_map<GlobalPlane *, std::vector <LeafPlane> >::iterator surface =
+                leaf_plane_sources_.begin(); surface != leaf_plane_sources_.end();) {
+            bool affected = false;
+            for (const LeafPlane &source : surface->second) {
+                affected = affected || changed.count(source.leaf) > 0;
+            }
+            if (!affected) {
+                ++surface;
+                continue;
+            }
+            // planes of unchanged clusters are still valid, they are merged again
+            for (const LeafPlane &source : surface->second) {
+                if (changed.count(source.leaf) == 0) {
+                    kept.push_back(source);
+                }
+            }
+            leaf_planes_.RemovePlane(surface->first);
+            surface = leaf_plane_sources_.erase(surface);
+        }
+        for (const LeafPlane &source : kept) {
+            AddLeafPlane(source.leaf, source.plane);
         }
+
+        std::vector <const Plane *> planes;
+        for (Reconstructor *reconstructor : reconstructors) {
+            if (changed.count(reconstructor) == 0) {
+                continue;
+            }
+            planes.clear();
+            reconstructor->getPlanes(planes);
+            for (const Plane *plane : planes) {
+                if (plane->points.size() >= 3) {
+                    AddLeafPlane(reconstructor, plane);
+                }
+            }
+        }
+        LOGI("Merged planes of %d changed clusters into %d surfaces",
+             static_cast<int>(changed.size()), leaf_planes_.GetPlaneCount());
+    }
+
+    void PlaneMesh::AddLeafPlane(const Reconstructor *leaf, const Plane *plane) {
+        std::vector <GlobalPlane *> merged;
+        GlobalPlane *surface = leaf_planes_.AddPlane(plane->normal, plane->points, &merged);
+        std::vector <LeafPlane> &sources = leaf_plane_sources_[surface];
+        // surfaces merged into this one are deleted, their planes belong to it now
+        for (GlobalPlane *other : merged) {
+            std::unordered_map<GlobalPlane *, std::vector <LeafPlane> >::iterator other_sources =
+                    leaf_plane_sources_.find(other);
+            if (other_sources != leaf_plane_sources_.end()) {
+                sources.insert(sources.end(), other_sources->second.begin(),
+                               other_sources->second.end());
+                leaf_plane_sources_.erase(other_sources);
+            }
+        }
+        LeafPlane source = {leaf, plane};
+        sources.push_back(source);
     }
 
-    PlaneMesh::PlaneMesh(GLenum render_mode) {
+    bool PlaneMesh::IsUploaded(const void *key, int version) const {
+        std::unordered_map<const void *, Piece>::const_iterator piece = pieces_.find(key);
+        return piece != pieces_.end() && piece->second.version == version;
+    }
+
+    void PlaneMesh::UploadPiece(const void *key, int version,
+                                const std::vector <glm::vec3> &reconstruction,
+                                std::vector <GLshort> &quantized) {
+        std::unordered_map<const void *, Piece>::iterator piece = pieces_.find(key);
+        GLsizei count = reconstruction.size();
+        const GLfloat *positions = count > 0 ? &reconstruction[0].x : nullptr;
+        const void *data = quantizer_.Encode(vertex_format_, positions, count, quantized);
+        if (piece == pieces_.end()) {
+            if (count > 0) {
+                Piece new_piece;
+                new_piece.handle = arena_->Allocate(data, count);
+                new_piece.version = version;
+                pieces_[key] = new_piece;
+            }
+        } else if (count == 0) {
+            arena_->Free(piece->second.handle);
+            pieces_.erase(piece);
+        } else {
+            arena_->Update(piece->second.handle, data, count);
+            piece->second.version = version;
+        }
+    }
+
+    PlaneMesh::PlaneMesh(GLenum render_mode) :
+            quantizer_(glm::vec3(0, 0, 0), kReconstructionHalfRange) {
         render_mode_ = render_mode;
+        plane_detection_ = PLANE_DETECTION_OCTREE;
+        merge_leaf_planes_ = true;
+        ransac_iteration_limit_ = std::numeric_limits<int>::max();
+        config_changed_ = false;
+        vertex_format_ = VERTEX_FORMAT_FLOAT;
+        pending_vertex_format_ = VERTEX_FORMAT_FLOAT;
+        arena_ = new GpuBufferArena(vertex_format_, kInitialArenaVertices);
+    }
+
+    PlaneMesh::~PlaneMesh() {
+        delete arena_;
     }
 
     void PlaneMesh::SetShader() {
-        shader_program_ = tango_gl::util::CreateProgram(
-                tango_gl::shaders::GetBasicVertexShader().c_str(),
-                tango_gl::shaders::GetBasicFragmentShader().c_str());
+        // the basic program is shared by all reconstruction meshes
+        shader_program_ = ShaderCache::GetProgram(tango_gl::shaders::GetBasicVertexShader(),
+                                                  tango_gl::shaders::GetBasicFragmentShader());
         if (!shader_program_) {
             LOGE("Could not create program.");
         }
@@ -73,9 +276,54 @@ namespace tango_augmented_reality {
 
     void PlaneMesh::clear() {
         std::lock_guard <std::mutex> lock(render_mutex);
-        std::vector <GLfloat> mesh;
-        SetVertices(mesh);
+        arena_->Clear();
+        pieces_.clear();
         tree->clear();
+        plane_map_.Clear();
+        leaf_planes_.Clear();
+        leaf_versions_.clear();
+        leaf_plane_sources_.clear();
+    }
+
+    void PlaneMesh::setMergeLeafPlanes(bool merge) {
+        merge_leaf_planes_ = merge;
+    }
+
+    void PlaneMesh::setPlaneDetection(PlaneDetection detection) {
+        plane_detection_ = detection;
+    }
+
+    void PlaneMesh::setRansacIterationLimit(int limit) {
+        std::lock_guard <std::mutex> lock(config_mutex_);
+        config_changed_ = config_changed_ || limit != ransac_iteration_limit_;
+        ransac_iteration_limit_ = limit;
+    }
+
+    void PlaneMesh::setReconstructorConfig(const ReconstructorConfig &config) {
+        std::lock_guard <std::mutex> lock(config_mutex_);
+        reconstructor_config_ = config;
+        config_changed_ = true;
+    }
+
+    void PlaneMesh::ApplyReconstructorConfig() {
+        ReconstructorConfig config;
+        {
+            std::lock_guard <std::mutex> lock(config_mutex_);
+            if (!config_changed_) {
+                return;
+            }
+            config = reconstructor_config_;
+            config.ransac_iterations = std::min(config.ransac_iterations, ransac_iteration_limit_);
+            config_changed_ = false;
+        }
+        // setConfig moves points between planes and clusters, so it runs on the
+        // thread which adds points and reconstructs
+        tree->setConfig(config);
+    }
+
+    void PlaneMesh::setVertexFormat(VertexFormat format) {
+        std::lock_guard <std::mutex> lock(render_mutex);
+        pending_vertex_format_ = format;
     }
 
     void PlaneMesh::Render(const glm::mat4 &projection_mat,
@@ -83,24 +331,12 @@ namespace tango_augmented_reality {
         glUseProgram(shader_program_);
         glm::mat4 model_mat = GetTransformationMatrix();
         glm::mat4 mv_mat = view_mat * model_mat;
-        glm::mat4 mvp_mat = projection_mat * mv_mat;
+        // positions in a compressed format are decoded by the mvp matrix
+        glm::mat4 mvp_mat = projection_mat * mv_mat * quantizer_.GetDecodeMatrix(vertex_format_);
         glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
         glUniform4f(uniform_color_, red_, green_, blue_, alpha_);
 
-        glEnableVertexAttribArray(attrib_vertices_);
-
-        if (!indices_.empty()) {
-            glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
-                                  3 * sizeof(GLfloat), vertices_.data());
-            glDrawElements(render_mode_, indices_.size(), GL_UNSIGNED_SHORT,
-                           indices_.data());
-        } else {
-            glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
-                                  3 * sizeof(GLfloat), &vertices_[0]);
-            glDrawArrays(render_mode_, 0, vertices_.size() / 3);
-        }
-
-        glDisableVertexAttribArray(attrib_vertices_);
+        arena_->Draw(render_mode_, attrib_vertices_);
         glUseProgram(0);
     }
 }  // namespace tango_augmented_reality
@@ -0,0 +1,483 @@
+#include "tango-augmented-reality/ply_loader.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace {
+    const uint32_t kCacheMagic = 0x424d5241;  // "ARMB"
+    const uint32_t kCacheVersion = 1;
+
+    // header of the preprocessed mesh file
+    struct CacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        // size and modification time of the PLY file the cache was built from
+        int64_t source_size;
+        int64_t source_mtime;
+        // vertex count of the triangle soup
+        uint64_t vertex_count;
+    };
+
+    enum PlyType {
+        PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16, PLY_INT32, PLY_UINT32,
+        PLY_FLOAT32, PLY_FLOAT64, PLY_INVALID
+    };
+
+    struct PlyProperty {
+        std::string name;
+        PlyType type;
+        bool is_list;
+        PlyType count_type;
+    };
+
+    struct PlyElement {
+        std::string name;
+        size_t count;
+        std::vector <PlyProperty> properties;
+    };
+
+    long long currentTimeInMilliseconds() {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        return ((tv.tv_sec * 1000) + (tv.tv_usec / 1000));
+    }
+
+    // read only memory mapping of a whole file
+    class MappedFile {
+    public:
+        MappedFile(const std::string &path) {
+            fd_ = open(path.c_str(), O_RDONLY);
+            if (fd_ < 0) {
+                return;
+            }
+            struct stat info;
+            if (fstat(fd_, &info) != 0 || info.st_size == 0) {
+                return;
+            }
+            size_ = info.st_size;
+            mtime_ = info.st_mtime;
+            void *data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+            if (data == MAP_FAILED) {
+                return;
+            }
+            data_ = static_cast<const char *>(data);
+            madvise(data, size_, MADV_SEQUENTIAL);
+        }
+
+        ~MappedFile() {
+            if (data_) {
+                munmap(const_cast<char *>(data_), size_);
+            }
+            if (fd_ >= 0) {
+                close(fd_);
+            }
+        }
+
+        const char *data() const { return data_; }
+
+        size_t size() const { return size_; }
+
+        int64_t mtime() const { return mtime_; }
+
+    private:
+        int fd_ = -1;
+        const char *data_ = nullptr;
+        size_t size_ = 0;
+        int64_t mtime_ = 0;
+    };
+
+    PlyType parseType(const std::string &name) {
+        if (name == "char" || name == "int8") return PLY_INT8;
+        if (name == "uchar" || name == "uint8") return PLY_UINT8;
+        if (name == "short" || name == "int16") return PLY_INT16;
+        if (name == "ushort" || name == "uint16") return PLY_UINT16;
+        if (name == "int" || name == "int32") return PLY_INT32;
+        if (name == "uint" || name == "uint32") return PLY_UINT32;
+        if (name == "float" || name == "float32") return PLY_FLOAT32;
+        if (name == "double" || name == "float64") return PLY_FLOAT64;
+        return PLY_INVALID;
+    }
+
+    size_t typeSize(PlyType type) {
+        switch (type) {
+            case PLY_INT8:
+            case PLY_UINT8:
+                return 1;
+            case PLY_INT16:
+            case PLY_UINT16:
+                return 2;
+            case PLY_INT32:
+            case PLY_UINT32:
+            case PLY_FLOAT32:
+                return 4;
+            case PLY_FLOAT64:
+                return 8;
+            default:
+                return 0;
+        }
+    }
+
+    // cursor over the mapped body, every read checks the end of the file
+    class BodyReader {
+    public:
+        BodyReader(const char *begin, const char *end, bool binary) :
+                p_(begin), end_(end), binary_(binary) { }
+
+        bool failed() const { return failed_; }
+
+        double read(PlyType type) {
+            return binary_ ? readBinary(type) : readAscii();
+        }
+
+    private:
+        template<typename T>
+        double readValue() {
+            if (end_ - p_ < static_cast<ptrdiff_t>(sizeof(T))) {
+                failed_ = true;
+                return 0.0;
+            }
+            // PLY little endian matches the ARM byte order
+            T value;
+            memcpy(&value, p_, sizeof(T));
+            p_ += sizeof(T);
+            return static_cast<double>(value);
+        }
+
+        double readBinary(PlyType type) {
+            switch (type) {
+                case PLY_INT8:
+                    return readValue<int8_t>();
+                case PLY_UINT8:
+                    return readValue<uint8_t>();
+                case PLY_INT16:
+                    return readValue<int16_t>();
+                case PLY_UINT16:
+                    return readValue<uint16_t>();
+                case PLY_INT32:
+                    return readValue<int32_t>();
+                case PLY_UINT32:
+                    return readValue<uint32_t>();
+                case PLY_FLOAT32:
+                    return readValue<float>();
+                case PLY_FLOAT64:
+                    return readValue<double>();
+                default:
+                    failed_ = true;
+                    return 0.0;
+            }
+        }
+
+        // parses a decimal number without locale lookups or copies, much faster
+        // than sscanf for the millions of values of a large model
+        double readAscii() {
+            static const double kPowers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+                                             1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16};
+            while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r' || *p_ == '\n')) {
+                ++p_;
+            }
+            if (p_ == end_) {
+                failed_ = true;
+                return 0.0;
+            }
+            bool negative = false;
+            if (*p_ == '-' || *p_ == '+') {
+                negative = *p_ == '-';
+                ++p_;
+            }
+            const char *digits_begin = p_;
+            double value = 0.0;
+            while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+                value = value * 10.0 + (*p_ - '0');
+                ++p_;
+            }
+            int exponent = 0;
+            if (p_ < end_ && *p_ == '.') {
+                ++p_;
+                while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+                    value = value * 10.0 + (*p_ - '0');
+                    --exponent;
+                    ++p_;
+                }
+            }
+            if (p_ == digits_begin) {
+                failed_ = true;
+                return 0.0;
+            }
+            if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+                ++p_;
+                bool negative_exponent = false;
+                if (p_ < end_ && (*p_ == '-' || *p_ == '+')) {
+                    negative_exponent = *p_ == '-';
+                    ++p_;
+                }
+                int e = 0;
+                while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+                    e = e * 10 + (*p_ - '0');
+                    ++p_;
+                }
+                exponent += negative_exponent ? -e : e;
+            }
+            if (exponent != 0) {
+                int magnitude = exponent < 0 ? -exponent : exponent;
+                double scale = magnitude <= 16 ? kPowers[magnitude] : std::pow(10.0, magnitude);
+                value = exponent < 0 ? value / scale : value * scale;
+            }
+            return negative ? -value : value;
+        }
+
+        const char *p_;
+        const char *end_;
+        bool binary_;
+        bool failed_ = false;
+    };
+
+    // parses the header, body points behind end_header afterwards
+    bool parseHeader(const char *data, size_t size, std::vector <PlyElement> &elements,
+                     bool &binary, const char *&body) {
+        const char *end = data + size;
+        const char *line = data;
+        bool has_format = false;
+        while (line < end) {
+            const char *line_end = static_cast<const char *>(memchr(line, '\n', end - line));
+            if (!line_end) {
+                return false;
+            }
+            std::string text(line, line_end);
+            if (!text.empty() && text[text.size() - 1] == '\r') {
+                text.erase(text.size() - 1);
+            }
+            line = line_end + 1;
+
+            char word[64];
+            char first[64];
+            char second[64];
+            char third[64];
+            if (text == "end_header") {
+                body = line;
+                return has_format;
+            } else if (sscanf(text.c_str(), "format %63s", word) == 1) {
+                if (strcmp(word, "ascii") == 0) {
+                    binary = false;
+                } else if (strcmp(word, "binary_little_endian") == 0) {
+                    binary = true;
+                } else {
+                    LOGE("PLY format %s is not supported", word);
+                    return false;
+                }
+                has_format = true;
+            } else if (sscanf(text.c_str(), "element %63s", word) == 1) {
+                PlyElement element;
+                element.name = word;
+                unsigned long count = 0;
+                sscanf(text.c_str(), "element %*s %lu", &count);
+                element.count = count;
+                elements.push_back(element);
+            } else if (sscanf(text.c_str(), "property list %63s %63s %63s", first, second,
+                              third) == 3) {
+                if (elements.empty()) {
+                    return false;
+                }
+                PlyProperty property;
+                property.name = third;
+                property.is_list = true;
+                property.count_type = parseType(first);
+                property.type = parseType(second);
+                if (property.count_type == PLY_INVALID || property.type == PLY_INVALID) {
+                    return false;
+                }
+                elements.back().properties.push_back(property);
+            } else if (sscanf(text.c_str(), "property %63s %63s", first, second) == 2) {
+                if (elements.empty()) {
+                    return false;
+                }
+                PlyProperty property;
+                property.name = second;
+                property.is_list = false;
+                property.type = parseType(first);
+                property.count_type = PLY_INVALID;
+                if (property.type == PLY_INVALID) {
+                    return false;
+                }
+                elements.back().properties.push_back(property);
+            }
+        }
+        return false;
+    }
+
+    bool parsePly(const MappedFile &file, tango_augmented_reality::PlyMesh &mesh) {
+        std::vector <PlyElement> elements;
+        bool binary = false;
+        const char *body = nullptr;
+        if (!parseHeader(file.data(), file.size(), elements, binary, body)) {
+            LOGE("Could not parse PLY header");
+            return false;
+        }
+        BodyReader reader(body, file.data() + file.size(), binary);
+
+        std::vector <GLfloat> positions;
+        std::vector <uint32_t> polygon;
+        for (size_t e = 0; e < elements.size(); ++e) {
+            const PlyElement &element = elements[e];
+            bool is_vertex = element.name == "vertex";
+            bool is_face = element.name == "face";
+            if (is_vertex) {
+                positions.reserve(element.count * 3);
+            } else if (is_face) {
+                // most models are triangles already
+                mesh.vertices.reserve(element.count * 9);
+                mesh.normals.reserve(element.count * 9);
+            }
+            for (size_t i = 0; i < element.count; ++i) {
+                float position[3] = {0.0f, 0.0f, 0.0f};
+                for (size_t k = 0; k < element.properties.size(); ++k) {
+                    const PlyProperty &property = element.properties[k];
+                    if (property.is_list) {
+                        size_t count = static_cast<size_t>(reader.read(property.count_type));
+                        bool indices = is_face && (property.name == "vertex_indices" ||
+                                                   property.name == "vertex_index");
+                        if (indices) {
+                            polygon.clear();
+                        }
+                        for (size_t j = 0; j < count && !reader.failed(); ++j) {
+                            double value = reader.read(property.type);
+                            if (indices) {
+                                polygon.push_back(static_cast<uint32_t>(value));
+                            }
+                        }
+                        if (indices) {
+                            // fan the polygon into triangles with flat normals
+                            for (size_t j = 2; j < polygon.size(); ++j) {
+                                uint32_t corners[3] = {polygon[0], polygon[j - 1], polygon[j]};
+                                glm::vec3 points[3];
+                                for (int c = 0; c < 3; ++c) {
+                                    if (corners[c] * 3 + 2 >= positions.size()) {
+                                        LOGE("PLY face index %u out of range", corners[c]);
+                                        return false;
+                                    }
+                                    points[c] = glm::vec3(positions[corners[c] * 3],
+                                                          positions[corners[c] * 3 + 1],
+                                                          positions[corners[c] * 3 + 2]);
+                                }
+                                glm::vec3 normal = glm::cross(points[1] - points[0],
+                                                              points[2] - points[0]);
+                                float length = glm::length(normal);
+                                normal = length > 0.0f ? normal / length : glm::vec3(0, 0, 1);
+                                for (int c = 0; c < 3; ++c) {
+                                    mesh.vertices.push_back(points[c].x);
+                                    mesh.vertices.push_back(points[c].y);
+                                    mesh.vertices.push_back(points[c].z);
+                                    mesh.normals.push_back(normal.x);
+                                    mesh.normals.push_back(normal.y);
+                                    mesh.normals.push_back(normal.z);
+                                }
+                            }
+                        }
+                    } else {
+                        double value = reader.read(property.type);
+                        if (is_vertex) {
+                            if (property.name == "x") {
+                                position[0] = static_cast<float>(value);
+                            } else if (property.name == "y") {
+                                position[1] = static_cast<float>(value);
+                            } else if (property.name == "z") {
+                                position[2] = static_cast<float>(value);
+                            }
+                        }
+                    }
+                }
+                if (reader.failed()) {
+                    LOGE("PLY body ends early in element %s", element.name.c_str());
+                    return false;
+                }
+                if (is_vertex) {
+                    positions.insert(positions.end(), position, position + 3);
+                }
+            }
+        }
+        return !mesh.vertices.empty();
+    }
+
+    bool loadCache(const std::string &path, const MappedFile &source,
+                   tango_augmented_reality::PlyMesh &mesh) {
+        MappedFile cache(path);
+        if (!cache.data() || cache.size() < sizeof(CacheHeader)) {
+            return false;
+        }
+        CacheHeader header;
+        memcpy(&header, cache.data(), sizeof(header));
+        size_t floats = header.vertex_count * 3;
+        if (header.magic != kCacheMagic || header.version != kCacheVersion ||
+            header.source_size != static_cast<int64_t>(source.size()) ||
+            header.source_mtime != source.mtime() ||
+            cache.size() != sizeof(header) + 2 * floats * sizeof(GLfloat)) {
+            return false;
+        }
+        const GLfloat *data = reinterpret_cast<const GLfloat *>(cache.data() + sizeof(header));
+        mesh.vertices.assign(data, data + floats);
+        mesh.normals.assign(data + floats, data + 2 * floats);
+        return true;
+    }
+
+    void storeCache(const std::string &path, const MappedFile &source,
+                    const tango_augmented_reality::PlyMesh &mesh) {
+        CacheHeader header;
+        header.magic = kCacheMagic;
+        header.version = kCacheVersion;
+        header.source_size = source.size();
+        header.source_mtime = source.mtime();
+        header.vertex_count = mesh.vertices.size() / 3;
+
+        // a half written cache never gets picked up because of the rename
+        std::string temp_path = path + ".tmp";
+        FILE *output = fopen(temp_path.c_str(), "wb");
+        if (!output) {
+            return;
+        }
+        bool written = fwrite(&header, sizeof(header), 1, output) == 1 &&
+                       fwrite(mesh.vertices.data(), sizeof(GLfloat), mesh.vertices.size(),
+                              output) == mesh.vertices.size() &&
+                       fwrite(mesh.normals.data(), sizeof(GLfloat), mesh.normals.size(),
+                              output) == mesh.normals.size();
+        if (fclose(output) == 0 && written) {
+            rename(temp_path.c_str(), path.c_str());
+        } else {
+            unlink(temp_path.c_str());
+        }
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    bool LoadPly(const std::string &path, PlyMesh &mesh) {
+        long long before = currentTimeInMilliseconds();
+        MappedFile file(path);
+        if (!file.data()) {
+            return false;
+        }
+
+        std::string cache_path = path + ".cache";
+        if (loadCache(cache_path, file, mesh)) {
+            LOGI("Loaded %s from cache in %lld ms", path.c_str(),
+                 currentTimeInMilliseconds() - before);
+            return true;
+        }
+
+        if (!parsePly(file, mesh)) {
+            mesh.vertices.clear();
+            mesh.normals.clear();
+            return false;
+        }
+        LOGI("Parsed %s with %d triangles in %lld ms", path.c_str(),
+             static_cast<int>(mesh.vertices.size() / 9), currentTimeInMilliseconds() - before);
+        storeCache(cache_path, file, mesh);
+        return true;
+    }
+
+}  // namespace tango_augmented_reality
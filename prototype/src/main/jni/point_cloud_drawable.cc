@@ -17,6 +17,7 @@
 #include <sstream>
 
 #include "tango-augmented-reality/point_cloud_drawable.h"
+#include "tango-augmented-reality/shader_cache.h"
 
 namespace {
     const std::string kPointCloudVertexShader =
@@ -25,12 +26,15 @@ namespace {
                     "attribute vec4 vertex;\n"
                     "uniform bool visible;\n"
                     "uniform mat4 mvp;\n"
+                    "uniform highp vec3 decode_scale;\n"
+                    "uniform highp vec3 decode_offset;\n"
                     "varying vec4 v_color;\n"
                     "void main() {\n"
-                    "  gl_Position = mvp*vertex;\n"
+                    "  highp vec4 position = vec4(vertex.xyz * decode_scale + decode_offset, 1.0);\n"
+                    "  gl_Position = mvp*position;\n"
                     "  v_color = vec4(0.0,0.0,0.0,0.0);\n"
-//                    "if(visible){ v_color = vec4(vertex.z / 4.5,vertex.z / 4.5,vertex.z / 4.5,1.0);}\n" // grayscale
-                    "if(visible){v_color = vertex;}\n" // colored
+//                    "if(visible){ v_color = vec4(position.z / 4.5,position.z / 4.5,position.z / 4.5,1.0);}\n" // grayscale
+                    "if(visible){v_color = position;}\n" // colored
                     " gl_PointSize = 7.0;\n"
                     "}\n";
     const std::string kPointCloudFragmentShader =
@@ -41,59 +45,84 @@ namespace {
                     "  gl_FragColor = vec4(v_color);\n"
                     "}\n";
 
+    // initial size of the streaming buffer, enough for a few depth frames
+    const GLsizeiptr kInitialBufferSize = sizeof(GLfloat) * 3 * 20000 * 4;
+
+    // half edge of the cube around the depth camera the points are quantized in
+    const float kPointHalfRange = 8.0f;
+
 }  // namespace
 
 namespace tango_augmented_reality {
 
-    PointCloudDrawable::PointCloudDrawable() {
-        shader_program_ = tango_gl::util::CreateProgram(
-                kPointCloudVertexShader.c_str(), kPointCloudFragmentShader.c_str());
+    PointCloudDrawable::PointCloudDrawable() :
+            quantizer_(glm::vec3(0, 0, 0), kPointHalfRange) {
+        shader_program_ = ShaderCache::GetProgram(kPointCloudVertexShader,
+                                                  kPointCloudFragmentShader);
 
         mvp_handle_ = glGetUniformLocation(shader_program_, "mvp");
         vertices_visible_handle_ = glGetUniformLocation(shader_program_, "visible");
+        decode_scale_handle_ = glGetUniformLocation(shader_program_, "decode_scale");
+        decode_offset_handle_ = glGetUniformLocation(shader_program_, "decode_offset");
 
         vertices_handle_ = glGetAttribLocation(shader_program_, "vertex");
-        glGenBuffers(1, &vertex_buffers_);
+        vertex_buffer_ = new StreamingVertexBuffer(kInitialBufferSize);
     }
 
     void PointCloudDrawable::DeleteGlResources() {
-        if (vertex_buffers_) {
-            glDeleteBuffers(1, &vertex_buffers_);
-        }
-        if (shader_program_) {
-            glDeleteShader(shader_program_);
+        if (vertex_buffer_) {
+            delete vertex_buffer_;
+            vertex_buffer_ = nullptr;
         }
+        // the program belongs to the shader cache
+        shader_program_ = 0;
+    }
+
+    void PointCloudDrawable::UpdateVertices(const std::vector <float> &vertices) {
+        format_ = pending_format_;
+        vertex_count_ = vertices.size() / 3;
+        const void *data = quantizer_.Encode(format_, vertices.data(), vertex_count_, quantized_);
+        vertex_offset_ = vertex_buffer_->Upload(data, GetVertexStride(format_) * vertex_count_);
     }
 
     void PointCloudDrawable::Render(glm::mat4 projection_mat, glm::mat4 view_mat,
-                                    glm::mat4 model_mat,
-                                    const std::vector <float> &vertices) {
+                                    glm::mat4 model_mat) {
         glUseProgram(shader_program_);
-        vertices_visible_handle_ = glGetUniformLocation(shader_program_, "visible");
         if (visible) {
             glUniform1i(vertices_visible_handle_, GL_TRUE);
         } else {
             glUniform1i(vertices_visible_handle_, GL_FALSE);
         }
 
-        mvp_handle_ = glGetUniformLocation(shader_program_, "mvp");
         // Calculate model view projection matrix.
         glm::mat4 mvp_mat = projection_mat * view_mat * model_mat;
         glUniformMatrix4fv(mvp_handle_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
+        glm::mat4 decode_mat = quantizer_.GetDecodeMatrix(format_);
+        glUniform3f(decode_scale_handle_, decode_mat[0][0], decode_mat[1][1], decode_mat[2][2]);
+        glUniform3f(decode_offset_handle_, decode_mat[3][0], decode_mat[3][1], decode_mat[3][2]);
 
-        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers_);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * vertices.size(),
-                     vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_->GetBufferId());
         glEnableVertexAttribArray(vertices_handle_);
-        glVertexAttribPointer(vertices_handle_, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+        SetVertexAttribPointer(format_, vertices_handle_, vertex_offset_);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        glDrawArrays(GL_POINTS, 0, vertices.size() / 3);
+        glDrawArrays(GL_POINTS, 0, vertex_count_);
 
         glUseProgram(0);
         tango_gl::util::CheckGlError("Pointcloud::Render()");
     }
 
+    void PointCloudDrawable::Render(glm::mat4 projection_mat, glm::mat4 view_mat,
+                                    glm::mat4 model_mat,
+                                    const std::vector <float> &vertices) {
+        UpdateVertices(vertices);
+        Render(projection_mat, view_mat, model_mat);
+    }
+
+    void PointCloudDrawable::SetVertexFormat(VertexFormat format) {
+        pending_format_ = format;
+    }
+
     void PointCloudDrawable::SetVisibility(bool _visible) {
         visible = _visible;
     }
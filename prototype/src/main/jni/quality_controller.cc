@@ -0,0 +1,109 @@
+#include "tango-augmented-reality/quality_controller.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+    // weight of a new frame in the moving averages
+    const float kAverageWeight = 0.1f;
+
+    // frames to wait after a change before lowering or raising again
+    const int kLowerSettleFrames = 15;
+    const int kRaiseSettleFrames = 60;
+    // a raise which had to be undone doubles the wait for the next one, up to this
+    const int kMaxRaiseSettleFrames = 480;
+
+    // fraction of the target the frame time has to stay under for raising
+    const float kRaiseHeadroom = 0.7f;
+
+    float average(float current, float value) {
+        if (current == 0.0f) {
+            return value;
+        }
+        return current + kAverageWeight * (value - current);
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    const QualityLevels kQualityLevels = {
+            {2, 3, 4},
+            // the highest quality keeps the iterations the user configured
+            {std::numeric_limits<int>::max(), 8, 5},
+            {1.0f, 0.6f, 0.4f},
+            {1.0f, 0.75f, 0.5f}
+    };
+
+    QualityController::QualityController(float target_frame_ms) :
+            target_frame_ms_(target_frame_ms) {
+        Reset();
+    }
+
+    void QualityController::Reset() {
+        average_frame_ms_ = 0.0f;
+        for (int i = 0; i < STAGE_COUNT; ++i) {
+            average_stage_ms_[i] = 0.0f;
+            levels_[i] = 0;
+        }
+        lowered_stages_.clear();
+        settle_frames_ = 0;
+        raise_settle_frames_ = kRaiseSettleFrames;
+        last_change_raised_ = false;
+        ApplyLevels();
+    }
+
+    bool QualityController::Update(const float stage_ms[STAGE_COUNT], float frame_ms) {
+        average_frame_ms_ = average(average_frame_ms_, frame_ms);
+        for (int i = 0; i < STAGE_COUNT; ++i) {
+            average_stage_ms_[i] = average(average_stage_ms_[i], stage_ms[i]);
+        }
+        settle_frames_++;
+
+        if (average_frame_ms_ > target_frame_ms_ && settle_frames_ >= kLowerSettleFrames) {
+            // lower the most expensive stage, which has quality left to give
+            int expensive_stage = -1;
+            for (int i = 0; i < STAGE_COUNT; ++i) {
+                if (levels_[i] < kQualityLevelCount - 1 &&
+                    (expensive_stage < 0 ||
+                     average_stage_ms_[i] > average_stage_ms_[expensive_stage])) {
+                    expensive_stage = i;
+                }
+            }
+            if (expensive_stage >= 0) {
+                if (last_change_raised_ && settle_frames_ < raise_settle_frames_) {
+                    // the last raise did not hold, back off to not follow every load swing
+                    raise_settle_frames_ = std::min(raise_settle_frames_ * 2, kMaxRaiseSettleFrames);
+                }
+                levels_[expensive_stage]++;
+                lowered_stages_.push_back(expensive_stage);
+                settle_frames_ = 0;
+                last_change_raised_ = false;
+                ApplyLevels();
+                return true;
+            }
+        } else if (average_frame_ms_ < target_frame_ms_ * kRaiseHeadroom &&
+                   settle_frames_ >= raise_settle_frames_ && !lowered_stages_.empty()) {
+            if (last_change_raised_) {
+                // the last raise held
+                raise_settle_frames_ = kRaiseSettleFrames;
+            }
+            levels_[lowered_stages_.back()]--;
+            lowered_stages_.pop_back();
+            settle_frames_ = 0;
+            last_change_raised_ = true;
+            ApplyLevels();
+            return true;
+        }
+        return false;
+    }
+
+    void QualityController::ApplyLevels() {
+        settings_.skip_interval = kQualityLevels.skip_intervals[levels_[STAGE_CAMERA]];
+        settings_.ransac_iteration_limit =
+                kQualityLevels.ransac_iteration_limits[levels_[STAGE_RECONSTRUCTION]];
+        settings_.filter_diameter_scale =
+                kQualityLevels.filter_diameter_scales[levels_[STAGE_FILTER]];
+        settings_.occlusion_scale = kQualityLevels.occlusion_scales[levels_[STAGE_OCCLUSION]];
+    }
+
+}  // namespace tango_augmented_reality
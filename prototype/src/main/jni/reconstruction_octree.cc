@@ -100,6 +100,18 @@ namespace tango_augmented_reality {
         return reconstructor->getMesh();
     }
 
+    void ReconstructionOcTree::getReconstructors(std::vector <Reconstructor *> &reconstructors) {
+        if (depth_ != 0) {
+            for (int i = 0; i < 8; ++i) {
+                if (is_available_[i]) {
+                    children_[i]->getReconstructors(reconstructors);
+                }
+            }
+        } else {
+            reconstructors.push_back(reconstructor);
+        }
+    }
+
 
     void ReconstructionOcTree::clear() {
         if (depth_ != 0) {
@@ -113,6 +125,19 @@ namespace tango_augmented_reality {
         }
     }
 
+    void ReconstructionOcTree::setConfig(const ReconstructorConfig &config) {
+        config_ = config;
+        if (depth_ != 0) {
+            for (int i = 0; i < 8; ++i) {
+                if (is_available_[i]) {
+                    children_[i]->setConfig(config);
+                }
+            }
+        } else {
+            reconstructor->setConfig(config);
+        }
+    }
+
     void ReconstructionOcTree::initChild(glm::vec3 location, int index) {
         glm::vec3 childPosition;
         childPosition.x = (location.x > (position_.x + halfRange_))
@@ -122,6 +147,7 @@ namespace tango_augmented_reality {
         childPosition.z = (location.z > (position_.z + halfRange_))
                           ? (position_.z + halfRange_) : (position_.z);
         children_[index] = new ReconstructionOcTree(childPosition, halfRange_, depth_ - 1);
+        children_[index]->setConfig(config_);
         is_available_[index] = true;
     }
 
@@ -1,12 +1,19 @@
 #include "tango-augmented-reality/reconstructor.h"
 
+#include <algorithm>
+#include <cmath>
+
+#include "polygontriangulation.h"
+
 namespace tango_augmented_reality {
 
     void Reconstructor::reconstruct() {
 
         mesh_.clear();
+        mesh_version_++;
+        mesh_ranges_.fill(std::make_pair(0, 0));
 
-        for (int planeIndex = 0; planeIndex < ransac_detect_planes; ++planeIndex) {
+        for (int planeIndex = 0; planeIndex < config_.max_planes; ++planeIndex) {
             // continue with next plane iteration if not enough points available
             if (points.size() < 4 && !plane_available[planeIndex]) {
                 continue;
@@ -25,7 +32,7 @@ namespace tango_augmented_reality {
                 continue;
             }
 
-            if ((calculated_points_size * ransac_sufficient_support) >
+            if ((calculated_points_size * config_.ransac_sufficient_support) >
                 ransac_best_supporting_points.size()) {
                 continue;
             } else {
@@ -37,8 +44,8 @@ namespace tango_augmented_reality {
                                                          ransac_best_supporting_points);
 
             // CALCULATE THE CONVEX HULL
-            ConvexHull *h = new ConvexHull();
-            std::vector <glm::vec2> hull = h->generateConvexHull(projection);
+            ConvexHull convex_hull;
+            std::vector <glm::vec2> hull = convex_hull.generateConvexHull(projection);
             hull.pop_back();    // remove last point which is available twice
             if (hull.size() < 4) {
                 plane_available[planeIndex] = false;
@@ -50,36 +57,41 @@ namespace tango_augmented_reality {
 
             // STORE THE LAST CONVEX HULL FOR EACH PLANE
             planes[planeIndex].points = hull_projection;
-            scaleAroundCentroid(ransac_scale_planes, hull_projection);
+            scaleAroundCentroid(config_.hull_scale, hull_projection);
 
             // TRIANGULATION
-            std::vector <glm::vec2> mesh_points;
-            for (int i = 0; i < hull_projection.size() - 2; i++) {
-                mesh_.push_back(hull_projection[0]);
-                mesh_.push_back(hull_projection[i + 1]);
-                mesh_.push_back(hull_projection[i + 2]);
+            // delaunay triangles of the hull in plane coordinates, the scaled 3d
+            // hull keeps the order of the corners
+            constructnative::Polygon2D polygon;
+            polygon.ringSizes.push_back(hull.size());
+            for (size_t i = 0; i < hull.size(); ++i) {
+                polygon.points.push_back(hull[i].x);
+                polygon.points.push_back(hull[i].y);
+            }
+            std::vector<int> triangles;
+            constructnative::triangulatePolygon(polygon, triangles);
+            mesh_ranges_[planeIndex].first = mesh_.size();
+            for (size_t i = 0; i < triangles.size(); ++i) {
+                mesh_.push_back(hull_projection[triangles[i]]);
             }
+            mesh_ranges_[planeIndex].second = mesh_.size();
         }
     }
 
-    std::vector <glm::vec2> Reconstructor::project(Plane plane, std::vector <glm::vec3> &points) {
-        std::vector <glm::vec2> result;
-        for (int i = 0; i < points.size(); ++i) {
-            glm::vec3 point = points[i];
-            point = point - plane.plane_origin;
-            point = plane.plane_z_rotation * point;
-            result.push_back(glm::vec2(point.x, point.y));
+    std::vector <glm::vec2> Reconstructor::project(const Plane &plane,
+                                                   const std::vector <glm::vec3> &points) {
+        std::vector <glm::vec2> result(points.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            result[i] = plane.project(points[i]);
         }
         return result;
     }
 
-    std::vector <glm::vec3> Reconstructor::project(Plane plane, std::vector <glm::vec2> &points) {
-        std::vector <glm::vec3> result;
-        for (int i = 0; i < points.size(); ++i) {
-            glm::vec3 point = glm::vec3(points[i].x, points[i].y, 0.0);
-            point = plane.inverse_plane_z_rotation * point;
-            point = point + plane.plane_origin;
-            result.push_back(point);
+    std::vector <glm::vec3> Reconstructor::project(const Plane &plane,
+                                                   const std::vector <glm::vec2> &points) {
+        std::vector <glm::vec3> result(points.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            result[i] = plane.unproject(points[i]);
         }
         return result;
     }
@@ -87,9 +99,9 @@ namespace tango_augmented_reality {
     Plane Reconstructor::detectPlane(std::vector < glm::vec3 > &points) {
         int best_support = 0;
         Plane result;
-        int ransac_sufficient_support_count = ransac_sufficient_support * points.size();
+        int ransac_sufficient_support_count = config_.ransac_sufficient_support * points.size();
 
-        int iterations = ransac_iterations;
+        int iterations = config_.ransac_iterations;
         while (iterations > 0) {
             iterations--;
             // 1. pick 3 random points
@@ -101,12 +113,10 @@ namespace tango_augmented_reality {
                                                 points[selected_index[2]]);
             free(selected_index);
             // 3. estimate support for calculated plane
-            int support = ransacEstimateSupportingPoints(plane, points);
+            int support = ransacEstimateSupport(plane, points);
             // 4. replace better solutions
             if (best_support < support) {
                 best_support = support;
-                ransac_best_supporting_points = ransac_supporting_points;
-                ransac_best_not_supporting_points = ransac_not_supporting_points;
                 result = plane;
             }
             // 5. stop if support is already sufficient
@@ -115,7 +125,10 @@ namespace tango_augmented_reality {
             }
         }
         // 6. apply linear regression to optimize plane with supporting points
-        result = ransacApplyLinearRegression(result, ransac_supporting_points);
+        ransacSplitPoints(result, points);
+        if (ransac_best_supporting_points.size() >= 3) {
+            result = ransacApplyLinearRegression(result, ransac_best_supporting_points);
+        }
         return result;
     }
 
@@ -156,40 +169,71 @@ namespace tango_augmented_reality {
                          es.eigenvectors().col(min_index)[1].real(),
                          es.eigenvectors().col(min_index)[2].real());
         normal = glm::normalize(normal);
-        plane.normal = normal;
-        // new distance is the cross product of normal and centroid
-        plane.distance = glm::dot(normal, centroid);
-        return plane;
+        // new distance is the cross product of normal and centroid, the projection
+        // basis follows the new normal
+        return Plane(normal, glm::dot(normal, centroid));
     }
 
-    int Reconstructor::ransacEstimateSupportingPoints(Plane plane,
-                                                      std::vector <glm::vec3> &points) {
+    int Reconstructor::ransacEstimateSupport(const Plane &plane,
+                                             const std::vector <glm::vec3> &points) {
         int support = 0;
-        ransac_supporting_points.clear();
-        ransac_not_supporting_points.clear();
-        for (int i = 0; i < points.size(); ++i) {
-            if (plane.distanceTo(points[i]) < ransac_threshold) {
-                support++;
-                ransac_supporting_points.push_back(points[i]);
+        for (size_t i = 0; i < points.size(); ++i) {
+            support += plane.distanceTo(points[i]) < config_.ransac_threshold;
+        }
+        return support;
+    }
+
+    void Reconstructor::ransacSplitPoints(const Plane &plane,
+                                          const std::vector <glm::vec3> &points) {
+        ransac_best_supporting_points.clear();
+        ransac_best_not_supporting_points.clear();
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (plane.distanceTo(points[i]) < config_.ransac_threshold) {
+                ransac_best_supporting_points.push_back(points[i]);
             } else {
-                ransac_not_supporting_points.push_back(points[i]);
+                ransac_best_not_supporting_points.push_back(points[i]);
             }
         }
-        return support;
     }
 
     void Reconstructor::reset() {
         mesh_.clear();
+        mesh_version_++;
+        mesh_ranges_.fill(std::make_pair(0, 0));
         points.clear();
         ransac_best_not_supporting_points.clear();
         ransac_best_supporting_points.clear();
-        for (int i = 0; i < RANSAC_DETECT_PLANES; ++i) {
+        for (int i = 0; i < kMaxReconstructorPlanes; ++i) {
             plane_available[i] = false;
         }
     }
 
+    bool Reconstructor::setConfig(const ReconstructorConfig &config) {
+        config_ = config;
+        config_.max_planes = std::max(1, std::min(config.max_planes, kMaxReconstructorPlanes));
+        bool disabled = false;
+        // backwards, so the mesh ranges of the remaining planes stay valid
+        for (int i = kMaxReconstructorPlanes - 1; i >= config_.max_planes; --i) {
+            if (plane_available[i]) {
+                points.insert(points.end(), planes[i].points.begin(), planes[i].points.end());
+                planes[i].points.clear();
+                plane_available[i] = false;
+                mesh_.erase(mesh_.begin() + mesh_ranges_[i].first,
+                            mesh_.begin() + mesh_ranges_[i].second);
+                mesh_ranges_[i] = std::make_pair(0, 0);
+                disabled = true;
+            }
+        }
+        if (disabled) {
+            // a new version drops everything built from the disabled planes, like
+            // the uploaded mesh and the surfaces merged from the planes
+            mesh_version_++;
+        }
+        return disabled;
+    }
+
     int *Reconstructor::ransacPickThreeRandomPoints(std::vector < glm::vec3 > &points) {
-        int *selected_index = (int *) malloc(sizeof(int) * RANSAC_DETECT_PLANES);
+        int *selected_index = (int *) malloc(sizeof(int) * 3);
         bool *is_selected = (bool *) malloc(sizeof(bool) * points.size());
         for (int j = 0; j < points.size(); ++j) {
             is_selected[j] = false;
@@ -211,27 +255,32 @@ namespace tango_augmented_reality {
         }
         centroid = centroid / points.size();
         for (int i = 0; i < points.size(); ++i) {
-            points[i] = ((points[i] - centroid) * 1.01) + centroid;
+            points[i] = ((points[i] - centroid) * scale) + centroid;
         }
     }
 
     Reconstructor::Reconstructor() {
-        for (int i = 0; i < RANSAC_DETECT_PLANES; ++i) {
+        for (int i = 0; i < kMaxReconstructorPlanes; ++i) {
             plane_available[i] = false;
         }
+        mesh_ranges_.fill(std::make_pair(0, 0));
     }
 
     void Reconstructor::addPoint(glm::vec3 point) {
-        int closest_index = -1;
-        float closest_distance = ransac_threshold;
-        for (int i = 0; i < RANSAC_DETECT_PLANES; ++i) {
-            if (plane_available[i]) {
-                float current_distance = planes[i].distanceTo(point);
-                if (current_distance < ransac_threshold && current_distance < closest_distance) {
-                    closest_distance = current_distance;
-                    closest_index = i;
-                }
-            }
+        int closest_index;
+        switch (config_.max_planes) {
+            case 1:
+                closest_index = findClosestPlane<1>(point);
+                break;
+            case 2:
+                closest_index = findClosestPlane<2>(point);
+                break;
+            case 3:
+                closest_index = findClosestPlane<3>(point);
+                break;
+            default:
+                closest_index = findClosestPlane<kMaxReconstructorPlanes>(point);
+                break;
         }
         if (closest_index >= 0) {
             planes[closest_index].points.push_back(point);
@@ -240,13 +289,21 @@ namespace tango_augmented_reality {
         }
     }
 
+    void Reconstructor::getPlanes(std::vector <const Plane *> &result) const {
+        for (int i = 0; i < config_.max_planes; ++i) {
+            if (plane_available[i]) {
+                result.push_back(&planes[i]);
+            }
+        }
+    }
+
     void Reconstructor::clearPoints() {
         points.clear();
     }
 
     int Reconstructor::getPointCount() {
         int count = 0;
-        for (int i = 0; i < RANSAC_DETECT_PLANES; ++i) {
+        for (int i = 0; i < config_.max_planes; ++i) {
             if (plane_available[i]) {
                 count += planes[i].points.size();
             }
@@ -258,9 +315,14 @@ namespace tango_augmented_reality {
     Plane::Plane(glm::vec3 normal, float distance) :
             normal(normal),
             distance(distance),
-            plane_origin(normal * distance),
-            plane_z_rotation(glm::rotation(normal, glm::vec3(0, 0, 1))),
-            inverse_plane_z_rotation(glm::inverse(glm::rotation(normal, glm::vec3(0, 0, 1)))) { }
+            plane_origin(normal * distance) {
+        // any axis not parallel to the normal spans the plane together with it
+        glm::vec3 axis = std::abs(normal.x) < 0.9f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+        glm::vec3 u = glm::normalize(glm::cross(normal, axis));
+        glm::vec3 v = glm::cross(normal, u);
+        plane_basis = glm::mat3x2(u.x, v.x, u.y, v.y, u.z, v.z);
+        inverse_plane_basis = glm::mat2x3(u, v);
+    }
 
     Plane Plane::calculatePlane(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2) {
         // Vector3s
@@ -274,8 +336,4 @@ namespace tango_augmented_reality {
         return Plane(normal, distance);
     }
 
-    float Plane::distanceTo(glm::vec3 point) {
-        return glm::dot(normal, point) - distance;
-    }
-
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "tango-augmented-reality/resolution_controller.h"
+
+namespace {
+    // available scales of the occlusion buffer, from full to lowest resolution
+    const float kScaleLevels[] = {1.0f, 0.75f, 0.5f};
+    const int kScaleLevelCount = sizeof(kScaleLevels) / sizeof(float);
+
+    // weight of a new frame in the moving average
+    const float kAverageWeight = 0.1f;
+
+    // frames to wait after a change before lowering or raising again
+    const int kLowerSettleFrames = 15;
+    const int kRaiseSettleFrames = 60;
+
+    // fraction of the budget the frame time has to stay under for raising
+    const float kRaiseHeadroom = 0.7f;
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    ResolutionController::ResolutionController(float frame_budget_ms) :
+            frame_budget_ms_(frame_budget_ms) { }
+
+    bool ResolutionController::Update(float frame_time_ms) {
+        if (average_frame_time_ms_ == 0.0f) {
+            average_frame_time_ms_ = frame_time_ms;
+        } else {
+            average_frame_time_ms_ += kAverageWeight * (frame_time_ms - average_frame_time_ms_);
+        }
+        settle_frames_++;
+
+        if (average_frame_time_ms_ > frame_budget_ms_ &&
+            settle_frames_ >= kLowerSettleFrames &&
+            level_ < kScaleLevelCount - 1) {
+            level_++;
+            settle_frames_ = 0;
+            return true;
+        }
+        if (average_frame_time_ms_ < frame_budget_ms_ * kRaiseHeadroom &&
+            settle_frames_ >= kRaiseSettleFrames &&
+            level_ > min_level_) {
+            level_--;
+            settle_frames_ = 0;
+            return true;
+        }
+        return false;
+    }
+
+    float ResolutionController::GetScale() const {
+        return kScaleLevels[level_];
+    }
+
+    void ResolutionController::SetMaxScale(float scale) {
+        min_level_ = 0;
+        while (min_level_ < kScaleLevelCount - 1 && kScaleLevels[min_level_] > scale) {
+            min_level_++;
+        }
+        if (level_ < min_level_) {
+            level_ = min_level_;
+            settle_frames_ = 0;
+        }
+    }
+
+    void ResolutionController::Reset() {
+        average_frame_time_ms_ = 0.0f;
+        settle_frames_ = 0;
+        level_ = min_level_;
+    }
+
+}  // namespace tango_augmented_reality
@@ -19,12 +19,24 @@
 
 
 namespace {
-    long long currentTimeInMilliseconds() {
+    long long currentTimeInMicroseconds() {
         struct timeval tv;
         gettimeofday(&tv, NULL);
-        return ((tv.tv_sec * 1000) + (tv.tv_usec / 1000));
+        return ((tv.tv_sec * 1000000LL) + tv.tv_usec);
     }
 
+    float millisecondsSince(long long start) {
+        return (currentTimeInMicroseconds() - start) / 1000.0f;
+    }
+
+    // Render time the dynamic occlusion resolution tries to hold.
+    const float kOcclusionFrameBudgetMs = 33.0f;
+
+    // Depth camera pixels per organized cloud cell and the radius in cells of the
+    // smooth surface test.
+    const int kOrganizedCloudDownscale = 2;
+    const int kOrganizedSmoothRadius = 2;
+
     // We want to represent the device properly with respect to the ground so we'll
     // add an offset in z to our origin. We'll set this offset to 1.3 meters based
     // on the average height of a human standing with a Tango device. This allows us
@@ -54,14 +66,20 @@ namespace {
 
 namespace tango_augmented_reality {
 
-    Scene::Scene() { }
+    Scene::Scene() : resolution_controller_(kOcclusionFrameBudgetMs), reset_resolution_(false) { }
 
     Scene::~Scene() { }
 
     void Scene::InitGLContent() {
-
-        depth_width_ = 1280 / 2;
-        depth_height_ = 720 / 2;
+        // programs of a previous context are gone
+        ShaderCache::Invalidate();
+
+        max_depth_width_ = 1280 / 2;
+        max_depth_height_ = 720 / 2;
+        depth_width_ = max_depth_width_;
+        depth_height_ = max_depth_height_;
+        occlusion_scale_ = 1.0f;
+        resolution_controller_.Reset();
         gl_depth_format_ = GL_UNSIGNED_SHORT;       // 16 Bit
         cv_depth_format_ = CV_16UC1;                // 16 Bit
 
@@ -76,9 +94,17 @@ namespace tango_augmented_reality {
         glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, depth_width_, depth_height_, 0,
                      GL_DEPTH_COMPONENT, gl_depth_format_, NULL);
 
+        // create color texture, which keeps the occlusion geometry for single pass mode
+        occlusion_drawable_ = new DepthDrawable();
+        glBindTexture(GL_TEXTURE_2D, occlusion_drawable_->GetTextureId());
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, depth_width_, depth_height_, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
         // create frame buffer with color texture and depth
         glGenFramebuffers(1, &depth_frame_buffer_);
         glBindFramebuffer(GL_FRAMEBUFFER, depth_frame_buffer_);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                               occlusion_drawable_->GetTextureId(), 0);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
                                depth_drawable_->GetTextureId(), 0);
         GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
@@ -87,6 +113,10 @@ namespace tango_augmented_reality {
         if (status != GL_FRAMEBUFFER_COMPLETE) {
             LOGE("ERROR in fb %d ", depth_frame_buffer_);
         }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        depth_readback_ = new DepthReadback(depth_width_, depth_height_, gl_depth_format_);
+        depth_filter_ = new DepthFilter();
 
         // Allocating render camera and drawable object.
         // All of these objects are for visualization purposes.
@@ -119,12 +149,16 @@ namespace tango_augmented_reality {
         delete gesture_camera_;
         delete yuv_drawable_;
         delete depth_drawable_;
+        delete occlusion_drawable_;
         delete axis_;
         delete frustum_;
         delete trace_;
         delete grid_;
         delete cube_;
         delete point_cloud_drawable_;
+        delete depth_readback_;
+        delete depth_filter_;
+        ShaderCache::DeletePrograms();
     }
 
     void Scene::SetupViewPort(int x, int y, int w, int h) {
@@ -139,6 +173,14 @@ namespace tango_augmented_reality {
         if (!is_yuv_texture_available_) {
             return;
         }
+        long long frame_start = currentTimeInMicroseconds();
+        long long stage_start;
+
+        if (reset_resolution_) {
+            reset_resolution_ = false;
+            resolution_controller_.Reset();
+            SetOcclusionResolution(quality_occlusion_scale_);
+        }
 
 
         if (power_ > 0.0) {
@@ -162,8 +204,10 @@ namespace tango_augmented_reality {
             depth_drawable_->SetRotation(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
         }
 
+        stage_start = currentTimeInMicroseconds();
         ConvertYuvToRGBMat();
         BindRGBMatAsTexture();
+        stage_ms_[STAGE_CAMERA] = millisecondsSince(stage_start);
 
         glEnable(GL_DEPTH_TEST);
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
@@ -196,91 +240,92 @@ namespace tango_augmented_reality {
         }
 
 
+        stage_start = currentTimeInMicroseconds();
         if ((mode == TSDF || mode == PLANE) &&
             last_depth_timestamp - last_depth_timestamp_updated > 1.0) {
             Tap();
         }
+        stage_ms_[STAGE_RECONSTRUCTION] = millisecondsSince(stage_start);
 
-        if (show_occlusion) {
-            // render reconstructions or pointcloud, depending on mode
-            switch (mode) {
-                case POINTCLOUD: {
-                    std::lock_guard <std::mutex> lock(depth_mutex_);
-                    point_cloud_drawable_->Render(gesture_camera_->GetProjectionMatrix(),
-                                                  gesture_camera_->GetViewMatrix(),
-                                                  point_cloud_transformation, vertices);
-                }
-                    break;
-                case TSDF: {
-                    std::lock_guard <std::mutex> lock(chisel_mesh_->render_mutex);
-                    chisel_mesh_->Render(gesture_camera_->GetProjectionMatrix(),
-                                         gesture_camera_->GetViewMatrix());
-                }
-                    break;
-                case PLANE: {
-                    std::lock_guard <std::mutex> lock(plane_mesh_->render_mutex);
-                    plane_mesh_->Render(gesture_camera_->GetProjectionMatrix(),
-                                        gesture_camera_->GetViewMatrix());
-                }
-                    break;
+        if (mode == POINTCLOUD) {
+            // upload a new depth frame once, it is shared by all following passes
+            std::lock_guard <std::mutex> lock(depth_mutex_);
+            if (vertices_updated_) {
+                point_cloud_drawable_->UpdateVertices(vertices);
+                vertices_updated_ = false;
             }
         }
 
+        bool render_occlusion_pass = show_occlusion && !single_pass_occlusion;
+        if (render_occlusion_pass) {
+            RenderReconstruction();
+        }
+
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         glEnable(GL_DEPTH_TEST);
 
-        // draw depth to framebuffer object
+        // draw depth to framebuffer object, with its own resolution
+        stage_start = currentTimeInMicroseconds();
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
         glBindFramebuffer(GL_FRAMEBUFFER, depth_frame_buffer_);
+        glViewport(0, 0, depth_width_, depth_height_);
         glClearColor(0.0, 0.0, 0.0, 0.0);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // render reconstructions or pointcloud, depending on mode
-        switch (mode) {
-            case POINTCLOUD: {
-                std::lock_guard <std::mutex> lock(depth_mutex_);
-                point_cloud_drawable_->Render(gesture_camera_->GetProjectionMatrix(),
-                                              gesture_camera_->GetViewMatrix(),
-                                              point_cloud_transformation, vertices);
-            }
-                break;
-            case TSDF: {
-                std::lock_guard <std::mutex> lock(chisel_mesh_->render_mutex);
-                chisel_mesh_->Render(gesture_camera_->GetProjectionMatrix(),
-                                     gesture_camera_->GetViewMatrix());
-            }
-                break;
-            case PLANE: {
-                std::lock_guard <std::mutex> lock(depth_mutex_);
-                plane_mesh_->Render(gesture_camera_->GetProjectionMatrix(),
-                                    gesture_camera_->GetViewMatrix());
-            }
-                break;
-        }
+        // the color attachment keeps the unblended geometry, it gets blended once
+        // when it is drawn as overlay
+        glDisable(GL_BLEND);
+        RenderReconstruction();
+        glEnable(GL_BLEND);
 
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        stage_ms_[STAGE_OCCLUSION] = millisecondsSince(stage_start);
 
+        // the filter itself runs on a worker thread, its time is reported from there
+        stage_ms_[STAGE_FILTER] = do_filtering ? depth_filter_->GetLastFilterTime() : 0.0f;
         if (do_filtering) {
             // DEPTH FILTERING ...
-            // convert from depth component to mat
-            glBindFramebuffer(GL_FRAMEBUFFER, depth_frame_buffer_);
-            glReadPixels(0, 0, depth_frame.cols, depth_frame.rows, GL_DEPTH_COMPONENT,
-                         gl_depth_format_, depth_frame.ptr());
-
-            // apply opencv filters
-            cv::Mat temp_frame(depth_frame.size(), CV_8UC1);
-            depth_frame.convertTo(temp_frame, CV_8U, 0.00390625);
-            long long before = currentTimeInMilliseconds();
-            cv::ximgproc::guidedFilter(rgb_frame, temp_frame, temp_frame, diameter, sigma);
-            long long after = currentTimeInMilliseconds();
-            LOGD("%lld miliseconds for filtering", after - before);
-            temp_frame.convertTo(depth_frame, CV_16UC1, 255);
-
-            // copy back to depth texture
-            glBindTexture(GL_TEXTURE_2D, depth_drawable_->GetTextureId());
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, depth_frame.cols, depth_frame.rows,
-                         0, GL_DEPTH_COMPONENT, gl_depth_format_, depth_frame.ptr());
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            // queue the read of this frame and pick up the last one, if it is done
+            depth_readback_->Read(depth_frame_buffer_);
+            if (depth_readback_->Map(depth_frame)) {
+                // filter radius is given for the full resolution
+                float diameter_scale = occlusion_scale_ * filter_diameter_scale_;
+                int scaled_diameter = std::max(1, static_cast<int>(diameter * diameter_scale + 0.5f));
+                // the guide image follows the occlusion resolution
+                const cv::Mat *guide_frame = &rgb_frame;
+                if (rgb_frame.cols != depth_width_ || rgb_frame.rows != depth_height_) {
+                    cv::resize(rgb_frame, scaled_rgb_frame, cv::Size(depth_width_, depth_height_),
+                               0, 0, cv::INTER_AREA);
+                    guide_frame = &scaled_rgb_frame;
+                }
+                depth_filter_->Submit(depth_frame, *guide_frame, scaled_diameter, sigma);
+            }
+
+            // the depth attachment is rendered raw every frame, so the last filtered frame is
+            // copied back to the depth texture on every frame until a newer one arrives.
+            // Results from before a resolution change are dropped.
+            depth_filter_->TakeResult(filtered_depth_frame);
+            if (filtered_depth_frame.cols == depth_width_ &&
+                filtered_depth_frame.rows == depth_height_) {
+                glBindTexture(GL_TEXTURE_2D, depth_drawable_->GetTextureId());
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, filtered_depth_frame.cols,
+                                filtered_depth_frame.rows, GL_DEPTH_COMPONENT, gl_depth_format_,
+                                filtered_depth_frame.ptr());
+            }
+        } else {
+            // drop finished frames, they would be stale once filtering is enabled again
+            depth_filter_->TakeResult(filtered_depth_frame);
+            filtered_depth_frame.release();
+        }
+
+        if (show_occlusion && single_pass_occlusion) {
+            // overlay the framebuffer color on the whole viewport, like the depth blit
+            glDisable(GL_DEPTH_TEST);
+            occlusion_drawable_->Render(glm::mat4(1.0f), glm::mat4(1.0f));
+            glEnable(GL_DEPTH_TEST);
         }
 
         // render drawable depth
@@ -289,14 +334,126 @@ namespace tango_augmented_reality {
         // copy depth to main framebuffer
         glBindFramebuffer(GL_READ_FRAMEBUFFER, depth_frame_buffer_);
         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        glBlitFramebuffer(0, 0, depth_width_, depth_height_, 0, 0, depth_width_, depth_height_,
-                          GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        glBlitFramebuffer(0, 0, depth_width_, depth_height_,
+                          viewport[0], viewport[1], viewport[0] + viewport[2],
+                          viewport[1] + viewport[3], GL_DEPTH_BUFFER_BIT, GL_NEAREST);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
         // render rest of drawables
 //        grid_->Render(ar_camera_projection_matrix_, gesture_camera_->GetViewMatrix());
+        cube_->UpdateModel();
         cube_->Render(ar_camera_projection_matrix_, gesture_camera_->GetViewMatrix());
 
+        frame_ms_ = millisecondsSince(frame_start);
+        frame_timed_ = true;
+        if (dynamic_resolution && resolution_controller_.Update(frame_ms_)) {
+            SetOcclusionResolution(resolution_controller_.GetScale());
+        }
+    }
+
+    bool Scene::GetFrameTimings(float stage_ms[STAGE_COUNT], float *frame_ms) {
+        if (!frame_timed_) {
+            return false;
+        }
+        for (int i = 0; i < STAGE_COUNT; ++i) {
+            stage_ms[i] = stage_ms_[i];
+        }
+        *frame_ms = frame_ms_;
+        frame_timed_ = false;
+        return true;
+    }
+
+    void Scene::SetQualitySettings(const QualitySettings &settings) {
+        filter_diameter_scale_ = settings.filter_diameter_scale;
+        plane_mesh_->setRansacIterationLimit(settings.ransac_iteration_limit);
+        // with dynamic resolution the quality level only bounds the scale of the
+        // resolution controller, which keeps picking the scale
+        quality_occlusion_scale_ = settings.occlusion_scale;
+        resolution_controller_.SetMaxScale(quality_occlusion_scale_);
+        float scale = dynamic_resolution ? resolution_controller_.GetScale()
+                                         : quality_occlusion_scale_;
+        if (scale != occlusion_scale_) {
+            SetOcclusionResolution(scale);
+        }
+    }
+
+    void Scene::SetDynamicResolution(bool dynamic) {
+        dynamic_resolution = dynamic;
+        if (!dynamic) {
+            // buffers are reallocated on the GL thread with the next frame
+            reset_resolution_ = true;
+        }
+    }
+
+    void Scene::SetPlaneDetection(int detection) {
+        plane_mesh_->setPlaneDetection(static_cast<PlaneDetection>(detection));
+    }
+
+    void Scene::SetReconstructorConfig(const ReconstructorConfig &config) {
+        plane_mesh_->setReconstructorConfig(config);
+    }
+
+    void Scene::SetMergeLeafPlanes(bool merge) {
+        plane_mesh_->setMergeLeafPlanes(merge);
+    }
+
+    void Scene::SetVertexCompression(bool compressed) {
+        VertexFormat format = compressed ? VERTEX_FORMAT_SHORT : VERTEX_FORMAT_FLOAT;
+        chisel_mesh_->setVertexFormat(format);
+        plane_mesh_->setVertexFormat(format);
+        point_cloud_drawable_->SetVertexFormat(format);
+        cube_->SetCompressedVertices(compressed);
+    }
+
+    void Scene::SetOcclusionResolution(float scale) {
+        occlusion_scale_ = scale;
+        ResizeOcclusionBuffers(static_cast<size_t>(max_depth_width_ * scale),
+                               static_cast<size_t>(max_depth_height_ * scale));
+    }
+
+    void Scene::ResizeOcclusionBuffers(size_t width, size_t height) {
+        if (width == depth_width_ && height == depth_height_) {
+            return;
+        }
+        LOGD("Occlusion resolution %d x %d", static_cast<int>(width), static_cast<int>(height));
+        depth_width_ = width;
+        depth_height_ = height;
+
+        depth_frame = cv::Mat(depth_height_, depth_width_, cv_depth_format_);
+
+        // framebuffer attachments stay valid when the texture images get respecified
+        glBindTexture(GL_TEXTURE_2D, depth_drawable_->GetTextureId());
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, depth_width_, depth_height_, 0,
+                     GL_DEPTH_COMPONENT, gl_depth_format_, NULL);
+        glBindTexture(GL_TEXTURE_2D, occlusion_drawable_->GetTextureId());
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, depth_width_, depth_height_, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        delete depth_readback_;
+        depth_readback_ = new DepthReadback(depth_width_, depth_height_, gl_depth_format_);
+    }
+
+    void Scene::RenderReconstruction() {
+        switch (mode) {
+            case POINTCLOUD:
+                point_cloud_drawable_->Render(gesture_camera_->GetProjectionMatrix(),
+                                              gesture_camera_->GetViewMatrix(),
+                                              point_cloud_transformation);
+                break;
+            case TSDF: {
+                std::lock_guard <std::mutex> lock(chisel_mesh_->render_mutex);
+                chisel_mesh_->Render(gesture_camera_->GetProjectionMatrix(),
+                                     gesture_camera_->GetViewMatrix());
+            }
+                break;
+            case PLANE: {
+                std::lock_guard <std::mutex> lock(plane_mesh_->render_mutex);
+                plane_mesh_->Render(gesture_camera_->GetProjectionMatrix(),
+                                    gesture_camera_->GetViewMatrix());
+            }
+                break;
+        }
     }
 
     void Scene::SetCameraType(tango_gl::GestureCamera::CameraType camera_type) {
@@ -343,7 +500,7 @@ namespace tango_augmented_reality {
             yuv_buffer_.resize(yuv_size_);
             yuv_temp_buffer_.resize(yuv_size_);
             rgb_buffer_.resize(yuv_width_ * yuv_height_ * 3);
-            rgb_frame = cv::Mat(depth_height_, depth_width_, CV_8UC3);
+            rgb_frame = cv::Mat(max_depth_height_, max_depth_width_, CV_8UC3);
 
             glBindTexture(GL_TEXTURE_2D, yuv_drawable_->GetTextureId());
             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, rgb_frame.cols, rgb_frame.rows, 0, GL_RGB,
@@ -371,6 +528,7 @@ namespace tango_augmented_reality {
             std::lock_guard <std::mutex> lock(depth_mutex_);
             TangoSupport_copyXYZij(XYZ_ij, &XYZij);
             vertices = points;
+            vertices_updated_ = true;
         }
     }
 
@@ -382,8 +540,8 @@ namespace tango_augmented_reality {
                 swap_buffer_signal_ = false;
             }
         }
-        size_t x_factor = yuv_height_ / depth_height_;
-        size_t y_factor = yuv_width_ / depth_width_;
+        // the camera texture keeps the full resolution at every occlusion scale
+        rgb_frame.create(max_depth_height_, max_depth_width_, CV_8UC3);
         for (size_t i = 0; i < yuv_height_; ++i) {
             for (size_t j = 0; j < yuv_width_; ++j) {
                 size_t x_index = j;
@@ -396,7 +554,8 @@ namespace tango_augmented_reality {
                         yuv_buffer_[uv_buffer_offset_ + (i / 2) * yuv_width_ + x_index + 1],
                         yuv_buffer_[uv_buffer_offset_ + (i / 2) * yuv_width_ + x_index],
                         &rgb_dot[0], &rgb_dot[1], &rgb_dot[2]);
-                rgb_frame.at<cv::Vec3b>(i / x_factor, j / y_factor) = rgb_dot;
+                rgb_frame.at<cv::Vec3b>(i * max_depth_height_ / yuv_height_,
+                                        j * max_depth_width_ / yuv_width_) = rgb_dot;
             }
         }
         flip(rgb_frame, rgb_frame, 0);
@@ -426,7 +585,10 @@ namespace tango_augmented_reality {
             LOGD("Collect Points for Plane Reconstruction");
             {
                 std::lock_guard <std::mutex> lock(depth_mutex_);
-                plane_mesh_->addPoints(transformation, vertices);
+                long long before = currentTimeInMicroseconds();
+                organized_cloud_.Update(XYZij, depth_intrinsics, kOrganizedCloudDownscale);
+                LOGD("Organized cloud in %.2f ms", millisecondsSince(before));
+                plane_mesh_->addPoints(transformation, organized_cloud_, kOrganizedSmoothRadius);
                 plane_mesh_->updateVertices();
             }
         }
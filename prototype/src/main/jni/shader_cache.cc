@@ -0,0 +1,223 @@
+#include "tango-augmented-reality/shader_cache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace {
+    const unsigned int kBinaryMagic = 0x43505354;  // "TSPC"
+    const unsigned int kBinaryVersion = 1;
+
+    // header in front of each stored program binary
+    struct BinaryHeader {
+        unsigned int magic;
+        unsigned int version;
+        unsigned long long driver_hash;
+        unsigned long long source_hash;
+        GLenum format;
+        GLint length;
+    };
+
+    unsigned long long fnv1a(const std::string &text,
+                             unsigned long long hash = 14695981039346656037ULL) {
+        for (size_t i = 0; i < text.size(); ++i) {
+            hash ^= static_cast<unsigned char>(text[i]);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    std::string glString(GLenum name) {
+        const GLubyte *value = glGetString(name);
+        return value ? reinterpret_cast<const char *>(value) : "";
+    }
+
+    GLuint compileShader(GLenum type, const char *source) {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+        GLint compiled = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if (!compiled) {
+            GLchar log[512];
+            glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+            LOGE("Could not compile shader %d: %s", type, log);
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
+    GLuint linkProgram(const char *vertex_source, const char *fragment_source) {
+        GLuint vertex_shader = compileShader(GL_VERTEX_SHADER, vertex_source);
+        GLuint fragment_shader = compileShader(GL_FRAGMENT_SHADER, fragment_source);
+        if (!vertex_shader || !fragment_shader) {
+            glDeleteShader(vertex_shader);
+            glDeleteShader(fragment_shader);
+            return 0;
+        }
+        GLuint program = glCreateProgram();
+        glAttachShader(program, vertex_shader);
+        glAttachShader(program, fragment_shader);
+        // ask the driver to keep the binary, so it can be stored
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program);
+        glDetachShader(program, vertex_shader);
+        glDetachShader(program, fragment_shader);
+        glDeleteShader(vertex_shader);
+        glDeleteShader(fragment_shader);
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            GLchar log[512];
+            glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+            LOGE("Could not link program: %s", log);
+            glDeleteProgram(program);
+            return 0;
+        }
+        return program;
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    std::mutex ShaderCache::mutex_;
+    std::string ShaderCache::directory_;
+    std::map<std::string, GLuint> ShaderCache::programs_;
+    unsigned long long ShaderCache::driver_hash_ = 0;
+
+    void ShaderCache::SetDirectory(const std::string &directory) {
+        std::lock_guard <std::mutex> lock(mutex_);
+        directory_ = directory;
+    }
+
+    GLuint ShaderCache::GetProgram(const std::string &vertex_source,
+                                   const std::string &fragment_source) {
+        std::string sources = vertex_source + '\0' + fragment_source;
+        std::map<std::string, GLuint>::iterator it = programs_.find(sources);
+        if (it != programs_.end()) {
+            return it->second;
+        }
+
+        unsigned long long source_hash = fnv1a(sources);
+        GLuint program = LoadBinary(source_hash);
+        if (!program) {
+            program = linkProgram(vertex_source.c_str(), fragment_source.c_str());
+            if (!program) {
+                return 0;
+            }
+            StoreBinary(source_hash, program);
+        }
+        programs_[sources] = program;
+        tango_gl::util::CheckGlError("ShaderCache::GetProgram()");
+        return program;
+    }
+
+    void ShaderCache::Invalidate() {
+        programs_.clear();
+        driver_hash_ = 0;
+    }
+
+    void ShaderCache::DeletePrograms() {
+        for (std::map<std::string, GLuint>::iterator it = programs_.begin();
+             it != programs_.end(); ++it) {
+            glDeleteProgram(it->second);
+        }
+        Invalidate();
+    }
+
+    std::string ShaderCache::GetBinaryPath(unsigned long long source_hash) {
+        std::lock_guard <std::mutex> lock(mutex_);
+        if (directory_.empty()) {
+            return "";
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "/%016llx.glbin", source_hash);
+        return directory_ + name;
+    }
+
+    GLuint ShaderCache::LoadBinary(unsigned long long source_hash) {
+        std::string path = GetBinaryPath(source_hash);
+        if (path.empty()) {
+            return 0;
+        }
+        std::ifstream input(path.c_str(), std::ios::binary);
+        if (!input.is_open()) {
+            return 0;
+        }
+        BinaryHeader header;
+        input.read(reinterpret_cast<char *>(&header), sizeof(header));
+        if (!input || header.magic != kBinaryMagic || header.version != kBinaryVersion ||
+            header.driver_hash != GetDriverHash() || header.source_hash != source_hash ||
+            header.length <= 0) {
+            // written by another driver, the program is linked again and replaces it
+            return 0;
+        }
+        std::vector<char> binary(header.length);
+        input.read(binary.data(), header.length);
+        if (!input) {
+            return 0;
+        }
+
+        GLuint program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), header.length);
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            LOGE("Stored program binary %s was rejected", path.c_str());
+            glDeleteProgram(program);
+            // clear the GL error of the rejected binary
+            glGetError();
+            return 0;
+        }
+        return program;
+    }
+
+    void ShaderCache::StoreBinary(unsigned long long source_hash, GLuint program) {
+        std::string path = GetBinaryPath(source_hash);
+        if (path.empty()) {
+            return;
+        }
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) {
+            return;
+        }
+        BinaryHeader header;
+        header.magic = kBinaryMagic;
+        header.version = kBinaryVersion;
+        header.driver_hash = GetDriverHash();
+        header.source_hash = source_hash;
+        std::vector<char> binary(length);
+        glGetProgramBinary(program, length, &header.length, &header.format, binary.data());
+        if (header.length <= 0) {
+            return;
+        }
+
+        // write to a temporary file first, a half written binary is never picked up
+        std::string temp_path = path + ".tmp";
+        {
+            std::ofstream output(temp_path.c_str(), std::ios::binary | std::ios::trunc);
+            if (!output.is_open()) {
+                LOGE("Could not store program binary %s", path.c_str());
+                return;
+            }
+            output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            output.write(binary.data(), header.length);
+            if (!output) {
+                return;
+            }
+        }
+        rename(temp_path.c_str(), path.c_str());
+    }
+
+    unsigned long long ShaderCache::GetDriverHash() {
+        if (driver_hash_ == 0) {
+            driver_hash_ = fnv1a(glString(GL_VENDOR) + '\0' + glString(GL_RENDERER) + '\0' +
+                                 glString(GL_VERSION));
+        }
+        return driver_hash_;
+    }
+
+}  // namespace tango_augmented_reality
@@ -0,0 +1,65 @@
+#include "tango-augmented-reality/streaming_vertex_buffer.h"
+
+#include <cstring>
+
+namespace {
+    // amount of uploads of the largest seen size the ring can hold before it wraps
+    const int kRingFrames = 4;
+}
+
+namespace tango_augmented_reality {
+
+    StreamingVertexBuffer::StreamingVertexBuffer(GLsizeiptr capacity) : capacity_(capacity) {
+        glGenBuffers(1, &buffer_);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+        Orphan();
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    StreamingVertexBuffer::~StreamingVertexBuffer() {
+        DeleteGlResources();
+    }
+
+    void StreamingVertexBuffer::DeleteGlResources() {
+        if (buffer_) {
+            glDeleteBuffers(1, &buffer_);
+            buffer_ = 0;
+        }
+    }
+
+    GLintptr StreamingVertexBuffer::Upload(const void *data, GLsizeiptr size) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+        if (size > capacity_) {
+            // grow the ring, so it keeps several frames of the new size
+            capacity_ = size * kRingFrames;
+            Orphan();
+        } else if (head_ + size > capacity_) {
+            // wrap around, give the old storage to the driver
+            Orphan();
+        }
+
+        GLintptr offset = head_;
+        if (size > 0) {
+            void *target = glMapBufferRange(GL_ARRAY_BUFFER, offset, size,
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                                            GL_MAP_UNSYNCHRONIZED_BIT);
+            if (target != nullptr) {
+                memcpy(target, data, size);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+            } else {
+                // mapping is not available, fall back to a plain copy
+                glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+            }
+        }
+        head_ += size;
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        tango_gl::util::CheckGlError("StreamingVertexBuffer::Upload()");
+        return offset;
+    }
+
+    void StreamingVertexBuffer::Orphan() {
+        glBufferData(GL_ARRAY_BUFFER, capacity_, nullptr, GL_STREAM_DRAW);
+        head_ = 0;
+    }
+
+}  // namespace tango_augmented_reality
@@ -3,9 +3,12 @@
 
 #include <tango-gl/mesh.h>
 
+#include <atomic>
+#include <future>
 #include <string>
-#include <iostream>
-#include <fstream>
+
+#include "tango-augmented-reality/ply_loader.h"
+#include "tango-augmented-reality/vertex_format.h"
 
 // rendering 3D Object
 
@@ -13,6 +16,49 @@ namespace tango_augmented_reality {
     class ArObject : public tango_gl::Mesh {
     public:
         ArObject();
+
+        ~ArObject();
+
+        void Render(const glm::mat4 &projection_mat, const glm::mat4 &view_mat) const;
+
+        // replaces the placeholder cube with the model once the worker loaded it,
+        // has to be called on the GL thread
+        // @return: true if the model was uploaded
+        bool UpdateModel();
+
+        // switches between the float vertices and the compressed buffer with quantized
+        // positions and oct encoded normals
+        void SetCompressedVertices(bool compressed) { compressed_ = compressed; }
+
+    private:
+        // shaded program and its handles
+        struct Program {
+            GLuint program;
+            GLint mvp;
+            GLint mv;
+            GLint color;
+            GLint light;
+            GLint vertex;
+            GLint normal;
+        };
+
+        // gets the program for the vertex shader from the shader cache
+        void LoadProgram(Program &program, const std::string &vertex_shader);
+
+        // builds the compressed vertex buffer from vertices_ and normals_
+        void CreateCompressedBuffer();
+
+        std::atomic<bool> compressed_;
+
+        Program float_program_;
+        Program compressed_program_;
+
+        // model parsed by the worker thread
+        std::future <PlyMesh> model_;
+
+        GLuint compressed_buffer_ = 0;
+        GLsizei compressed_count_ = 0;
+        glm::mat4 decode_mat_;
     };
 }
 #endif  // AR_OBJECT_H
\ No newline at end of file
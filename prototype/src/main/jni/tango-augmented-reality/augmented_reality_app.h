@@ -98,6 +98,31 @@ namespace tango_augmented_reality {
         // sets the depth visibility
         void setDepthFullscreen(bool show);
 
+        // renders the occlusion geometry once and reuses the depth framebuffer, the
+        // geometry is shown at the occlusion resolution then
+        void setSinglePassOcclusion(bool single_pass);
+
+        // lets the occlusion resolution follow the frame time
+        void setDynamicResolution(bool dynamic);
+
+        // sets the directory the linked shader programs are stored in
+        void setShaderCacheDirectory(const std::string &directory);
+
+        // selects the plane detection of the plane mode
+        void setPlaneDetection(int detection);
+
+        // sets the parameters of the plane reconstruction
+        void setReconstructorConfig(const ReconstructorConfig &config);
+
+        // merges coplanar planes of the octree leaves into one mesh per surface
+        void setMergeLeafPlanes(bool merge);
+
+        // uploads the geometry with compressed vertex formats
+        void setVertexCompression(bool compressed);
+
+        // lets the quality controller adapt the pipeline parameters to the frame time
+        void setAdaptiveQuality(bool adaptive);
+
         // Tango service event callback function for pose data. Called when new events
         // are available from the Tango Service.
         //
@@ -183,6 +208,9 @@ namespace tango_augmented_reality {
         // Request the render function from Java layer.
         void RequestRender();
 
+        // Hand the current quality controller settings to the pipeline.
+        void ApplyQualitySettings();
+
         // pose_data_ handles all pose onPoseAvailable callbacks, onPoseAvailable()
         // in this object will be routed to pose_data_ to handle.
         PoseData pose_data_;
@@ -234,7 +262,16 @@ namespace tango_augmented_reality {
 
         cv::Mat rgb;
 
-        int skip_value = 0;
+        // both are used by the camera callback thread, skip_interval is set on
+        // the GL thread by the quality controller
+        std::atomic <int> skip_value;
+        // only every skip_interval-th camera frame is rendered
+        std::atomic <int> skip_interval;
+
+        // adapts the pipeline parameters if adaptive_quality is set
+        QualityController quality_controller_;
+        bool adaptive_quality = false;
+        std::atomic <bool> reset_quality_;
         float image_width;
         float image_height;
         float fx;
@@ -9,6 +9,7 @@
 #include <Eigen/Core>
 
 #include <mutex>
+#include <unordered_map>
 
 #include <open_chisel/Chisel.h>
 #include <open_chisel/camera/DepthImage.h>
@@ -24,6 +25,8 @@
 
 #include <tango_support_api.h>
 
+#include "tango-augmented-reality/gpu_buffer_arena.h"
+
 
 
 typedef boost::shared_ptr<chisel::DepthImage<float>> DepthImagePtr;
@@ -37,6 +40,8 @@ namespace tango_augmented_reality {
 
         ChiselMesh(GLenum render_mode);
 
+        ~ChiselMesh();
+
         void SetShader();
 
         void init(TangoCameraIntrinsics intrinsics);
@@ -51,7 +56,14 @@ namespace tango_augmented_reality {
 
         void clear();
 
+        // sets the vertex format of the mesh buffer, all chunks are uploaded again with
+        // the next update
+        void setVertexFormat(VertexFormat format);
+
     protected:
+        // creates the chisel map and its integrator with the current parameters
+        void createMap();
+
         tango_gl::BoundingBox *bounding_box_;
 
         GLuint uniform_mv_mat_;
@@ -72,6 +84,15 @@ namespace tango_augmented_reality {
         chisel::Intrinsics chiselIntrinsics;
         chisel::PinholeCamera pinHoleCamera;
 
+        // vertex buffer shared by the meshes of all chunks
+        GpuBufferArena *arena_;
+        // arena handle of each meshed chunk
+        std::unordered_map<chisel::ChunkID, int, chisel::ChunkHasher> chunkHandles;
+        // format of the arena and the one requested for the next update
+        VertexFormat vertexFormat;
+        VertexFormat pendingVertexFormat;
+        PositionQuantizer quantizer;
+
     };
 }  // namespace tango_augmented_reality
 #endif  // TANGO_AUGMENTED_REALITY_MESH_H_
@@ -0,0 +1,71 @@
+#ifndef TANGO_AUGMENTED_REALITY_DEPTH_FILTER_H_
+#define TANGO_AUGMENTED_REALITY_DEPTH_FILTER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <opencv2/core/core.hpp>
+
+namespace tango_augmented_reality {
+
+    // DepthFilter applies the guided filter to depth frames on a worker thread.
+    // Frames are submitted from the GL thread and the filtered result is picked up
+    // on one of the following frames, none of the calls wait for the filter.
+    class DepthFilter {
+    public:
+        DepthFilter();
+
+        ~DepthFilter();
+
+        // Hands a depth frame and its color guide to the worker. A frame which is
+        // still waiting gets replaced, the worker always filters the newest one.
+        //
+        // @param depth: 16 bit depth frame.
+        // @param rgb: color frame of the same size used as guide.
+        // @param diameter: guided filter radius.
+        // @param sigma: guided filter regularization.
+        void Submit(const cv::Mat &depth, const cv::Mat &rgb, int diameter, double sigma);
+
+        // Gets the last filtered frame if there is a new one.
+        //
+        // @param target: receives the 16 bit filtered depth frame.
+        // @return: true if target got a new result.
+        bool TakeResult(cv::Mat &target);
+
+        // @return: duration of the last filter run in milliseconds.
+        float GetLastFilterTime() const { return last_filter_time_ms_; }
+
+        // Filter kernel run by the worker, guided filter on the 8 bit depth.
+        //
+        // @param filtered: receives the 16 bit filtered depth frame.
+        static void Filter(const cv::Mat &depth, const cv::Mat &rgb, int diameter, double sigma,
+                           cv::Mat &filtered);
+
+    private:
+        // worker loop, waits for submitted frames and filters them
+        void Run();
+
+        std::thread worker_;
+        std::mutex mutex_;
+        std::condition_variable condition_;
+
+        // frame waiting for the worker
+        cv::Mat pending_depth_;
+        cv::Mat pending_rgb_;
+        int pending_diameter_ = 0;
+        double pending_sigma_ = 0.0;
+        bool has_pending_ = false;
+
+        // last filtered frame
+        cv::Mat result_;
+        bool has_result_ = false;
+
+        bool running_ = true;
+
+        std::atomic<float> last_filter_time_ms_;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_DEPTH_FILTER_H_
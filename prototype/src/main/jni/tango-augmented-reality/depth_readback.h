@@ -0,0 +1,50 @@
+#ifndef TANGO_AUGMENTED_REALITY_DEPTH_READBACK_H_
+#define TANGO_AUGMENTED_REALITY_DEPTH_READBACK_H_
+
+#include <GLES3/gl3.h>
+#include <tango-gl/util.h>
+
+#include <opencv2/core/core.hpp>
+
+namespace tango_augmented_reality {
+
+    // DepthReadback reads the depth attachment of a framebuffer through two pixel
+    // buffer objects. The read of frame N is only queued, the data of frame N-1 is
+    // mapped once its fence is signaled, so the GL thread never waits for the GPU.
+    class DepthReadback {
+    public:
+        // @param width: width of the framebuffer to read.
+        // @param height: height of the framebuffer to read.
+        // @param gl_depth_format: pixel type of the depth data, e.g. GL_UNSIGNED_SHORT.
+        DepthReadback(int width, int height, GLenum gl_depth_format);
+
+        ~DepthReadback();
+
+        // Queues an asynchronous read of the framebuffer depth into the next buffer.
+        void Read(GLuint frame_buffer);
+
+        // Copies the oldest pending read into target, if the GPU finished it.
+        //
+        // @param target: mat with the size and depth format of the framebuffer.
+        // @return: true if target got new depth data.
+        bool Map(cv::Mat &target);
+
+        // Free the GL buffers and fences.
+        void DeleteGlResources();
+
+    private:
+        int width_;
+        int height_;
+        GLenum gl_depth_format_;
+        GLsizeiptr size_;
+
+        // ping pong pixel buffers and their fences
+        GLuint pixel_buffers_[2];
+        GLsync fences_[2];
+
+        // index of the buffer the next read goes to
+        int write_index_ = 0;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_DEPTH_READBACK_H_
@@ -0,0 +1,94 @@
+#ifndef TANGO_AUGMENTED_REALITY_GPU_BUFFER_ARENA_H_
+#define TANGO_AUGMENTED_REALITY_GPU_BUFFER_ARENA_H_
+
+#include <GLES3/gl3.h>
+#include <map>
+#include <tango-gl/util.h>
+
+#include "tango-augmented-reality/vertex_format.h"
+
+namespace tango_augmented_reality {
+
+    // GpuBufferArena sub-allocates ranges of one vertex buffer to the pieces of a
+    // reconstruction (e.g. a chisel chunk or an octree leaf). Pieces are uploaded
+    // once, updated in place while they fit into their range and freed on removal.
+    // If the buffer gets full or fragmented all pieces are packed into new storage.
+    // Sizes and offsets are counted in vertices of the arena's format.
+    class GpuBufferArena {
+    public:
+        // @param format: layout of the vertices in the buffer.
+        // @param capacity: initial amount of vertices the buffer can hold.
+        GpuBufferArena(VertexFormat format, GLsizei capacity);
+
+        ~GpuBufferArena();
+
+        // Uploads a new piece.
+        //
+        // @param data: vertex data of the piece.
+        // @param count: vertex count of the piece.
+        // @return: handle of the piece.
+        int Allocate(const void *data, GLsizei count);
+
+        // Replaces the vertices of a piece, in place if they fit into its range.
+        void Update(int handle, const void *data, GLsizei count);
+
+        // Releases the range of a piece.
+        void Free(int handle);
+
+        // Releases all pieces, the buffer storage is kept.
+        void Clear();
+
+        // Draws all pieces, neighbouring pieces are merged into one draw call.
+        //
+        // @param mode: primitive type, e.g. GL_TRIANGLES.
+        // @param attrib: vertex attribute of the bound program.
+        void Draw(GLenum mode, GLuint attrib) const;
+
+        VertexFormat GetFormat() const { return format_; }
+
+        // @return: amount of vertices in all pieces.
+        GLsizei GetVertexCount() const { return used_; }
+
+        // Free the GL buffer.
+        void DeleteGlResources();
+
+    private:
+        struct Allocation {
+            // first vertex of the range
+            GLint offset;
+            // reserved vertices of the range
+            GLsizei capacity;
+            // vertices in use
+            GLsizei count;
+        };
+
+        // finds a free range with at least count vertices, -1 if there is none
+        GLint FindRange(GLsizei count);
+
+        // reserves a range, packs or grows the buffer if needed
+        GLint Reserve(GLsizei capacity);
+
+        // returns a range to the free list and merges it with its neighbours
+        void Release(GLint offset, GLsizei capacity);
+
+        // moves all pieces to the front of a new buffer with the given capacity
+        void Reallocate(GLsizei capacity);
+
+        void Upload(GLint offset, const void *data, GLsizei count);
+
+        GLuint buffer_ = 0;
+        VertexFormat format_;
+        GLsizei stride_;
+        GLsizei capacity_;
+        // vertices in use and reserved by all pieces
+        GLsizei used_ = 0;
+        GLsizei reserved_ = 0;
+
+        std::map<int, Allocation> allocations_;
+        // free ranges by offset
+        std::map<GLint, GLsizei> free_ranges_;
+        int next_handle_ = 0;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_GPU_BUFFER_ARENA_H_
@@ -0,0 +1,60 @@
+#ifndef TANGO_AUGMENTED_REALITY_ORGANIZED_POINT_CLOUD_H_
+#define TANGO_AUGMENTED_REALITY_ORGANIZED_POINT_CLOUD_H_
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <tango_client_api.h>  // NOLINT
+
+namespace tango_augmented_reality {
+
+    // OrganizedPointCloud sorts a depth frame into the pixel grid of the depth
+    // camera, so neighbours are found by their pixel instead of a k-NN search.
+    class OrganizedPointCloud {
+    public:
+        OrganizedPointCloud();
+
+        // Projects the points of a depth frame into the grid, the nearest point
+        // of each cell is kept.
+        //
+        // @param xyz_ij: depth frame in camera coordinates.
+        // @param intrinsics: intrinsics of the depth camera.
+        // @param downscale: camera pixels per cell in each direction.
+        void Update(const TangoXYZij &xyz_ij, const TangoCameraIntrinsics &intrinsics,
+                    int downscale);
+
+        // Marks the cells which lie on a smooth surface. A cell is smooth if the
+        // nearest point in each of the four grid directions is at most radius
+        // cells away and no depth jump lies between them.
+        //
+        // @param radius: search radius in cells.
+        void ComputeSmoothMask(int radius);
+
+        int GetWidth() const { return width_; }
+
+        int GetHeight() const { return height_; }
+
+        // @return: true if the cell holds a point.
+        bool HasPoint(int index) const { return (flags_[index] & kHasPoint) != 0; }
+
+        // @return: true if the cell holds a point on a smooth surface.
+        bool IsSmooth(int index) const { return (flags_[index] & kIsSmooth) != 0; }
+
+        const glm::vec3 &GetPoint(int index) const { return points_[index]; }
+
+    private:
+        static const uint8_t kHasPoint = 1;
+        static const uint8_t kIsSmooth = 2;
+
+        // true if the nearest point from the cell in steps of (dx, dy) is at most
+        // radius cells away and continues the surface of the cell
+        bool HasSmoothNeighbour(int x, int y, int dx, int dy, int radius) const;
+
+        int width_ = 0;
+        int height_ = 0;
+        std::vector <glm::vec3> points_;
+        std::vector <uint8_t> flags_;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_ORGANIZED_POINT_CLOUD_H_
@@ -0,0 +1,75 @@
+#ifndef TANGO_AUGMENTED_REALITY_PLANE_EXTRACTOR_H_
+#define TANGO_AUGMENTED_REALITY_PLANE_EXTRACTOR_H_
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "tango-augmented-reality/organized_point_cloud.h"
+
+namespace tango_augmented_reality {
+
+    // First and second order moments of a point set, planes are fitted to them
+    // without touching the points again.
+    class PlaneMoments {
+    public:
+        void Add(const glm::vec3 &point);
+
+        void Merge(const PlaneMoments &other);
+
+        // Fits a plane with the least squares of the point distances.
+        //
+        // @param normal: receives the unit normal.
+        // @param distance: receives the distance in dot(normal, p) = distance.
+        // @param mse: receives the mean squared point distance to the plane.
+        // @return: false if there are less than three points.
+        bool Fit(glm::vec3 *normal, float *distance, float *mse) const;
+
+        int GetCount() const { return count_; }
+
+        glm::vec3 GetMean() const;
+
+    private:
+        double sum_[3] = {0.0, 0.0, 0.0};
+        // xx, xy, xz, yy, yz, zz
+        double sum_sq_[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+        int count_ = 0;
+    };
+
+    // plane found in one depth frame, in camera coordinates
+    struct DetectedPlane {
+        // unit normal pointing to the camera
+        glm::vec3 normal;
+        float distance;
+        std::vector <glm::vec3> points;
+    };
+
+    // PlaneExtractor finds the planes of an organized depth frame. The grid is
+    // split into blocks, a plane is fitted to every block and blocks with a small
+    // fitting error are merged with their neighbours as long as the merged plane
+    // still fits. The cost is linear in the cells of the grid.
+    class PlaneExtractor {
+    public:
+        // Extracts the planes of a frame.
+        //
+        // @param cloud: organized depth frame.
+        // @param planes: receives the planes, largest first.
+        void Extract(const OrganizedPointCloud &cloud, std::vector <DetectedPlane> &planes);
+
+    private:
+        struct Block {
+            PlaneMoments moments;
+            glm::vec3 normal;
+            float distance;
+            float mse;
+            bool planar;
+        };
+
+        // union find over the blocks
+        int FindRoot(int block);
+
+        std::vector <Block> blocks_;
+        std::vector <int> parents_;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_PLANE_EXTRACTOR_H_
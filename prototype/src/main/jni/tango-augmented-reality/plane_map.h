@@ -0,0 +1,87 @@
+#ifndef TANGO_AUGMENTED_REALITY_PLANE_MAP_H_
+#define TANGO_AUGMENTED_REALITY_PLANE_MAP_H_
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "tango-augmented-reality/plane_extractor.h"
+#include "tango-augmented-reality/reconstructor.h"
+
+namespace tango_augmented_reality {
+
+    // GlobalPlane is one surface of the plane map in world coordinates. The plane
+    // is refitted to the moments of all points it got and meshed as the convex
+    // hull of them.
+    class GlobalPlane {
+    public:
+        // @param points: first points of the surface, in world coordinates.
+        explicit GlobalPlane(const std::vector <glm::vec3> &points);
+
+        // Tests if points of a surface belong to this plane. The surface has to
+        // be coplanar and close to the hull of the plane.
+        bool Matches(const glm::vec3 &normal, const std::vector <glm::vec3> &points) const;
+
+        // adds points of the surface
+        void AddPoints(const std::vector <glm::vec3> &points);
+
+        // takes over the points of another plane of the same surface
+        void Merge(const GlobalPlane &other);
+
+        // gets the mesh of the hull
+        std::vector <glm::vec3> getMesh() const { return mesh_; }
+
+        // gets a counter which changes with every new mesh, unique over all planes
+        int getMeshVersion() const { return mesh_version_; }
+
+    private:
+        // refits the plane to the moments and rebuilds hull and mesh from the old
+        // hull and points
+        void Update(const std::vector <glm::vec3> &points);
+
+        Plane plane_;
+        PlaneMoments moments_;
+        // hull corners in world coordinates
+        std::vector <glm::vec3> hull_;
+        std::vector <glm::vec3> mesh_;
+        int mesh_version_;
+    };
+
+    // PlaneMap collects the planes of all depth frames. A frame plane is merged
+    // into the global planes it matches, so a large surface stays one plane even
+    // if it was seen in parts.
+    class PlaneMap {
+    public:
+        ~PlaneMap();
+
+        // Adds the planes of a frame.
+        //
+        // @param transformation: transposed camera to world transformation.
+        // @param planes: planes of the frame in camera coordinates.
+        void AddPlanes(const glm::mat4 &transformation, const std::vector <DetectedPlane> &planes);
+
+        // Adds a plane in world coordinates.
+        //
+        // @param normal: unit normal of the plane.
+        // @param points: points of the plane, at least three.
+        // @param merged: if given, gets the planes which were merged into the
+        //                returned one, they are deleted already.
+        // @return: the plane which took the points.
+        GlobalPlane *AddPlane(const glm::vec3 &normal, const std::vector <glm::vec3> &points,
+                              std::vector <GlobalPlane *> *merged = nullptr);
+
+        // deletes one plane of the map
+        void RemovePlane(GlobalPlane *plane);
+
+        // gets all planes, the pointers are valid until the next change
+        void GetPlanes(std::vector <GlobalPlane *> &planes) const { planes = planes_; }
+
+        int GetPlaneCount() const { return planes_.size(); }
+
+        void Clear();
+
+    private:
+        std::vector <GlobalPlane *> planes_;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_PLANE_MAP_H_
@@ -3,36 +3,134 @@
 #define TANGO_AUGMENTED_REALITY_PLANE_MESH_H_
 
 #include <tango-gl/drawable_object.h>
+#include <atomic>
 #include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
+#include "tango-augmented-reality/gpu_buffer_arena.h"
+#include "tango-augmented-reality/organized_point_cloud.h"
+#include "tango-augmented-reality/plane_extractor.h"
+#include "tango-augmented-reality/plane_map.h"
 #include "tango-augmented-reality/reconstruction_octree.h"
 
 
 namespace tango_augmented_reality {
+
+    enum PlaneDetection {
+        // RANSAC in every octree leaf
+        PLANE_DETECTION_OCTREE = 0,
+        // region growing on the organized depth frame into a global plane map
+        PLANE_DETECTION_REGION_GROWING = 1
+    };
+
     class PlaneMesh : public tango_gl::DrawableObject {
     public:
         PlaneMesh();
 
         PlaneMesh(GLenum render_mode);
 
+        ~PlaneMesh();
+
         void SetShader();
 
         void Render(const glm::mat4 &projection_mat, const glm::mat4 &view_mat) const;
 
         void addPoints(glm::mat4 transformation, std::vector <float> &vertices);
 
+        // adds the points of an organized cloud. The octree only gets points on
+        // smooth surfaces, the mask of the cloud is computed with smooth_radius
+        // for it. Region growing uses all points.
+        void addPoints(glm::mat4 transformation, OrganizedPointCloud &cloud, int smooth_radius);
+
         void updateVertices();
 
         std::mutex render_mutex;
 
         void clear();
 
+        // renders one mesh per surface merged from the planes of all clusters
+        // instead of the hull of every cluster
+        void setMergeLeafPlanes(bool merge);
+
+        // selects how planes are found in new depth frames
+        void setPlaneDetection(PlaneDetection detection);
+
+        // limits the RANSAC iterations of the configured plane reconstruction
+        void setRansacIterationLimit(int limit);
+
+        // sets the parameters of the plane reconstruction in every octree leaf,
+        // they are applied with the next depth frame
+        void setReconstructorConfig(const ReconstructorConfig &config);
+
+        // sets the vertex format of the mesh buffer, all clusters are uploaded again
+        // with the next update
+        void setVertexFormat(VertexFormat format);
+
     protected:
 
         GLuint uniform_mv_mat_;
 
         ReconstructionOcTree* tree;
 
+        // vertex buffer shared by the meshes of all clusters
+        GpuBufferArena *arena_;
+
+        // arena range of a cluster mesh and the mesh version it holds
+        struct Piece {
+            int handle;
+            int version;
+        };
+        // pieces by their octree cluster or global plane
+        std::unordered_map<const void *, Piece> pieces_;
+        // format of the arena and the one requested for the next update
+        VertexFormat vertex_format_;
+        VertexFormat pending_vertex_format_;
+        PositionQuantizer quantizer_;
+
+        std::atomic <PlaneDetection> plane_detection_;
+        // smooth points of the last organized frame
+        std::vector <float> frame_vertices_;
+        PlaneExtractor extractor_;
+        PlaneMap plane_map_;
+
+        std::atomic<bool> merge_leaf_planes_;
+        // surfaces merged from the cluster planes and the cluster mesh versions
+        // they were built from
+        PlaneMap leaf_planes_;
+        std::unordered_map<const Reconstructor *, int> leaf_versions_;
+        // cluster plane merged into a surface
+        struct LeafPlane {
+            const Reconstructor *leaf;
+            const Plane *plane;
+        };
+        // cluster planes of every surface, to rebuild only the surfaces of changed clusters
+        std::unordered_map<GlobalPlane *, std::vector <LeafPlane> > leaf_plane_sources_;
+
+    private:
+        // config requested by the user and the iteration limit of the quality
+        // controller, both are handed to the octree on the thread reconstructing
+        std::mutex config_mutex_;
+        ReconstructorConfig reconstructor_config_;
+        int ransac_iteration_limit_;
+        bool config_changed_;
+
+        // applies a changed config to the octree before the next reconstruction
+        void ApplyReconstructorConfig();
+
+        // rebuilds the surfaces of leaf_planes_ which hold planes of changed clusters
+        void MergeLeafPlanes(const std::vector <Reconstructor *> &reconstructors);
+
+        // adds a cluster plane to leaf_planes_ and tracks the surface it went to
+        void AddLeafPlane(const Reconstructor *leaf, const Plane *plane);
+
+        // true if the arena holds this version of the mesh
+        bool IsUploaded(const void *key, int version) const;
+
+        // uploads a new mesh version, empty meshes free their piece
+        void UploadPiece(const void *key, int version,
+                         const std::vector <glm::vec3> &reconstruction,
+                         std::vector <GLshort> &quantized);
     };
 
 }  // namespace tango_augmented_reality
@@ -0,0 +1,28 @@
+#ifndef TANGO_AUGMENTED_REALITY_PLY_LOADER_H_
+#define TANGO_AUGMENTED_REALITY_PLY_LOADER_H_
+
+#include <string>
+#include <vector>
+#include <tango-gl/util.h>
+
+namespace tango_augmented_reality {
+
+    // triangle soup with flat normals, ready for SetVertices
+    struct PlyMesh {
+        std::vector <GLfloat> vertices;
+        std::vector <GLfloat> normals;
+    };
+
+    // Loads an ASCII or binary little endian PLY model. The file is mapped into
+    // memory, faces are fanned into triangles with 32 bit indices and get flat
+    // normals. The result is stored next to the model as <path>.cache and loaded
+    // from there as long as the model does not change. Does not touch GL, so it
+    // can run on a worker thread.
+    //
+    // @param path: path of the PLY file.
+    // @param mesh: receives the triangles.
+    // @return: false if the file is missing or can not be parsed.
+    bool LoadPly(const std::string &path, PlyMesh &mesh);
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_PLY_LOADER_H_
@@ -17,11 +17,15 @@
 #ifndef TANGO_POINT_CLOUD_POINT_CLOUD_DRAWABLE_H_
 #define TANGO_POINT_CLOUD_POINT_CLOUD_DRAWABLE_H_
 
+#include <atomic>
 #include <jni.h>
 #include <vector>
 
 #include <tango-gl/util.h>
 
+#include "tango-augmented-reality/streaming_vertex_buffer.h"
+#include "tango-augmented-reality/vertex_format.h"
+
 namespace tango_augmented_reality {
 
 // PointCloudDrawable is responsible for the point cloud rendering.
@@ -32,7 +36,20 @@ namespace tango_augmented_reality {
         // Free all GL Resources, i.e, shaders, buffers.
         void DeleteGlResources();
 
-        // Update current point cloud data.
+        // Upload a new point cloud frame into the streaming buffer. This should be
+        // called once per depth frame, all following Render calls reuse the upload.
+        //
+        // @param vertices: all vertices in this point cloud frame.
+        void UpdateVertices(const std::vector <float> &vertices);
+
+        // Render the last uploaded point cloud frame.
+        //
+        // @param projection_mat: projection matrix from current render camera.
+        // @param view_mat: view matrix from current render camera.
+        // @param model_mat: model matrix for this point cloud frame.
+        void Render(glm::mat4 projection_mat, glm::mat4 view_mat, glm::mat4 model_mat);
+
+        // Update current point cloud data and render it.
         //
         // @param projection_mat: projection matrix from current render camera.
         // @param view_mat: view matrix from current render camera.
@@ -43,9 +60,27 @@ namespace tango_augmented_reality {
 
         void SetVisibility(bool visible);
 
+        // Sets the vertex format of the uploads, it is applied with the next frame.
+        void SetVertexFormat(VertexFormat format);
+
     private:
-        // Vertex buffer of the point cloud geometry.
-        GLuint vertex_buffers_;
+        // Ring buffer of the point cloud geometry.
+        StreamingVertexBuffer *vertex_buffer_;
+
+        // Byte offset of the current frame inside the ring buffer.
+        GLintptr vertex_offset_ = 0;
+
+        // Point count of the current frame.
+        GLsizei vertex_count_ = 0;
+
+        // Format of the current frame and the one used for the next upload.
+        VertexFormat format_ = VERTEX_FORMAT_FLOAT;
+        std::atomic<VertexFormat> pending_format_{VERTEX_FORMAT_FLOAT};
+
+        PositionQuantizer quantizer_;
+
+        // Scratch buffer of quantized points.
+        std::vector <GLshort> quantized_;
 
         // Shader to display point cloud.
         GLuint shader_program_;
@@ -53,7 +88,12 @@ namespace tango_augmented_reality {
         // Handle to vertex attribute value in the shader.
         GLuint vertices_handle_;
 
-        GLboolean vertices_visible_handle_;
+        // Handle to the visibility uniform in the shader.
+        GLint vertices_visible_handle_;
+
+        // Handles to the position decode uniforms in the shader.
+        GLint decode_scale_handle_;
+        GLint decode_offset_handle_;
 
         bool visible = true;
 
@@ -0,0 +1,98 @@
+#ifndef TANGO_AUGMENTED_REALITY_QUALITY_CONTROLLER_H_
+#define TANGO_AUGMENTED_REALITY_QUALITY_CONTROLLER_H_
+
+#include <vector>
+
+namespace tango_augmented_reality {
+
+    // pipeline stages which get timed every frame
+    enum QualityStage {
+        STAGE_CAMERA = 0,           // yuv conversion and upload of the camera image
+        STAGE_RECONSTRUCTION = 1,   // chisel integration or plane reconstruction
+        STAGE_OCCLUSION = 2,        // depth framebuffer pass and blit
+        STAGE_FILTER = 3,           // guided depth filter
+        STAGE_COUNT = 4
+    };
+
+    // quality parameters of the native pipeline
+    struct QualitySettings {
+        // only every n-th camera frame gets rendered
+        int skip_interval;
+        // upper bound of the RANSAC iterations of each plane reconstructor
+        int ransac_iteration_limit;
+        // factor on the user defined guided filter diameter
+        float filter_diameter_scale;
+        // occlusion buffer size relative to the full depth buffer
+        float occlusion_scale;
+    };
+
+    const int kQualityLevelCount = 3;
+
+    // parameter of each stage at every quality level, index 0 is the highest
+    // quality. Only parameters which apply right away are stepped, so every step
+    // shows in the next frame times.
+    struct QualityLevels {
+        int skip_intervals[kQualityLevelCount];
+        int ransac_iteration_limits[kQualityLevelCount];
+        float filter_diameter_scales[kQualityLevelCount];
+        float occlusion_scales[kQualityLevelCount];
+    };
+
+    extern const QualityLevels kQualityLevels;
+
+    // QualityController holds a target frame time by stepping quality parameters.
+    // If the averaged frame time exceeds the target, the parameter of the most
+    // expensive stage is lowered. With enough headroom the last lowered parameter is
+    // raised again. Every step waits some frames to settle, which gives hysteresis.
+    // A raise which is undone right away makes the next raise wait longer.
+    // The controller only works on timings, so it can be driven without a device.
+    class QualityController {
+    public:
+        // @param target_frame_ms: frame time the controller tries to hold.
+        QualityController(float target_frame_ms);
+
+        // Feeds the timings of the last frame.
+        //
+        // @param stage_ms: time of each QualityStage in milliseconds.
+        // @param frame_ms: time of the whole frame in milliseconds.
+        // @return: true if the settings changed.
+        bool Update(const float stage_ms[STAGE_COUNT], float frame_ms);
+
+        const QualitySettings &GetSettings() const { return settings_; }
+
+        // @return: quality level of the stage, 0 is the highest quality.
+        int GetLevel(QualityStage stage) const { return levels_[stage]; }
+
+        void SetTargetFrameTime(float target_frame_ms) { target_frame_ms_ = target_frame_ms; }
+
+        // resets to the highest quality
+        void Reset();
+
+    private:
+        // applies the current level of each stage to settings_
+        void ApplyLevels();
+
+        float target_frame_ms_;
+
+        // moving averages of the frame and the stage times
+        float average_frame_ms_ = 0.0f;
+        float average_stage_ms_[STAGE_COUNT];
+
+        // quality level of each stage, 0 is the highest quality
+        int levels_[STAGE_COUNT];
+
+        // stages in the order they got lowered, raising undoes the last one
+        std::vector<int> lowered_stages_;
+
+        // frames since the last change
+        int settle_frames_ = 0;
+
+        // frames to wait before raising, grows while raises get undone
+        int raise_settle_frames_;
+        bool last_change_raised_;
+
+        QualitySettings settings_;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_QUALITY_CONTROLLER_H_
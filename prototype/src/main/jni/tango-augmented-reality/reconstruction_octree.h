@@ -32,12 +32,20 @@ namespace tango_augmented_reality {
         // collects the reconstructed mesg from each cluster
         std::vector <glm::vec3> getMesh();
 
+        // collects the reconstructors of all filled clusters
+        void getReconstructors(std::vector <Reconstructor *> &reconstructors);
+
         // instance of a reconstructor for mesh generation
         Reconstructor *reconstructor;
 
         // removes the current plane reconstruction
         void clear();
 
+        // sets the parameters of all reconstructors in the tree
+        void setConfig(const ReconstructorConfig &config);
+
+        const ReconstructorConfig &getConfig() const { return config_; }
+
     private:
         // size of a cubic node
         float range_;
@@ -53,6 +61,8 @@ namespace tango_augmented_reality {
         ReconstructionOcTree **children_;
         // boolean flag if the points got updated
         bool updated;
+        // parameters handed to new reconstructors
+        ReconstructorConfig config_;
 
         // get Octree child index of a given point
         int getChildIndex(glm::vec3 point);
@@ -5,6 +5,8 @@
 #include <tango-gl/util.h>
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
+#include <array>
+#include <utility>
 #include <vector>
 #include <Eigen/Core>
 #include <Eigen/Eigenvalues>
@@ -14,10 +16,25 @@
 #ifndef MASTERPROTOTYPE_RECONSTRUCTOR_H
 #define MASTERPROTOTYPE_RECONSTRUCTOR_H
 
-#define RANSAC_DETECT_PLANES 2
-
 namespace tango_augmented_reality {
 
+    // upper bound of planes per cluster, sizes the plane storage of a reconstructor
+    const int kMaxReconstructorPlanes = 4;
+
+    // tunable parameters of the cluster reconstruction
+    struct ReconstructorConfig {
+        // how many planes per cluster getting detected, 1 to kMaxReconstructorPlanes
+        int max_planes = 2;
+        // how many random samples RANSAC tests per plane
+        int ransac_iterations = 12;
+        // threshold between plane and point to count a point as supporting
+        float ransac_threshold = 0.12f;
+        // amount of points, which should support the plane model to be sufficient
+        float ransac_sufficient_support = 0.33f;
+        // scale factor of the hull around its centroid to solve the gap problem
+        float hull_scale = 1.01f;
+    };
+
     class Plane {
     public:
         // plane normal (hesse normal form)
@@ -27,8 +44,10 @@ namespace tango_augmented_reality {
 
         // variables for the projection calculation
         glm::vec3 plane_origin;
-        glm::quat plane_z_rotation;
-        glm::quat inverse_plane_z_rotation;
+        // rows are the two in-plane axes, maps 3d offsets to plane coordinates
+        glm::mat3x2 plane_basis;
+        // columns are the two in-plane axes, maps plane coordinates back to 3d
+        glm::mat2x3 inverse_plane_basis;
 
         // current 3d convex hull of plane
         std::vector <glm::vec3> points;
@@ -41,13 +60,26 @@ namespace tango_augmented_reality {
             normal = plane.normal;
             distance = plane.distance;
             plane_origin = plane.plane_origin;
-            plane_z_rotation = plane.plane_z_rotation;
-            inverse_plane_z_rotation = plane.inverse_plane_z_rotation;
+            plane_basis = plane.plane_basis;
+            inverse_plane_basis = plane.inverse_plane_basis;
             points = plane.points;
+            return *this;
         };
 
         // calculates the distance between a point and this plane
-        float distanceTo(glm::vec3 point);
+        float distanceTo(const glm::vec3 &point) const {
+            return glm::dot(normal, point) - distance;
+        }
+
+        // projects a point onto the plane
+        glm::vec2 project(const glm::vec3 &point) const {
+            return plane_basis * (point - plane_origin);
+        }
+
+        // projects a point back from the plane
+        glm::vec3 unproject(const glm::vec2 &point) const {
+            return inverse_plane_basis * point + plane_origin;
+        }
 
         // computes the plane model from three points
         static Plane calculatePlane(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2);
@@ -61,6 +93,12 @@ namespace tango_augmented_reality {
         // gets the reconstructed mesh
         std::vector <glm::vec3> getMesh() { return mesh_; }
 
+        // gets a counter which changes with every new mesh
+        int getMeshVersion() { return mesh_version_; }
+
+        // gets the planes detected in this cluster, their points are the hull
+        void getPlanes(std::vector <const Plane *> &result) const;
+
         // gets the count of available points
         int getPointCount();
 
@@ -76,24 +114,40 @@ namespace tango_augmented_reality {
         // resets the reconstructor
         void reset();
 
+        // sets the parameters of the following reconstructions, points of planes
+        // beyond the new plane count return to the main point pool
+        //
+        // @return: true if planes got disabled, their triangles are removed from
+        //          the mesh and the mesh version changes.
+        bool setConfig(const ReconstructorConfig &config);
+
+        const ReconstructorConfig &getConfig() const { return config_; }
+
         Reconstructor();
 
 
     private:
         // the resulting mesh
         std::vector <glm::vec3> mesh_;
+        // incremented whenever mesh_ is rebuilt or cleared
+        int mesh_version_ = 0;
+        // begin and end in mesh_ of the triangles of each plane
+        std::array<std::pair<int, int>, kMaxReconstructorPlanes> mesh_ranges_;
 
         // uses RANSAC to detect a plane model
         Plane detectPlane(std::vector <glm::vec3> &points);
 
         // project points onto the plane
-        std::vector <glm::vec2> project(Plane plane, std::vector <glm::vec3> &points);
+        std::vector <glm::vec2> project(const Plane &plane, const std::vector <glm::vec3> &points);
 
         // project points back from the plane
-        std::vector <glm::vec3> project(Plane plane, std::vector <glm::vec2> &points);
+        std::vector <glm::vec3> project(const Plane &plane, const std::vector <glm::vec2> &points);
 
-        // computes the support of the plane against points with ransac_threshold
-        int ransacEstimateSupportingPoints(Plane plane, std::vector <glm::vec3> &points);
+        // counts the points within ransac_threshold of the plane
+        int ransacEstimateSupport(const Plane &plane, const std::vector <glm::vec3> &points);
+
+        // splits points into the best supporting and not supporting points of the plane
+        void ransacSplitPoints(const Plane &plane, const std::vector <glm::vec3> &points);
 
         // computes the support of the plane against points with ransac_threshold
         int *ransacPickThreeRandomPoints(std::vector < glm::vec3 > &points);
@@ -104,31 +158,33 @@ namespace tango_augmented_reality {
         // scales given points around calculated centroid
         void scaleAroundCentroid(float scale, std::vector <glm::vec3> &points);
 
-        // how many random samples we're going to test
-        int ransac_iterations = 12;
-        // threshold between plane and point to count a point as supporting
-        float ransac_threshold = 0.12;
-        // amount of points, which should support the plane model to be sufficient
-        float ransac_sufficient_support = 0.33;
-        // how many planes per cluster getting detected
-        const int ransac_detect_planes = RANSAC_DETECT_PLANES;
-        // scale factor to solve the gap problem
-        float ransac_scale_planes = 0.1;
-        // supporting points of ransac estimation
-        std::vector <glm::vec3> ransac_supporting_points;
-        // not supporting points of ransac estimation
-        std::vector <glm::vec3> ransac_not_supporting_points;
+        // finds the closest available plane within ransac_threshold, -1 if there is
+        // none. The plane count is a template argument so the loop unrolls.
+        template <int PlaneCount>
+        int findClosestPlane(const glm::vec3 &point) const {
+            int closest_index = -1;
+            float closest_distance = config_.ransac_threshold;
+            for (int i = 0; i < PlaneCount; ++i) {
+                float current_distance = planes[i].distanceTo(point);
+                bool closer = plane_available[i] && current_distance < closest_distance;
+                closest_distance = closer ? current_distance : closest_distance;
+                closest_index = closer ? i : closest_index;
+            }
+            return closest_index;
+        }
+
+        ReconstructorConfig config_;
         // supporting points of best ransac estimation
         std::vector <glm::vec3> ransac_best_supporting_points;
         // not supporting points of best ransac estimation
         std::vector <glm::vec3> ransac_best_not_supporting_points;
         // planes per cluster
-        std::array<Plane, RANSAC_DETECT_PLANES> planes;
+        std::array<Plane, kMaxReconstructorPlanes> planes;
         // available planes
-        std::array<bool, RANSAC_DETECT_PLANES> plane_available;
+        std::array<bool, kMaxReconstructorPlanes> plane_available;
 
     };
 
 }
 
-#endif
\ No newline at end of file
+#endif
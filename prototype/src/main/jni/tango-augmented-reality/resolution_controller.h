@@ -0,0 +1,47 @@
+#ifndef TANGO_AUGMENTED_REALITY_RESOLUTION_CONTROLLER_H_
+#define TANGO_AUGMENTED_REALITY_RESOLUTION_CONTROLLER_H_
+
+namespace tango_augmented_reality {
+
+    // ResolutionController picks the occlusion buffer scale from measured frame times.
+    // It steps the scale down if the averaged frame time exceeds the budget and back
+    // up if there is enough headroom, each step needs some frames to settle.
+    class ResolutionController {
+    public:
+        // @param frame_budget_ms: frame time the controller tries to hold.
+        ResolutionController(float frame_budget_ms);
+
+        // Feeds the duration of the last frame.
+        //
+        // @param frame_time_ms: render time of the last frame in milliseconds.
+        // @return: true if the scale changed.
+        bool Update(float frame_time_ms);
+
+        // @return: current scale of the occlusion buffer, 1.0 is full resolution.
+        float GetScale() const;
+
+        void SetFrameBudget(float frame_budget_ms) { frame_budget_ms_ = frame_budget_ms; }
+
+        // Limits the scale, lower scales can still be picked. The quality
+        // controller sets it, so both never pick the scale on their own.
+        //
+        // @param scale: highest scale of the occlusion buffer.
+        void SetMaxScale(float scale);
+
+        // resets to the highest allowed resolution
+        void Reset();
+
+    private:
+        float frame_budget_ms_;
+        // exponential moving average of the frame time
+        float average_frame_time_ms_ = 0.0f;
+        // frames since the last scale change
+        int settle_frames_ = 0;
+        // index into the scale levels
+        int level_ = 0;
+        // index of the highest allowed scale
+        int min_level_ = 0;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_RESOLUTION_CONTROLLER_H_
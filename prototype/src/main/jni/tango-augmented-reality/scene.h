@@ -36,7 +36,13 @@
 #include <tango-augmented-reality/depth_drawable.h>
 #include <tango-augmented-reality/chisel_mesh.h>
 #include <tango-augmented-reality/plane_mesh.h>
+#include <tango-augmented-reality/organized_point_cloud.h>
 #include <tango-augmented-reality/ar_object.h>
+#include <tango-augmented-reality/depth_readback.h>
+#include <tango-augmented-reality/depth_filter.h>
+#include <tango-augmented-reality/resolution_controller.h>
+#include <tango-augmented-reality/shader_cache.h>
+#include <tango-augmented-reality/quality_controller.h>
 #include <tango_support_api.h>
 
 #include <opencv2/core/core.hpp>
@@ -160,6 +166,43 @@ namespace tango_augmented_reality {
 
         void SetDepthFullscreen(bool show) { depth_fullscreen = show; }
 
+        // Render the reconstruction only once into the depth framebuffer and reuse it for
+        // the occlusion view, instead of drawing it into the default framebuffer as well.
+        // The geometry is then only seen through the framebuffer color, which has the
+        // occlusion resolution and looks blurrier below full scale. Off by default.
+        void SetSinglePassOcclusion(bool single_pass) { single_pass_occlusion = single_pass; }
+
+        // Let the occlusion buffer resolution follow the frame time.
+        void SetDynamicResolution(bool dynamic);
+
+        // Select the plane detection of the plane mode, see PlaneDetection.
+        void SetPlaneDetection(int detection);
+
+        // Set the parameters of the plane reconstruction in the octree leaves. The
+        // RANSAC iterations are overridden by the quality controller while it runs.
+        void SetReconstructorConfig(const ReconstructorConfig &config);
+
+        // Render one mesh per surface merged from the planes of all octree leaves.
+        void SetMergeLeafPlanes(bool merge);
+
+        // Upload reconstruction meshes, point clouds and the AR object with quantized
+        // 16 bit positions instead of floats.
+        void SetVertexCompression(bool compressed);
+
+        // Set the occlusion buffer resolution relative to the full depth buffer size.
+        // @param: scale, 1.0 is full resolution.
+        void SetOcclusionResolution(float scale);
+
+        // Get the stage timings of the last rendered frame, each frame is only
+        // reported once.
+        // @param: stage_ms, receives the time of each QualityStage in milliseconds.
+        // @param: frame_ms, receives the time of the whole frame in milliseconds.
+        // @return: false if no frame was rendered since the last call.
+        bool GetFrameTimings(float stage_ms[STAGE_COUNT], float *frame_ms);
+
+        // Apply the scene related parameters of the quality controller.
+        void SetQualitySettings(const QualitySettings &settings);
+
         ARMode GetMode() { return mode; }
 
         void SetDepthIntrinsics(TangoCameraIntrinsics depth_intrinsics_);
@@ -174,11 +217,21 @@ namespace tango_augmented_reality {
         void joyStick(double angle, double power);
 
     private:
+        // Render the current reconstruction or pointcloud, depending on mode.
+        void RenderReconstruction();
+
+        // Reallocate all buffers which depend on the occlusion resolution.
+        void ResizeOcclusionBuffers(size_t width, size_t height);
+
         // Video overlay drawable object to display the camera image.
         YUVDrawable *yuv_drawable_;
 
         DepthDrawable *depth_drawable_;
 
+        // Overlay of the depth framebuffer color attachment, shows the occlusion
+        // geometry in single pass mode.
+        DepthDrawable *occlusion_drawable_;
+
         // Camera object that allows user to use touch input to interact with.
         tango_gl::GestureCamera *gesture_camera_;
 
@@ -217,8 +270,30 @@ namespace tango_augmented_reality {
 
         glm::mat4 point_cloud_transformation;
 
+        // full resolution of the occlusion buffer
+        size_t max_depth_width_;
+        size_t max_depth_height_;
+
+        // current resolution of the occlusion buffer
         size_t depth_width_;
         size_t depth_height_;
+        float occlusion_scale_ = 1.0f;
+
+        // scale given by the quality controller, upper bound of resolution_controller_
+        float quality_occlusion_scale_ = 1.0f;
+
+        // adapts occlusion_scale_ to the frame time if dynamic_resolution is set
+        ResolutionController resolution_controller_;
+        bool dynamic_resolution = false;
+        std::atomic <bool> reset_resolution_;
+
+        // factor on the filter diameter given by the quality controller
+        float filter_diameter_scale_ = 1.0f;
+
+        // timings of the last frame
+        float stage_ms_[STAGE_COUNT] = {0.0f, 0.0f, 0.0f, 0.0f};
+        float frame_ms_ = 0.0f;
+        bool frame_timed_ = false;
 
         GLenum gl_depth_format_;
         int cv_depth_format_;
@@ -239,8 +314,17 @@ namespace tango_augmented_reality {
         std::mutex yuv_buffer_mutex_;
 
         cv::Mat rgb_frame;
+        // rgb_frame at the occlusion resolution, the guide of the depth filter
+        cv::Mat scaled_rgb_frame;
         cv::Mat depth_frame;
+        cv::Mat filtered_depth_frame;
+
+        // asynchronous depth readback and filtering for do_filtering
+        DepthReadback *depth_readback_;
+        DepthFilter *depth_filter_;
         std::vector <float> vertices;
+        // true if vertices got a new depth frame, which is not uploaded yet
+        bool vertices_updated_ = false;
 
         std::mutex depth_mutex_;
 
@@ -250,6 +334,8 @@ namespace tango_augmented_reality {
         TangoCameraIntrinsics depth_intrinsics;
 
         TangoXYZij XYZij;
+        // XYZij sorted into the depth camera grid
+        OrganizedPointCloud organized_cloud_;
 
         int diameter = 5;
         double sigma = 2.5;
@@ -257,6 +343,7 @@ namespace tango_augmented_reality {
         bool do_filtering = false;
         bool show_occlusion = false;
         bool depth_fullscreen = false;
+        bool single_pass_occlusion = false;
         ARMode mode = POINTCLOUD;
 
         double last_depth_timestamp = 0;
@@ -0,0 +1,54 @@
+#ifndef TANGO_AUGMENTED_REALITY_SHADER_CACHE_H_
+#define TANGO_AUGMENTED_REALITY_SHADER_CACHE_H_
+
+#include <GLES3/gl3.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tango-gl/util.h>
+
+namespace tango_augmented_reality {
+
+    // ShaderCache hands out linked GL programs for pairs of shader sources. Every pair
+    // is built once per GL context and shared by all drawables using it, so drawables
+    // must not delete the returned programs. Linked programs are stored as driver
+    // binaries in the cache directory and loaded from there on the next context,
+    // instead of compiling the sources again.
+    class ShaderCache {
+    public:
+        // Sets the directory for program binaries, without one nothing is stored.
+        static void SetDirectory(const std::string &directory);
+
+        // Gets the program for the given sources, it is loaded from a stored binary,
+        // or compiled and linked if there is no matching one.
+        //
+        // @return: the program or 0 if it could not be built.
+        static GLuint GetProgram(const std::string &vertex_source,
+                                 const std::string &fragment_source);
+
+        // Forgets all programs of a lost GL context without touching GL.
+        static void Invalidate();
+
+        // Deletes all programs of the current GL context.
+        static void DeletePrograms();
+
+    private:
+        // file of the program binary for the given sources
+        static std::string GetBinaryPath(unsigned long long source_hash);
+
+        static GLuint LoadBinary(unsigned long long source_hash);
+
+        static void StoreBinary(unsigned long long source_hash, GLuint program);
+
+        // hash of vendor, renderer and version of the current driver
+        static unsigned long long GetDriverHash();
+
+        static std::mutex mutex_;
+        static std::string directory_;
+        // programs of the current context by their sources
+        static std::map<std::string, GLuint> programs_;
+        static unsigned long long driver_hash_;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_SHADER_CACHE_H_
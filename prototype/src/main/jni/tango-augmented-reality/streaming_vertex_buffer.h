@@ -0,0 +1,44 @@
+#ifndef TANGO_AUGMENTED_REALITY_STREAMING_VERTEX_BUFFER_H_
+#define TANGO_AUGMENTED_REALITY_STREAMING_VERTEX_BUFFER_H_
+
+#include <GLES3/gl3.h>
+#include <tango-gl/util.h>
+
+namespace tango_augmented_reality {
+
+    // StreamingVertexBuffer is a ring buffer VBO for data which changes every few
+    // frames (e.g. depth point clouds). Each upload is written into a fresh range
+    // of the buffer with unsynchronized writes, when the ring wraps around the whole
+    // storage gets orphaned so the driver never has to wait for pending draws.
+    class StreamingVertexBuffer {
+    public:
+        // @param capacity: initial size of the ring in bytes.
+        StreamingVertexBuffer(GLsizeiptr capacity);
+
+        ~StreamingVertexBuffer();
+
+        // Writes data into the next free range of the ring.
+        //
+        // @param data: pointer to the data to upload.
+        // @param size: size of the data in bytes.
+        // @return: byte offset of the written range inside the buffer.
+        GLintptr Upload(const void *data, GLsizeiptr size);
+
+        GLuint GetBufferId() const { return buffer_; }
+
+        // Free the GL buffer.
+        void DeleteGlResources();
+
+    private:
+        // reallocates the buffer storage, which also orphans the old one
+        void Orphan();
+
+        GLuint buffer_ = 0;
+        // size of the ring in bytes
+        GLsizeiptr capacity_;
+        // byte offset of the next free range
+        GLintptr head_ = 0;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_STREAMING_VERTEX_BUFFER_H_
@@ -0,0 +1,65 @@
+#ifndef TANGO_AUGMENTED_REALITY_VERTEX_FORMAT_H_
+#define TANGO_AUGMENTED_REALITY_VERTEX_FORMAT_H_
+
+#include <vector>
+#include <tango-gl/util.h>
+
+namespace tango_augmented_reality {
+
+    // Layout of the vertex positions in the reconstruction and point cloud buffers.
+    enum VertexFormat {
+        // three 32 bit floats per position
+        VERTEX_FORMAT_FLOAT,
+        // four normalized 16 bit integers per position, relative to a quantization cube
+        VERTEX_FORMAT_SHORT
+    };
+
+    // half edge length of the cube around the origin reconstructions are quantized in,
+    // it covers the plane octree
+    const float kReconstructionHalfRange = 20.0f;
+
+    // @return: size of one position in the given format in bytes.
+    GLsizei GetVertexStride(VertexFormat format);
+
+    // Sets the vertex attribute pointer for positions in the given format.
+    //
+    // @param attrib: vertex attribute of the bound program.
+    // @param offset: byte offset of the first position in the bound buffer.
+    void SetVertexAttribPointer(VertexFormat format, GLuint attrib, GLintptr offset);
+
+    // PositionQuantizer maps positions inside an axis aligned cube to normalized
+    // 16 bit integers. The GPU turns them back into [-1, 1] and the decode matrix
+    // scales them into the cube again, so the shader only needs one more transform.
+    class PositionQuantizer {
+    public:
+        // @param center: center of the cube.
+        // @param half_range: half the edge length of the cube.
+        PositionQuantizer(glm::vec3 center, float half_range);
+
+        // Brings positions into the given format.
+        //
+        // @param positions: xyz float positions.
+        // @param count: number of positions.
+        // @param scratch: receives the quantized positions.
+        // @return: pointer to the positions in the requested format.
+        const void *Encode(VertexFormat format, const GLfloat *positions, size_t count,
+                           std::vector <GLshort> &scratch) const;
+
+        // @return: matrix which maps decoded positions back into the cube, identity
+        // for float positions.
+        glm::mat4 GetDecodeMatrix(VertexFormat format) const;
+
+    private:
+        glm::vec3 center_;
+        float half_range_;
+    };
+
+    // Encodes a unit normal into two normalized 16 bit integers with the octahedral
+    // mapping.
+    void OctEncodeNormal(const glm::vec3 &normal, GLshort *encoded);
+
+    // GLSL function vec3 octDecodeNormal(vec2) which reverses OctEncodeNormal.
+    extern const char *kOctDecodeNormalShader;
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_VERTEX_FORMAT_H_
@@ -0,0 +1,92 @@
+#include "tango-augmented-reality/vertex_format.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const float kShortMax = 32767.0f;
+
+    GLshort toShort(float value) {
+        value = std::max(-1.0f, std::min(1.0f, value));
+        return static_cast<GLshort>(std::floor(value * kShortMax + 0.5f));
+    }
+
+    float signNotZero(float value) {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    const char *kOctDecodeNormalShader =
+            "vec3 octDecodeNormal(vec2 e) {\n"
+                    "  vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));\n"
+                    "  if (n.z < 0.0) {\n"
+                    "    n.xy = (1.0 - abs(n.yx)) *\n"
+                    "        vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);\n"
+                    "  }\n"
+                    "  return normalize(n);\n"
+                    "}\n";
+
+    GLsizei GetVertexStride(VertexFormat format) {
+        if (format == VERTEX_FORMAT_SHORT) {
+            return 4 * sizeof(GLshort);
+        }
+        return 3 * sizeof(GLfloat);
+    }
+
+    void SetVertexAttribPointer(VertexFormat format, GLuint attrib, GLintptr offset) {
+        if (format == VERTEX_FORMAT_SHORT) {
+            glVertexAttribPointer(attrib, 4, GL_SHORT, GL_TRUE, GetVertexStride(format),
+                                  reinterpret_cast<const GLvoid *>(offset));
+        } else {
+            glVertexAttribPointer(attrib, 3, GL_FLOAT, GL_FALSE, GetVertexStride(format),
+                                  reinterpret_cast<const GLvoid *>(offset));
+        }
+    }
+
+    PositionQuantizer::PositionQuantizer(glm::vec3 center, float half_range) :
+            center_(center),
+            half_range_(half_range) { }
+
+    const void *PositionQuantizer::Encode(VertexFormat format, const GLfloat *positions,
+                                          size_t count, std::vector <GLshort> &scratch) const {
+        if (format == VERTEX_FORMAT_FLOAT) {
+            return positions;
+        }
+        scratch.resize(count * 4);
+        float inverse_range = 1.0f / half_range_;
+        for (size_t i = 0; i < count; ++i) {
+            scratch[i * 4] = toShort((positions[i * 3] - center_.x) * inverse_range);
+            scratch[i * 4 + 1] = toShort((positions[i * 3 + 1] - center_.y) * inverse_range);
+            scratch[i * 4 + 2] = toShort((positions[i * 3 + 2] - center_.z) * inverse_range);
+            // decodes to w = 1
+            scratch[i * 4 + 3] = static_cast<GLshort>(kShortMax);
+        }
+        return scratch.data();
+    }
+
+    glm::mat4 PositionQuantizer::GetDecodeMatrix(VertexFormat format) const {
+        if (format == VERTEX_FORMAT_FLOAT) {
+            return glm::mat4(1.0f);
+        }
+        glm::mat4 decode(half_range_);
+        decode[3] = glm::vec4(center_, 1.0f);
+        return decode;
+    }
+
+    void OctEncodeNormal(const glm::vec3 &normal, GLshort *encoded) {
+        float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+        float x = normal.x / length;
+        float y = normal.y / length;
+        if (normal.z < 0.0f) {
+            float folded_x = (1.0f - std::abs(y)) * signNotZero(x);
+            float folded_y = (1.0f - std::abs(x)) * signNotZero(y);
+            x = folded_x;
+            y = folded_y;
+        }
+        encoded[0] = toShort(x);
+        encoded[1] = toShort(y);
+    }
+
+}  // namespace tango_augmented_reality
@@ -15,6 +15,7 @@
  */
 
 #include "tango-augmented-reality/yuv_drawable.h"
+#include "tango-augmented-reality/shader_cache.h"
 
 namespace {
     const GLfloat kVertices[] = { -1.0, -1.0, 0.0,-1.0, 1.0, 0.0,
@@ -50,8 +51,7 @@ namespace tango_augmented_reality {
 
     YUVDrawable::YUVDrawable() {
         glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
-        shader_program_ = tango_gl::util::CreateProgram(kVertexShader.c_str(),
-                                                        kFragmetnShader.c_str());
+        shader_program_ = ShaderCache::GetProgram(kVertexShader, kFragmetnShader);
         if (!shader_program_) {
             LOGE("Could not create program.");
         }
@@ -0,0 +1,111 @@
+// Runs the depth filter kernel on a synthetic depth frame: two noisy planes
+// which meet at a vertical edge, guided by a color frame with the same edge.
+
+#include "tango-augmented-reality/depth_filter.h"
+
+#include <chrono>
+#include <cstdlib>
+
+#include "test_util.h"
+
+namespace {
+    const int kWidth = 64;
+    const int kHeight = 48;
+    const int kEdge = kWidth / 2;
+
+    const int kNearDepth = 16384;
+    const int kFarDepth = 40960;
+    const int kNoise = 2048;
+
+    // scene.cc defaults
+    const int kDiameter = 5;
+    const double kSigma = 2.5;
+
+    int PlaneDepth(int x) {
+        return x < kEdge ? kNearDepth : kFarDepth;
+    }
+
+    void CreateFrames(cv::Mat &depth, cv::Mat &rgb) {
+        depth = cv::Mat(kHeight, kWidth, CV_16UC1);
+        rgb = cv::Mat(kHeight, kWidth, CV_8UC3);
+        srand(42);
+        for (int y = 0; y < kHeight; ++y) {
+            for (int x = 0; x < kWidth; ++x) {
+                int noise = rand() % (2 * kNoise + 1) - kNoise;
+                depth.at<unsigned short>(y, x) = static_cast<unsigned short>(PlaneDepth(x) + noise);
+                unsigned char gray = x < kEdge ? 40 : 200;
+                rgb.at<cv::Vec3b>(y, x) = cv::Vec3b(gray, gray, gray);
+            }
+        }
+    }
+
+    // mean absolute distance to the plane depth, away from the edge and the border
+    double PlaneError(const cv::Mat &depth) {
+        double error = 0.0;
+        int count = 0;
+        for (int y = kDiameter; y < kHeight - kDiameter; ++y) {
+            for (int x = kDiameter; x < kWidth - kDiameter; ++x) {
+                if (std::abs(x - kEdge) <= kDiameter) {
+                    continue;
+                }
+                error += std::abs(depth.at<unsigned short>(y, x) - PlaneDepth(x));
+                count++;
+            }
+        }
+        return error / count;
+    }
+
+    void TestFilterKernel() {
+        cv::Mat depth, rgb, filtered;
+        CreateFrames(depth, rgb);
+        tango_augmented_reality::DepthFilter::Filter(depth, rgb, kDiameter, kSigma, filtered);
+
+        CHECK(filtered.type() == CV_16UC1);
+        CHECK(filtered.cols == kWidth && filtered.rows == kHeight);
+
+        // noise on the planes gets smoothed
+        CHECK(PlaneError(filtered) < PlaneError(depth) * 0.5);
+
+        // the edge of the guide keeps the planes apart, pixels next to it stay on their plane
+        int tolerance = (kFarDepth - kNearDepth) / 8;
+        for (int y = 0; y < kHeight; ++y) {
+            CHECK(std::abs(filtered.at<unsigned short>(y, kEdge - 1) - kNearDepth) < tolerance);
+            CHECK(std::abs(filtered.at<unsigned short>(y, kEdge) - kFarDepth) < tolerance);
+        }
+    }
+
+    void TestWorkerResult() {
+        cv::Mat depth, rgb, expected, result;
+        CreateFrames(depth, rgb);
+        tango_augmented_reality::DepthFilter::Filter(depth, rgb, kDiameter, kSigma, expected);
+
+        tango_augmented_reality::DepthFilter filter;
+        CHECK(!filter.TakeResult(result));
+        filter.Submit(depth, rgb, kDiameter, kSigma);
+
+        bool has_result = false;
+        std::chrono::steady_clock::time_point timeout =
+                std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!has_result && std::chrono::steady_clock::now() < timeout) {
+            has_result = filter.TakeResult(result);
+        }
+        CHECK(has_result);
+        if (has_result) {
+            CHECK(cv::countNonZero(result != expected) == 0);
+        }
+
+        // a result is only handed out once, the caller keeps it
+        cv::Mat kept = result;
+        CHECK(!filter.TakeResult(result));
+        CHECK(result.data == kept.data);
+    }
+}  // namespace
+
+int main() {
+    TestFilterKernel();
+    TestWorkerResult();
+    if (test_failures == 0) {
+        fprintf(stderr, "depth_filter_test passed\n");
+    }
+    return test_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
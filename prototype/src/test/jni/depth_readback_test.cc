@@ -0,0 +1,252 @@
+// Renders depth frames into a framebuffer like the scene and reads them with the
+// DepthReadback in an offscreen EGL context. Every map has to give the frame
+// before the last read and a failed map has to keep the target, so the filter
+// goes on with the previous frame. Skipped if no OpenGL ES 3 context can be
+// created.
+
+#include "tango-augmented-reality/depth_readback.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "test_util.h"
+
+using tango_augmented_reality::DepthReadback;
+
+namespace {
+    // ctest reports the test as skipped with this exit code
+    const int kSkipped = 77;
+
+    const int kWidth = 64;
+    const int kHeight = 48;
+
+    // depth of the rest of the frame and of the lower left corner of frame
+    float BackgroundDepth(int frame) { return 0.1f * (frame + 1); }
+
+    float CornerDepth(int frame) { return 0.05f * (frame + 1); }
+
+    // depth texture and color buffer of the occlusion framebuffer of the scene
+    class OffscreenContext {
+    public:
+        OffscreenContext() : display_(EGL_NO_DISPLAY), surface_(EGL_NO_SURFACE),
+                             context_(EGL_NO_CONTEXT), depth_texture_(0), color_buffer_(0),
+                             frame_buffer_(0) {
+        }
+
+        ~OffscreenContext() {
+            if (frame_buffer_) {
+                glDeleteFramebuffers(1, &frame_buffer_);
+                glDeleteRenderbuffers(1, &color_buffer_);
+                glDeleteTextures(1, &depth_texture_);
+            }
+            if (display_ != EGL_NO_DISPLAY) {
+                eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+                if (context_ != EGL_NO_CONTEXT) {
+                    eglDestroyContext(display_, context_);
+                }
+                if (surface_ != EGL_NO_SURFACE) {
+                    eglDestroySurface(display_, surface_);
+                }
+                eglTerminate(display_);
+            }
+        }
+
+        // @return: false if there is no display with an OpenGL ES 3 pbuffer context.
+        bool Create() {
+            if (!Initialize()) {
+                return false;
+            }
+            const EGLint config_attributes[] = {
+                    EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                    EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR,
+                    EGL_NONE};
+            EGLConfig config;
+            EGLint config_count = 0;
+            if (!eglChooseConfig(display_, config_attributes, &config, 1, &config_count) ||
+                config_count == 0 || !eglBindAPI(EGL_OPENGL_ES_API)) {
+                return false;
+            }
+            const EGLint surface_attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+            surface_ = eglCreatePbufferSurface(display_, config, surface_attributes);
+            const EGLint context_attributes[] = {EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE};
+            context_ = eglCreateContext(display_, config, EGL_NO_CONTEXT, context_attributes);
+            if (surface_ == EGL_NO_SURFACE || context_ == EGL_NO_CONTEXT ||
+                !eglMakeCurrent(display_, surface_, surface_, context_)) {
+                return false;
+            }
+            // depth reads of OpenGL ES need this extension, like on the device
+            const char *extensions = reinterpret_cast<const char *>(glGetString(GL_EXTENSIONS));
+            if (extensions == nullptr || strstr(extensions, "GL_NV_read_depth") == nullptr) {
+                fprintf(stderr, "GL_NV_read_depth is not supported\n");
+                return false;
+            }
+
+            glGenTextures(1, &depth_texture_);
+            glBindTexture(GL_TEXTURE_2D, depth_texture_);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT16, kWidth, kHeight, 0,
+                         GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, NULL);
+            glGenRenderbuffers(1, &color_buffer_);
+            glBindRenderbuffer(GL_RENDERBUFFER, color_buffer_);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, kWidth, kHeight);
+            glGenFramebuffers(1, &frame_buffer_);
+            glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+                                      color_buffer_);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
+                                   depth_texture_, 0);
+            bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            return complete && glGetError() == GL_NO_ERROR;
+        }
+
+        // clears the depth of frame, the lower left corner gets its own depth
+        void Render(int frame) {
+            glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_);
+            glViewport(0, 0, kWidth, kHeight);
+            glClearDepthf(BackgroundDepth(frame));
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(0, 0, kWidth / 2, kHeight / 3);
+            glClearDepthf(CornerDepth(frame));
+            glClear(GL_DEPTH_BUFFER_BIT);
+            glDisable(GL_SCISSOR_TEST);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+
+        GLuint GetFrameBuffer() const { return frame_buffer_; }
+
+    private:
+        EGLDisplay display_;
+        EGLSurface surface_;
+        EGLContext context_;
+        GLuint depth_texture_;
+        GLuint color_buffer_;
+        GLuint frame_buffer_;
+
+        // the default display, or Mesa's surfaceless one on hosts without a window system
+        bool Initialize() {
+            display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+            if (display_ != EGL_NO_DISPLAY && eglInitialize(display_, NULL, NULL)) {
+                return true;
+            }
+            display_ = EGL_NO_DISPLAY;
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+            PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+                    reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+            if (get_platform_display != nullptr) {
+                display_ = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                                EGL_DEFAULT_DISPLAY, NULL);
+                if (display_ != EGL_NO_DISPLAY && eglInitialize(display_, NULL, NULL)) {
+                    return true;
+                }
+                display_ = EGL_NO_DISPLAY;
+            }
+#endif
+            return false;
+        }
+    };
+
+    // target holds the depth of frame, rows start at the bottom like in GL
+    bool HoldsFrame(const cv::Mat &target, int frame) {
+        const int background = static_cast<int>(BackgroundDepth(frame) * 65535.0f + 0.5f);
+        const int corner = static_cast<int>(CornerDepth(frame) * 65535.0f + 0.5f);
+        for (int y = 0; y < kHeight; ++y) {
+            for (int x = 0; x < kWidth; ++x) {
+                bool in_corner = x < kWidth / 2 && y < kHeight / 3;
+                int expected = in_corner ? corner : background;
+                if (std::abs(target.at<unsigned short>(y, x) - expected) > 1) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void TestDoubleBuffering(OffscreenContext &context) {
+        DepthReadback readback(kWidth, kHeight, GL_UNSIGNED_SHORT);
+        cv::Mat target(kHeight, kWidth, CV_16UC1, cv::Scalar(0));
+        CHECK(!readback.Map(target));
+
+        // the first read is only mapped after the next one was queued
+        context.Render(0);
+        readback.Read(context.GetFrameBuffer());
+        glFinish();
+        CHECK(!readback.Map(target));
+        CHECK(cv::countNonZero(target) == 0);
+
+        context.Render(1);
+        readback.Read(context.GetFrameBuffer());
+        glFinish();
+        CHECK(readback.Map(target));
+        CHECK(HoldsFrame(target, 0));
+
+        // nothing new, the previous frame stays
+        CHECK(!readback.Map(target));
+        CHECK(HoldsFrame(target, 0));
+
+        context.Render(2);
+        readback.Read(context.GetFrameBuffer());
+        glFinish();
+        CHECK(readback.Map(target));
+        CHECK(HoldsFrame(target, 1));
+
+        // two reads without a map, the map gives the older one of both
+        context.Render(3);
+        readback.Read(context.GetFrameBuffer());
+        context.Render(4);
+        readback.Read(context.GetFrameBuffer());
+        glFinish();
+        CHECK(readback.Map(target));
+        CHECK(HoldsFrame(target, 3));
+        CHECK(glGetError() == GL_NO_ERROR);
+    }
+
+    void TestFenceWait(OffscreenContext &context) {
+        DepthReadback readback(kWidth, kHeight, GL_UNSIGNED_SHORT);
+        cv::Mat target(kHeight, kWidth, CV_16UC1, cv::Scalar(0));
+        context.Render(5);
+        readback.Read(context.GetFrameBuffer());
+        context.Render(6);
+        readback.Read(context.GetFrameBuffer());
+
+        // without glFinish the map only succeeds once the fence is signaled,
+        // until then the target keeps its data
+        glFlush();
+        bool mapped = false;
+        for (int i = 0; i < 1000 && !mapped; ++i) {
+            mapped = readback.Map(target);
+            if (!mapped) {
+                CHECK(cv::countNonZero(target) == 0);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        CHECK(mapped);
+        CHECK(HoldsFrame(target, 5));
+        CHECK(!readback.Map(target));
+        CHECK(HoldsFrame(target, 5));
+        CHECK(glGetError() == GL_NO_ERROR);
+    }
+}  // namespace
+
+int main() {
+    OffscreenContext context;
+    if (!context.Create()) {
+        fprintf(stderr, "depth_readback_test skipped, no OpenGL ES 3 context\n");
+        return kSkipped;
+    }
+    TestDoubleBuffering(context);
+    TestFenceWait(context);
+    if (test_failures == 0) {
+        fprintf(stderr, "depth_readback_test passed\n");
+    }
+    return test_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,175 @@
+// Grows a wavy surface frame by frame in a voxel accumulator and re-meshes only
+// the changed patches with construct-native's IncrementalTriangulation. The
+// patch-local mesh has to stay a manifold surface across the patch seams.
+
+#include "incrementaltriangulation.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <tuple>
+#include <vector>
+#include <Eigen/Core>
+
+#include "test_util.h"
+
+namespace {
+    // voxel and patch size of constructnative.cc
+    const float kLeafSize = 0.03f;
+    const int kPatchSize = 8;
+
+    // every frame covers a strip of the surface which overlaps the last one
+    const int kFrames = 6;
+    const int kFrameStep = 12;
+    const int kFrameWidth = 30;
+    const int kRows = 40;
+
+    typedef std::array<int, 3> Triangle;
+
+    void AddFrame(int frame, constructnative::VoxelAccumulator &accumulator) {
+        std::vector<float> points;
+        srand(frame + 1);
+        for (int i = frame * kFrameStep; i < frame * kFrameStep + kFrameWidth; ++i) {
+            for (int j = 0; j < kRows; ++j) {
+                float noise = (rand() % 1001 - 500) * 0.00001f;
+                points.push_back((i + 0.5f) * kLeafSize + noise);
+                points.push_back((j + 0.5f) * kLeafSize + noise);
+                points.push_back(0.05f * std::sin(i * 0.1f) + 0.03f * std::cos(j * 0.15f));
+            }
+        }
+        accumulator.addPoints(&points[0], points.size() / 3);
+    }
+
+    // gives the vertices of the mesh indices, vertices are voxel centroids, so
+    // equal coordinates are the same vertex
+    void IndexMesh(const std::vector<float> &mesh, std::vector<Eigen::Vector3f> &vertices,
+                   std::vector<Triangle> &triangles) {
+        std::map<std::tuple<float, float, float>, int> indices;
+        for (size_t i = 0; i + 8 < mesh.size(); i += 9) {
+            Triangle triangle;
+            for (int j = 0; j < 3; ++j) {
+                const float *point = &mesh[i + j * 3];
+                std::tuple<float, float, float> key(point[0], point[1], point[2]);
+                std::map<std::tuple<float, float, float>, int>::iterator index = indices.find(key);
+                if (index == indices.end()) {
+                    int next = vertices.size();
+                    index = indices.insert(std::make_pair(key, next)).first;
+                    vertices.push_back(Eigen::Vector3f(point[0], point[1], point[2]));
+                }
+                triangle[j] = index->second;
+            }
+            triangles.push_back(triangle);
+        }
+    }
+
+    // part of the offset from a to c perpendicular to the edge a, b
+    Eigen::Vector3f Perpendicular(const Eigen::Vector3f &a, const Eigen::Vector3f &b,
+                                  const Eigen::Vector3f &c) {
+        Eigen::Vector3f edge = b - a;
+        Eigen::Vector3f offset = c - a;
+        return offset - edge * (offset.dot(edge) / edge.squaredNorm());
+    }
+
+    // the surface is a height field, so triangles must not overlap seen from above.
+    // Counts the triangles over a grid of samples between the voxel centers.
+    void CheckNoOverlap(const std::vector<Eigen::Vector3f> &vertices,
+                        const std::vector<Triangle> &triangles) {
+        const float kSpacing = kLeafSize / 3.0f;
+        const float kOffset = kSpacing * 0.37f;
+        const int columns =
+                static_cast<int>((kFrames * kFrameStep + kFrameWidth) * kLeafSize / kSpacing);
+        const int rows = static_cast<int>(kRows * kLeafSize / kSpacing);
+        std::vector<int> coverage(columns * rows, 0);
+        for (size_t i = 0; i < triangles.size(); ++i) {
+            const Eigen::Vector3f &a = vertices[triangles[i][0]];
+            const Eigen::Vector3f &b = vertices[triangles[i][1]];
+            const Eigen::Vector3f &c = vertices[triangles[i][2]];
+            Eigen::Vector3f low = a.cwiseMin(b).cwiseMin(c);
+            Eigen::Vector3f high = a.cwiseMax(b).cwiseMax(c);
+            int x0 = std::max(0, static_cast<int>((low.x() - kOffset) / kSpacing));
+            int x1 = std::min(columns - 1, static_cast<int>((high.x() - kOffset) / kSpacing));
+            int y0 = std::max(0, static_cast<int>((low.y() - kOffset) / kSpacing));
+            int y1 = std::min(rows - 1, static_cast<int>((high.y() - kOffset) / kSpacing));
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    float sx = x * kSpacing + kOffset;
+                    float sy = y * kSpacing + kOffset;
+                    float ab = (b.x() - a.x()) * (sy - a.y()) - (b.y() - a.y()) * (sx - a.x());
+                    float bc = (c.x() - b.x()) * (sy - b.y()) - (c.y() - b.y()) * (sx - b.x());
+                    float ca = (a.x() - c.x()) * (sy - c.y()) - (a.y() - c.y()) * (sx - c.x());
+                    bool inside = (ab > 0.0f && bc > 0.0f && ca > 0.0f) ||
+                                  (ab < 0.0f && bc < 0.0f && ca < 0.0f);
+                    if (inside) {
+                        coverage[y * columns + x]++;
+                    }
+                }
+            }
+        }
+        int overlapping = 0;
+        for (size_t i = 0; i < coverage.size(); ++i) {
+            overlapping += coverage[i] > 1;
+        }
+        CHECK(overlapping == 0);
+    }
+
+    // no degenerate or duplicate triangles, at most two triangles per edge, the
+    // two triangles of an edge on its opposite sides and no overlaps
+    void CheckManifold(const std::vector<float> &mesh) {
+        std::vector<Eigen::Vector3f> vertices;
+        std::vector<Triangle> triangles;
+        IndexMesh(mesh, vertices, triangles);
+        CHECK(!triangles.empty());
+
+        std::set<Triangle> unique;
+        std::map<std::pair<int, int>, std::vector<int> > edges;
+        for (size_t i = 0; i < triangles.size(); ++i) {
+            Triangle sorted = triangles[i];
+            std::sort(sorted.begin(), sorted.end());
+            CHECK(sorted[0] != sorted[1] && sorted[1] != sorted[2]);
+            CHECK(unique.insert(sorted).second);
+            for (int j = 0; j < 3; ++j) {
+                int a = triangles[i][j];
+                int b = triangles[i][(j + 1) % 3];
+                edges[std::make_pair(std::min(a, b), std::max(a, b))].push_back(
+                        triangles[i][(j + 2) % 3]);
+            }
+        }
+        for (std::map<std::pair<int, int>, std::vector<int> >::const_iterator edge = edges.begin();
+             edge != edges.end(); ++edge) {
+            CHECK(edge->second.size() <= 2);
+            if (edge->second.size() == 2) {
+                const Eigen::Vector3f &a = vertices[edge->first.first];
+                const Eigen::Vector3f &b = vertices[edge->first.second];
+                CHECK(Perpendicular(a, b, vertices[edge->second[0]]).dot(
+                        Perpendicular(a, b, vertices[edge->second[1]])) < 0.0f);
+            }
+        }
+        CheckNoOverlap(vertices, triangles);
+    }
+
+    void TestIncrementalSeams() {
+        constructnative::VoxelAccumulator accumulator(kLeafSize);
+        constructnative::IncrementalTriangulation triangulation(kPatchSize);
+        std::vector<float> mesh;
+        for (int frame = 0; frame < kFrames; ++frame) {
+            AddFrame(frame, accumulator);
+            triangulation.update(accumulator, mesh);
+            CheckManifold(mesh);
+        }
+        // a frame without new points keeps the mesh
+        std::vector<float> unchanged;
+        triangulation.update(accumulator, unchanged);
+        CHECK(unchanged == mesh);
+    }
+}  // namespace
+
+int main() {
+    TestIncrementalSeams();
+    if (test_failures == 0) {
+        fprintf(stderr, "incremental_triangulation_test passed\n");
+    }
+    return test_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
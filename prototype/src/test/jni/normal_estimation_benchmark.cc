@@ -0,0 +1,101 @@
+// Times the normal estimation of construct-native's estimateNormals on noisy
+// wavy surfaces of 10k to 1M points, sequential and with the OpenMP version on
+// 2, 4 and all hardware threads. Both share one search index like the app.
+
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+#include <pcl/search/kdtree.h>
+#include <pcl/features/normal_3d.h>
+#include <pcl/features/normal_3d_omp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+    // neighbours of a normal in triangulateWithNormals
+    const int kSearch = 10;
+    const int kCloudSizes[] = {10000, 100000, 1000000};
+
+    typedef pcl::PointCloud<pcl::PointNormal> Cloud;
+
+    Cloud::Ptr CreateCloud(int size) {
+        Cloud::Ptr cloud(new Cloud);
+        cloud->points.resize(size);
+        cloud->width = size;
+        cloud->height = 1;
+        srand(42);
+        // constant density, a point every 5 mm like the downsampled app clouds
+        int side = static_cast<int>(std::sqrt(static_cast<float>(size)));
+        for (int i = 0; i < size; ++i) {
+            float x = (i % side) * 0.005f;
+            float y = (i / side) * 0.005f;
+            float noise = (rand() % 1001 - 500) * 0.000002f;
+            cloud->points[i].x = x;
+            cloud->points[i].y = y;
+            cloud->points[i].z = 0.1f * std::sin(x * 4.0f) * std::cos(y * 3.0f) + noise;
+        }
+        return cloud;
+    }
+
+    double Milliseconds(std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - since).count();
+    }
+
+    // @return: time of one estimation over cloud in milliseconds.
+    double TimeEstimation(const Cloud::Ptr cloud,
+                          const pcl::search::KdTree<pcl::PointNormal>::Ptr tree,
+                          int threads) {
+        pcl::PointCloud<pcl::Normal> normals;
+        std::chrono::steady_clock::time_point before = std::chrono::steady_clock::now();
+        if (threads > 1) {
+            pcl::NormalEstimationOMP<pcl::PointNormal, pcl::Normal> n(threads);
+            n.setInputCloud(cloud);
+            n.setSearchMethod(tree);
+            n.setKSearch(kSearch);
+            n.compute(normals);
+        } else {
+            pcl::NormalEstimation<pcl::PointNormal, pcl::Normal> n;
+            n.setInputCloud(cloud);
+            n.setSearchMethod(tree);
+            n.setKSearch(kSearch);
+            n.compute(normals);
+        }
+        return Milliseconds(before);
+    }
+}  // namespace
+
+int main() {
+    int hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> thread_counts;
+    thread_counts.push_back(1);
+    for (int threads = 2; threads < hardware_threads && threads <= 4; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    if (hardware_threads > 1) {
+        thread_counts.push_back(hardware_threads);
+    }
+
+    printf("%10s %8s %12s %8s\n", "points", "threads", "ms", "speedup");
+    for (size_t i = 0; i < sizeof(kCloudSizes) / sizeof(kCloudSizes[0]); ++i) {
+        Cloud::Ptr cloud = CreateCloud(kCloudSizes[i]);
+        pcl::search::KdTree<pcl::PointNormal>::Ptr tree(new pcl::search::KdTree<pcl::PointNormal>);
+        tree->setInputCloud(cloud);
+
+        double sequential_ms = 0.0;
+        for (size_t j = 0; j < thread_counts.size(); ++j) {
+            double ms = TimeEstimation(cloud, tree, thread_counts[j]);
+            if (thread_counts[j] == 1) {
+                sequential_ms = ms;
+            }
+            printf("%10d %8d %12.1f %8.2f\n", kCloudSizes[i], thread_counts[j], ms,
+                   sequential_ms / ms);
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,238 @@
+// Triangulates plane polygons with and without holes with construct-native's
+// triangulatePolygon and checks the triangle count, the covered area, the
+// winding, the ring edges and the Delaunay property of the flipped result.
+
+#include "polygontriangulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "test_util.h"
+
+using constructnative::Polygon2D;
+
+namespace {
+    const double kPi = 3.14159265358979323846;
+
+    void AddRing(const std::vector<float> &ring, Polygon2D &polygon) {
+        polygon.points.insert(polygon.points.end(), ring.begin(), ring.end());
+        polygon.ringSizes.push_back(static_cast<int>(ring.size() / 2));
+    }
+
+    // regular polygon, counter clockwise unless clockwise is set
+    std::vector<float> Circle(float cx, float cy, float radius, int count, bool clockwise) {
+        std::vector<float> ring;
+        for (int i = 0; i < count; ++i) {
+            double angle = 2.0 * kPi * (clockwise ? count - i : i) / count;
+            ring.push_back(cx + radius * static_cast<float>(std::cos(angle)));
+            ring.push_back(cy + radius * static_cast<float>(std::sin(angle)));
+        }
+        return ring;
+    }
+
+    // star shaped polygon with random radii between inner and outer
+    std::vector<float> Star(int count, float inner, float outer) {
+        std::vector<float> ring;
+        for (int i = 0; i < count; ++i) {
+            double angle = 2.0 * kPi * i / count;
+            float radius = inner + (outer - inner) * (rand() % 1001) / 1000.0f;
+            ring.push_back(radius * static_cast<float>(std::cos(angle)));
+            ring.push_back(radius * static_cast<float>(std::sin(angle)));
+        }
+        return ring;
+    }
+
+    // twice the signed area of the triangle a, b, c
+    double Area(const float *points, int a, int b, int c) {
+        return (static_cast<double>(points[b * 2]) - points[a * 2]) *
+               (static_cast<double>(points[c * 2 + 1]) - points[a * 2 + 1]) -
+               (static_cast<double>(points[b * 2 + 1]) - points[a * 2 + 1]) *
+               (static_cast<double>(points[c * 2]) - points[a * 2]);
+    }
+
+    // absolute area of every ring, the holes are subtracted from the outline
+    double PolygonArea(const Polygon2D &polygon) {
+        double area = 0.0;
+        for (size_t ring = 0, first = 0; ring < polygon.ringSizes.size(); ++ring) {
+            int size = polygon.ringSizes[ring];
+            double ringArea = 0.0;
+            for (int i = 0; i < size; ++i) {
+                ringArea += Area(&polygon.points[0], first, first + i, first + (i + 1) % size);
+            }
+            area += (ring == 0 ? 0.5 : -0.5) * std::fabs(ringArea);
+            first += size;
+        }
+        return area;
+    }
+
+    uint64_t EdgeKey(int a, int b) {
+        return static_cast<uint64_t>(std::min(a, b)) << 32 | static_cast<uint32_t>(std::max(a, b));
+    }
+
+    // d lies strictly within the circumcircle of the counter clockwise a, b, c
+    bool InCircumcircle(const float *points, int a, int b, int c, int d, double tolerance) {
+        double adx = points[a * 2] - points[d * 2], ady = points[a * 2 + 1] - points[d * 2 + 1];
+        double bdx = points[b * 2] - points[d * 2], bdy = points[b * 2 + 1] - points[d * 2 + 1];
+        double cdx = points[c * 2] - points[d * 2], cdy = points[c * 2 + 1] - points[d * 2 + 1];
+        double inCircle = (adx * adx + ady * ady) * (bdx * cdy - cdx * bdy) -
+                          (bdx * bdx + bdy * bdy) * (adx * cdy - cdx * ady) +
+                          (cdx * cdx + cdy * cdy) * (adx * bdy - bdx * ady);
+        return inCircle > tolerance;
+    }
+
+    // n + 2h - 2 counter clockwise triangles covering the polygon area, every
+    // ring edge belongs to one triangle and every other edge to two, which are
+    // constrained Delaunay
+    void CheckTriangulation(const Polygon2D &polygon, const std::vector<int> &triangles) {
+        const float *points = &polygon.points[0];
+        int vertices = static_cast<int>(polygon.points.size() / 2);
+        int holes = static_cast<int>(polygon.ringSizes.size()) - 1;
+        CHECK(triangles.size() % 3 == 0);
+        CHECK(static_cast<int>(triangles.size() / 3) == vertices + 2 * holes - 2);
+
+        double area = 0.0;
+        std::map<uint64_t, std::vector<int> > edges;
+        for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+            double triangleArea = Area(points, triangles[t], triangles[t + 1], triangles[t + 2]);
+            CHECK(triangleArea > 0.0);
+            area += 0.5 * triangleArea;
+            for (int i = 0; i < 3; ++i) {
+                CHECK(triangles[t + i] >= 0 && triangles[t + i] < vertices);
+                edges[EdgeKey(triangles[t + i], triangles[t + (i + 1) % 3])].push_back(t / 3);
+            }
+        }
+        double expected = PolygonArea(polygon);
+        CHECK(std::fabs(area - expected) <= 1e-4 * expected);
+
+        std::set<uint64_t> constrained;
+        for (size_t ring = 0, first = 0; ring < polygon.ringSizes.size(); ++ring) {
+            int size = polygon.ringSizes[ring];
+            for (int i = 0; i < size; ++i) {
+                uint64_t key = EdgeKey(first + i, first + (i + 1) % size);
+                constrained.insert(key);
+                CHECK(edges.count(key) && edges[key].size() == 1);
+            }
+            first += size;
+        }
+
+        float low[2] = {points[0], points[1]}, high[2] = {points[0], points[1]};
+        for (size_t i = 0; i < polygon.points.size(); ++i) {
+            low[i % 2] = std::min(low[i % 2], points[i]);
+            high[i % 2] = std::max(high[i % 2], points[i]);
+        }
+        double scale = std::max(high[0] - low[0], high[1] - low[1]);
+        double tolerance = 1e-8 * scale * scale * scale * scale;
+        for (std::map<uint64_t, std::vector<int> >::const_iterator edge = edges.begin();
+             edge != edges.end(); ++edge) {
+            if (constrained.count(edge->first)) {
+                continue;
+            }
+            CHECK(edge->second.size() == 2);
+            if (edge->second.size() != 2) {
+                continue;
+            }
+            const int *first = &triangles[edge->second[0] * 3];
+            const int *second = &triangles[edge->second[1] * 3];
+            int a = static_cast<int>(edge->first >> 32);
+            int b = static_cast<int>(edge->first & 0xffffffff);
+            int opposite = second[0] + second[1] + second[2] - a - b;
+            CHECK(!InCircumcircle(points, first[0], first[1], first[2], opposite, tolerance));
+        }
+    }
+
+    void TestConcave() {
+        // comb with three teeth, clockwise input
+        const float comb[] = {0, 0, 0, 3, 1, 3, 1, 1, 2, 1, 2, 3, 3, 3, 3, 1, 4, 1, 4, 3,
+                              5, 3, 5, 0};
+        Polygon2D polygon;
+        AddRing(std::vector<float>(comb, comb + sizeof(comb) / sizeof(comb[0])), polygon);
+        std::vector<int> triangles;
+        CHECK(triangulatePolygon(polygon, triangles));
+        CheckTriangulation(polygon, triangles);
+    }
+
+    void TestHoles() {
+        // square with a square hole, both counter clockwise
+        Polygon2D square;
+        AddRing(Circle(0.0f, 0.0f, 2.0f, 4, false), square);
+        AddRing(Circle(0.0f, 0.0f, 1.0f, 4, false), square);
+        std::vector<int> triangles;
+        CHECK(triangulatePolygon(square, triangles));
+        CheckTriangulation(square, triangles);
+
+        // fine circle with three holes of either orientation
+        Polygon2D circle;
+        AddRing(Circle(0.0f, 0.0f, 5.0f, 64, true), circle);
+        AddRing(Circle(-2.5f, 0.0f, 1.0f, 12, false), circle);
+        AddRing(Circle(0.5f, 2.0f, 0.8f, 9, true), circle);
+        AddRing(Circle(1.5f, -1.5f, 1.2f, 16, false), circle);
+        CHECK(triangulatePolygon(circle, triangles));
+        CheckTriangulation(circle, triangles);
+    }
+
+    void TestRandomPolygons() {
+        srand(7);
+        std::vector<Polygon2D> polygons;
+        for (int i = 0; i < 50; ++i) {
+            Polygon2D polygon;
+            AddRing(Star(20 + rand() % 200, 3.0f, 4.0f), polygon);
+            int holes = rand() % 4;
+            for (int h = 0; h < holes; ++h) {
+                // holes on a circle within the inner radius never touch
+                double angle = 2.0 * kPi * h / 4;
+                AddRing(Circle(1.5f * static_cast<float>(std::cos(angle)),
+                               1.5f * static_cast<float>(std::sin(angle)), 0.6f,
+                               3 + rand() % 20, rand() % 2 == 0), polygon);
+            }
+            polygons.push_back(polygon);
+        }
+
+        // the batch gives the same triangles as every polygon on its own
+        std::vector<std::vector<int> > batch;
+        CHECK(constructnative::triangulatePolygons(polygons, batch) ==
+              static_cast<int>(polygons.size()));
+        CHECK(batch.size() == polygons.size());
+        for (size_t i = 0; i < polygons.size(); ++i) {
+            std::vector<int> triangles;
+            CHECK(triangulatePolygon(polygons[i], triangles));
+            CHECK(triangles == batch[i]);
+            CheckTriangulation(polygons[i], triangles);
+        }
+    }
+
+    void TestInvalid() {
+        std::vector<int> triangles;
+        Polygon2D empty;
+        CHECK(!triangulatePolygon(empty, triangles));
+
+        // ring sizes which do not match the points
+        Polygon2D mismatched;
+        AddRing(Circle(0.0f, 0.0f, 1.0f, 5, false), mismatched);
+        mismatched.ringSizes[0] = 6;
+        CHECK(!triangulatePolygon(mismatched, triangles));
+        CHECK(triangles.empty());
+
+        // collinear outline
+        const float line[] = {0, 0, 1, 1, 2, 2};
+        Polygon2D collinear;
+        AddRing(std::vector<float>(line, line + 6), collinear);
+        CHECK(!triangulatePolygon(collinear, triangles));
+    }
+}  // namespace
+
+int main() {
+    TestConcave();
+    TestHoles();
+    TestRandomPolygons();
+    TestInvalid();
+    if (test_failures == 0) {
+        fprintf(stderr, "polygon_triangulation_test passed\n");
+    }
+    return test_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,217 @@
+// Drives the QualityController with simulated frame timings. The simulated
+// pipeline gets cheaper with every quality level the controller gives up, so
+// the controller sees the effect of its own changes like on the device.
+
+#include "tango-augmented-reality/quality_controller.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "test_util.h"
+
+using tango_augmented_reality::kQualityLevelCount;
+using tango_augmented_reality::kQualityLevels;
+using tango_augmented_reality::QualityController;
+using tango_augmented_reality::QualitySettings;
+using tango_augmented_reality::QualityStage;
+using tango_augmented_reality::STAGE_CAMERA;
+using tango_augmented_reality::STAGE_COUNT;
+using tango_augmented_reality::STAGE_FILTER;
+using tango_augmented_reality::STAGE_OCCLUSION;
+using tango_augmented_reality::STAGE_RECONSTRUCTION;
+
+namespace {
+    const float kTargetFrameMs = 33.0f;
+
+    // settle frames of quality_controller.cc
+    const int kLowerSettleFrames = 15;
+    const int kRaiseSettleFrames = 60;
+    const int kMaxRaiseSettleFrames = 480;
+
+    // stage times at the highest quality and normal load
+    const float kStageMs[STAGE_COUNT] = {3.0f, 12.0f, 5.0f, 6.0f};
+    // time which does not depend on the quality
+    const float kOverheadMs = 2.0f;
+    // stage time at each quality level relative to the highest quality
+    const float kLevelCost[kQualityLevelCount] = {1.0f, 0.6f, 0.4f};
+
+    // change of the quality of one stage
+    struct Transition {
+        int frame;
+        int stage;
+        // +1 if the stage got lowered, -1 if it got raised
+        int step;
+    };
+
+    // the settings have to hold the parameters of the current levels
+    void CheckSettings(const QualityController &controller) {
+        const QualitySettings &settings = controller.GetSettings();
+        CHECK(settings.skip_interval ==
+              kQualityLevels.skip_intervals[controller.GetLevel(STAGE_CAMERA)]);
+        CHECK(settings.ransac_iteration_limit ==
+              kQualityLevels.ransac_iteration_limits[controller.GetLevel(STAGE_RECONSTRUCTION)]);
+        CHECK(settings.occlusion_scale ==
+              kQualityLevels.occlusion_scales[controller.GetLevel(STAGE_OCCLUSION)]);
+        CHECK(settings.filter_diameter_scale ==
+              kQualityLevels.filter_diameter_scales[controller.GetLevel(STAGE_FILTER)]);
+    }
+
+    // simulated pipeline, loads scale the stage times of the frames
+    class Simulation {
+    public:
+        Simulation() : controller_(kTargetFrameMs), frame_(0) {
+            for (int i = 0; i < STAGE_COUNT; ++i) {
+                levels_[i] = 0;
+            }
+        }
+
+        // runs frames with the given load and records all level changes
+        //
+        // @return: average simulated frame time of the run.
+        float Run(int frames, float load) {
+            float total_ms = 0.0f;
+            for (int i = 0; i < frames; ++i, ++frame_) {
+                float stage_ms[STAGE_COUNT];
+                float frame_ms = kOverheadMs;
+                for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+                    stage_ms[stage] = kStageMs[stage] * load * kLevelCost[levels_[stage]];
+                    frame_ms += stage_ms[stage];
+                }
+                total_ms += frame_ms;
+
+                bool changed = controller_.Update(stage_ms, frame_ms);
+                CheckSettings(controller_);
+                int changes = 0;
+                for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+                    int level = controller_.GetLevel(static_cast<QualityStage>(stage));
+                    CHECK(level >= 0 && level < kQualityLevelCount);
+                    if (level != levels_[stage]) {
+                        Transition transition = {frame_, stage, level - levels_[stage]};
+                        CHECK(transition.step == 1 || transition.step == -1);
+                        transitions_.push_back(transition);
+                        levels_[stage] = level;
+                        changes++;
+                    }
+                }
+                // one stage per update, reported by the return value
+                CHECK(changes == (changed ? 1 : 0));
+            }
+            return total_ms / frames;
+        }
+
+        const std::vector<Transition> &GetTransitions() const { return transitions_; }
+
+        int GetLevel(int stage) const { return levels_[stage]; }
+
+        int GetFrame() const { return frame_; }
+
+    private:
+        QualityController controller_;
+        int levels_[STAGE_COUNT];
+        int frame_;
+        std::vector<Transition> transitions_;
+    };
+
+    // every change waits for the settle frames of its direction after the last one
+    void CheckSettled(const std::vector<Transition> &transitions) {
+        for (size_t i = 1; i < transitions.size(); ++i) {
+            int frames = transitions[i].frame - transitions[i - 1].frame;
+            if (transitions[i].step > 0) {
+                CHECK(frames >= kLowerSettleFrames);
+            } else {
+                CHECK(frames >= kRaiseSettleFrames);
+            }
+        }
+    }
+
+    void TestSustainedOverload() {
+        Simulation simulation;
+        // twice the normal load, 55 ms at the highest quality
+        simulation.Run(600, 2.0f);
+        const std::vector<Transition> &transitions = simulation.GetTransitions();
+        CheckSettled(transitions);
+
+        // the first step waits for the settle frames and takes the most expensive stage
+        CHECK(!transitions.empty());
+        if (!transitions.empty()) {
+            CHECK(transitions[0].frame == kLowerSettleFrames - 1);
+            CHECK(transitions[0].stage == STAGE_RECONSTRUCTION);
+        }
+        // only lowering while overloaded
+        for (size_t i = 0; i < transitions.size(); ++i) {
+            CHECK(transitions[i].step == 1);
+        }
+        CHECK(simulation.GetLevel(STAGE_RECONSTRUCTION) == 2);
+
+        // the lowered pipeline holds the target, so no further changes happen
+        size_t settled_transitions = transitions.size();
+        float frame_ms = simulation.Run(300, 2.0f);
+        CHECK(frame_ms <= kTargetFrameMs);
+        CHECK(transitions.size() == settled_transitions);
+    }
+
+    void TestRecovery() {
+        Simulation simulation;
+        simulation.Run(600, 2.0f);
+        std::vector<Transition> lowered = simulation.GetTransitions();
+        CHECK(lowered.size() >= 2);
+        int recovery_frame = simulation.GetFrame();
+
+        // light load, every level is given back
+        simulation.Run(1200, 0.8f);
+        const std::vector<Transition> &transitions = simulation.GetTransitions();
+        CheckSettled(transitions);
+        CHECK(transitions.size() == lowered.size() * 2);
+        for (size_t i = lowered.size(); i < transitions.size(); ++i) {
+            CHECK(transitions[i].frame >= recovery_frame);
+            CHECK(transitions[i].step == -1);
+            // raising undoes the lowered stages in reverse order
+            CHECK(transitions[i].stage == lowered[lowered.size() * 2 - 1 - i].stage);
+        }
+        for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+            CHECK(simulation.GetLevel(stage) == 0);
+        }
+    }
+
+    void TestOscillatingSpikes() {
+        // short spikes over a normal load, the averages absorb them
+        Simulation spikes;
+        for (int i = 0; i < 40; ++i) {
+            spikes.Run(18, 1.0f);
+            spikes.Run(2, 1.6f);
+        }
+        CHECK(spikes.GetTransitions().empty());
+
+        // load swinging between overload and light every 40 frames, each raise gets
+        // undone by the next overload, so the controller waits longer for every raise
+        Simulation swings;
+        for (int i = 0; i < 20; ++i) {
+            swings.Run(40, 1.8f);
+            swings.Run(40, 0.6f);
+        }
+        const std::vector<Transition> &transitions = swings.GetTransitions();
+        CheckSettled(transitions);
+        int raises = 0;
+        for (size_t i = 1; i < transitions.size(); ++i) {
+            if (transitions[i].step < 0) {
+                int wait = std::min(kRaiseSettleFrames << raises, kMaxRaiseSettleFrames);
+                CHECK(transitions[i].frame - transitions[i - 1].frame >= wait);
+                raises++;
+            }
+        }
+        CHECK(raises >= 2);
+        // far fewer changes than swings
+        CHECK(transitions.size() <= 12);
+    }
+}  // namespace
+
+int main() {
+    TestSustainedOverload();
+    TestRecovery();
+    TestOscillatingSpikes();
+    if (test_failures == 0) {
+        fprintf(stderr, "quality_controller_test passed\n");
+    }
+    return test_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
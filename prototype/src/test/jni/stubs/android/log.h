@@ -0,0 +1,18 @@
+#ifndef ANDROID_LOG_H_
+#define ANDROID_LOG_H_
+
+// Host replacement of the NDK log header, so native sources can be built into
+// the host tests. Log output goes to stderr.
+
+#include <stdio.h>
+
+#define ANDROID_LOG_VERBOSE 2
+#define ANDROID_LOG_DEBUG 3
+#define ANDROID_LOG_INFO 4
+#define ANDROID_LOG_WARN 5
+#define ANDROID_LOG_ERROR 6
+
+#define __android_log_print(priority, tag, ...) \
+    (fprintf(stderr, "%s: ", tag), fprintf(stderr, __VA_ARGS__), fprintf(stderr, "\n"))
+
+#endif  // ANDROID_LOG_H_
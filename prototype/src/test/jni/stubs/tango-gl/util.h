@@ -0,0 +1,20 @@
+#ifndef TANGO_GL_UTIL_H_
+#define TANGO_GL_UTIL_H_
+
+// Host replacement of the GL error check of tango-gl, so native GL sources can
+// be built into the host tests without the rest of tango-gl.
+
+#include <GLES3/gl3.h>
+#include <stdio.h>
+
+namespace tango_gl {
+    namespace util {
+        inline void CheckGlError(const char *operation) {
+            for (GLenum error = glGetError(); error != GL_NO_ERROR; error = glGetError()) {
+                fprintf(stderr, "after %s glError (0x%x)\n", operation, error);
+            }
+        }
+    }  // namespace util
+}  // namespace tango_gl
+
+#endif  // TANGO_GL_UTIL_H_
@@ -0,0 +1,18 @@
+#ifndef TANGO_AUGMENTED_REALITY_TEST_UTIL_H_
+#define TANGO_AUGMENTED_REALITY_TEST_UTIL_H_
+
+#include <stdio.h>
+
+// failed checks are counted in test_failures, main returns it
+static int test_failures = 0;
+
+#define CHECK(condition)                                                   \
+    do {                                                                   \
+        if (!(condition)) {                                                \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+                    #condition);                                           \
+            test_failures++;                                               \
+        }                                                                  \
+    } while (0)
+
+#endif  // TANGO_AUGMENTED_REALITY_TEST_UTIL_H_